@@ -6,50 +6,57 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <numeric>
 #include <string>
 #include <thread>
 
+#include "gradstudent/data.h"
 #include "gradstudent/ops.h"
 #include "gradstudent/utils.h"
 
 const size_t img_dim = 28;
 const size_t num_examples = 10000;
+const size_t batch_size = 500;
 
 const size_t mnist_labels_header_size = 8;
 const size_t mnist_images_header_size = 16;
 
-gs::Tensor read_mnist_labels(const std::filesystem::path &path) {
-  std::ifstream file(path, std::ios::binary | std::ios::in);
-  file.ignore(mnist_labels_header_size);
-  return gs::parse_numpy_data<unsigned char>(gs::array_t{num_examples}, file);
-}
-
-gs::Tensor read_mnist_images(const std::filesystem::path &path) {
-  std::ifstream file(path, std::ios::binary | std::ios::in);
-  file.ignore(mnist_images_header_size);
-  return gs::parse_numpy_data<unsigned char>(
-      gs::array_t{num_examples, img_dim, img_dim, 1}, file);
-}
-
-std::pair<gs::Tensor, gs::Tensor>
-load_mnist(const std::filesystem::path &path) {
-  auto labels_path = path / "t10k-labels-idx1-ubyte";
-  auto images_path = path / "t10k-images-idx3-ubyte";
-
-  auto labels = read_mnist_labels(labels_path);
-  auto images = read_mnist_images(images_path);
-
-  images = (1. / 255.) * images;  // NOLINT
-  images = 2 * (images - 0.5);  // NOLINT
+// Reads the images and labels of a batch from the MNIST files, scaling pixels
+// from [0, 255] to [-1, 1]
+void read_mnist_batch(const std::filesystem::path &path,
+                      gs::data::Batch &batch) {
+  const size_t image_size = img_dim * img_dim;
+  std::vector<char> bytes(batch.size() * image_size);
+
+  std::ifstream labels_file(path / "t10k-labels-idx1-ubyte",
+                            std::ios::binary | std::ios::in);
+  labels_file.seekg(mnist_labels_header_size + batch.begin());
+  labels_file.read(bytes.data(), batch.size());
+  gs::Tensor labels = batch[1];
+  for (size_t i = 0; i < batch.size(); ++i) {
+    labels[i] = static_cast<unsigned char>(bytes[i]);
+  }
 
-  return {labels, images};
+  std::ifstream images_file(path / "t10k-images-idx3-ubyte",
+                            std::ios::binary | std::ios::in);
+  images_file.seekg(mnist_images_header_size + batch.begin() * image_size);
+  images_file.read(bytes.data(), bytes.size());
+  if (!labels_file || !images_file) {
+    throw std::runtime_error("Cannot read MNIST data from " + path.string());
+  }
+  gs::Tensor images = batch[0].reshape({bytes.size()});
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    images[i] = static_cast<unsigned char>(bytes[i]) * (2. / 255.) - 1.;
+  }
 }
 
 std::map<std::string, gs::Tensor>
 load_weights(const std::filesystem::path &path) {
   std::map<std::string, gs::Tensor> weights;
 
-  // TODO: get the shapes right
+  // The model runs in NHWC layout, so convolution kernels are stored as
+  // (f, kh, kw, c) and the columns of fc1 are reordered from the (c, h, w)
+  // order in which PyTorch flattens its input to (h, w, c) order.
   weights.insert(
       {"conv1.weight",
        gs::permute(gs::read_numpy(path / "conv1.weight.npy"), {0, 2, 3, 1})});
@@ -58,7 +65,10 @@ load_weights(const std::filesystem::path &path) {
       {"conv2.weight",
        gs::permute(gs::read_numpy(path / "conv2.weight.npy"), {0, 2, 3, 1})});
   weights.insert({"conv2.bias", gs::read_numpy(path / "conv2.bias.npy")});
-  weights.insert({"fc1.weight", gs::read_numpy(path / "fc1.weight.npy")});
+  const auto fc1 =
+      gs::read_numpy(path / "fc1.weight.npy").reshape({120, 16, 4, 4});
+  weights.insert(
+      {"fc1.weight", gs::permute(fc1, {0, 2, 3, 1}).reshape({120, 256})});
   weights.insert({"fc1.bias", gs::read_numpy(path / "fc1.bias.npy")});
   weights.insert({"fc2.weight", gs::read_numpy(path / "fc2.weight.npy")});
   weights.insert({"fc2.bias", gs::read_numpy(path / "fc2.bias.npy")});
@@ -73,22 +83,11 @@ public:
   InferenceRunner(const std::map<std::string, gs::Tensor> &weights)
       : weights_(weights) {}
 
-  gs::Tensor conv(const gs::Tensor &x, size_t i) {
+  gs::Tensor conv_block(const gs::Tensor &x, size_t i) {
     const auto &w = weights_.at("conv" + std::to_string(i) + ".weight");
     const auto &b = weights_.at("conv" + std::to_string(i) + ".bias");
-    const auto &x1 = gs::conv(x, w, 2);
-    const auto &x2 = gs::permute(x1, {1, 2, 0});
-    const auto &x3 = x2 + b;
-    return x3;
-  }
-
-  gs::Tensor conv_block(const gs::Tensor &x, size_t i) {
-    const auto &x1 = conv(x, i);
-    const auto &x2 = gs::relu(x1);
-    const auto &x3 = gs::permute(x2, {2, 0, 1});
-    const auto &x4 = gs::maxPool(x3, {2, 2});
-    const auto &x5 = gs::permute(x4, {1, 2, 0});
-    return x5;
+    return gs::convBlock(
+        x, w, b, {gs::Activation::RELU, gs::PoolType::MAX, {2, 2}});
   }
 
   gs::Tensor fc(const gs::Tensor &x, size_t i) {
@@ -103,7 +102,7 @@ public:
     const auto &x0 = input;
     const auto &x1 = conv_block(x0, 1);
     const auto &x2 = conv_block(x1, 2);
-    const auto &x3 = gs::flatten(gs::permute(x2, {2, 0, 1}));
+    const auto &x3 = gs::flatten(x2);
     const auto &x4 = fc(x3, 1);
     const auto &x5 = fc(x4, 2);
     const auto &x6 = fc(x5, 3);
@@ -121,19 +120,21 @@ public:
     gs::Tensor result(gs::array_t{n});
 
     size_t workload = std::ceil(static_cast<float>(n) / num_workers);
-    std::vector<size_t> chunks(num_workers, 0);
-    for (size_t i = 0; i < num_workers; ++i) {
-      chunks.insert(chunks.begin(), i);
+    std::vector<size_t> sizes;
+    for (size_t begin = 0; begin < n; begin += workload) {
+      sizes.push_back(std::min(workload, n - begin));
     }
+    std::vector<size_t> chunks(sizes.size());
+    std::iota(chunks.begin(), chunks.end(), 0);
+
+    // each worker writes its predictions straight into its part of the result
+    auto inputs = gs::split(input, sizes, 0);
+    auto outputs = gs::split(result, sizes, 0);
     std::for_each(std::execution::par, std::begin(chunks), std::end(chunks),
                   [&](size_t i) {
-                    auto in = gs::truncate(input, {i * workload},
-                                           {std::min((i + 1) * workload, n)});
-                    auto res = gs::truncate(result, {i * workload},
-                                            {std::min((i + 1) * workload, n)});
-                    for (size_t i = 0; i < in.shape()[0]; ++i) {
-                      slice(res, {i}) =
-                          static_cast<double>(infer(slice(in, {i})));
+                    for (size_t j = 0; j < sizes[i]; ++j) {
+                      slice(outputs[i], {j}) =
+                          static_cast<double>(infer(slice(inputs[i], {j})));
                     }
                   });
 
@@ -144,7 +145,7 @@ private:
   std::map<std::string, gs::Tensor> weights_;
 };
 
-double accuracy(const gs::Tensor &preds, const gs::Tensor &labels) {
+size_t count_correct(const gs::Tensor &preds, const gs::Tensor &labels) {
   size_t n = preds.shape()[0];
   size_t correct = 0;
   for (size_t i = 0; i < n; ++i) {
@@ -152,7 +153,7 @@ double accuracy(const gs::Tensor &preds, const gs::Tensor &labels) {
       ++correct;
     }
   }
-  return static_cast<double>(correct) / n;
+  return correct;
 }
 
 int main(int argc, char **argv) {
@@ -171,27 +172,36 @@ int main(int argc, char **argv) {
     std::cerr << "Error loading weights from " << weights_path << '\n';
   }
 
-  std::cout << "Loading data\n";
   // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  std::string data_path(argv[2]);
-  auto data = load_mnist(data_path);
-
-  std::cout << "Running inference\n";
+  std::filesystem::path data_path(argv[2]);
   size_t num_workers = 0;
   if (argc > 3) {
     // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
     num_workers = std::stoi(argv[3]);
   }
+
+  // batches are read and normalized in the background during inference
+  std::cout << "Running inference\n";
+  gs::data::DataLoader loader(
+      num_examples, {{img_dim, img_dim, 1}, {}},
+      [&](gs::data::Batch &batch) { read_mnist_batch(data_path, batch); },
+      {batch_size, 1, 2});
   auto runner = InferenceRunner(weights);
-  std::unique_ptr<gs::Tensor> preds;
+  size_t correct = 0;
   try {
-    *preds = runner.run_inference(data.second, num_workers);
+    for (size_t b = 0; b < loader.batches(); ++b) {
+      const gs::data::Batch &batch = loader.next();
+      const auto preds = runner.run_inference(batch[0], num_workers);
+      correct += count_correct(preds, batch[1]);
+    }
   } catch (const std::exception &e) {
-    std::cerr << "Error running inference";
+    std::cerr << "Error running inference: " << e.what() << '\n';
+    return 1;
   }
 
   std::cout << "Computing accuracy\n";
-  std::cout << "Accuracy: " << accuracy(*preds, data.first) << '\n';
+  std::cout << "Accuracy: "
+            << static_cast<double>(correct) / num_examples << '\n';
 
   return 0;
 }
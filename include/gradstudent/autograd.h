@@ -0,0 +1,407 @@
+/**
+ * @file autograd.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Reverse-mode automatic differentiation
+ * @version 0.1
+ * @date 2024-05-27
+ *
+ * @copyright Copyright (c) 2024
+ *
+ * Operations on Var handles compute their result with the corresponding
+ * operation from ops.h and record it on a Tape, from which Tape::backward
+ * computes gradients. Plain Tensor operations are unaffected, so inference
+ * code pays nothing for gradient support.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+
+namespace gs {
+namespace ad {
+
+struct Node;
+class Tape;
+
+/**
+ * @brief Bump allocator for objects with a common lifetime
+ *
+ * Memory is carved sequentially out of large blocks and released all at once
+ * by reset, which keeps the blocks for reuse. Destructors of allocated
+ * objects are not called by the arena.
+ */
+class Arena {
+
+private:
+  struct Block {
+    std::unique_ptr<std::byte[]> data;
+    size_t size;
+  };
+
+  size_t blockSize_;
+  std::vector<Block> blocks_;
+  size_t current_ = 0; // index of the block being allocated from
+  size_t offset_ = 0;  // offset of the first free byte in the current block
+  size_t used_ = 0;
+
+public:
+  /**
+   * @brief Constructs an empty arena
+   *
+   * @param blockSize The size in bytes of each block (larger requests get a
+   * block of their own)
+   */
+  explicit Arena(size_t blockSize = size_t{1} << 16);
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  /**
+   * @brief Allocates uninitialized memory
+   *
+   * @param bytes Number of bytes
+   * @param align Alignment, which must be a power of two
+   * @return Pointer to the allocated memory
+   */
+  void *allocate(size_t bytes, size_t align);
+
+  /** @brief Allocates and constructs an object */
+  template <typename T, typename... Args> T *create(Args &&...args) {
+    return new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  /** @brief Releases all allocations, keeping the blocks for reuse */
+  void reset();
+
+  /** @brief Returns the number of bytes allocated since the last reset */
+  inline size_t used() const { return used_; }
+
+  /** @brief Returns the total size of the blocks held by the arena */
+  size_t capacity() const;
+};
+
+/**
+ * @brief Handle to a tensor recorded on a tape
+ *
+ * Vars are cheap to copy and remain valid until their tape is reset or
+ * destroyed.
+ */
+class Var {
+
+private:
+  Tape *tape_;
+  Node *node_;
+
+public:
+  /** @brief Constructs a handle to a recorded node (see Tape) */
+  Var(Tape *tape, Node *node) : tape_(tape), node_(node) {}
+
+  /**
+   * @brief Returns the value of the var
+   * @throws std::invalid_argument If the value was released by backward
+   */
+  const Tensor &value() const;
+
+  /**
+   * @brief Returns the gradient of a variable after backward
+   * @throws std::invalid_argument If no gradient is available, e.g. because
+   * the var is not a variable created without a gradient buffer
+   */
+  const Tensor &grad() const;
+
+  /** @brief Returns true if the var depends on a variable */
+  bool requiresGrad() const;
+
+  /** @brief Returns true if the value was released by backward */
+  bool released() const;
+
+  /** @brief Returns the tape on which the var is recorded */
+  inline Tape &tape() const { return *tape_; }
+
+  /** @brief Returns the recorded node */
+  inline Node *node() const { return node_; }
+};
+
+/** @brief A function of vars, such as a segment of a model */
+using Function = std::function<Var(const std::vector<Var> &)>;
+
+/** @brief Callback receiving the gradient buffer of a variable */
+using GradHook = std::function<void(Tensor &grad)>;
+
+/** @brief Cost of the recomputation of checkpointed segments */
+struct RecomputeStats {
+  /** @brief Number of segments recomputed by backward */
+  size_t segments = 0;
+  /** @brief Number of nodes recorded while recomputing */
+  size_t nodes = 0;
+  /** @brief Wall-clock time spent recomputing forward passes */
+  double seconds = 0;
+};
+
+/**
+ * @brief Record of the operations of a forward pass
+ *
+ * Nodes are allocated from an arena owned by the tape, so that a training step
+ * that calls reset before recording allocates no memory for the tape itself
+ * once the arena has grown to the size of a step. Values are held without
+ * copying, including those of constants and variables, which must therefore
+ * not be modified until the tape is reset.
+ *
+ * A tape must only be used by one thread at a time.
+ */
+class Tape {
+
+private:
+  Arena arena_;
+  Node *last_ = nullptr; // most recently recorded node
+  size_t size_ = 0;
+  RecomputeStats stats_;
+  GradHook gradHook_;
+
+public:
+  /**
+   * @brief Constructs an empty tape
+   *
+   * @param blockSize The block size of the underlying arena
+   */
+  explicit Tape(size_t blockSize = size_t{1} << 16);
+
+  Tape(const Tape &) = delete;
+  Tape &operator=(const Tape &) = delete;
+
+  ~Tape();
+
+  /** @brief Records a tensor that does not require gradients */
+  Var constant(const Tensor &value);
+
+  /**
+   * @brief Records a tensor with respect to which gradients are computed
+   *
+   * The gradient is available from Var::grad after backward.
+   */
+  Var variable(const Tensor &value);
+
+  /**
+   * @brief Records a tensor whose gradient is accumulated into a buffer
+   *
+   * Gradients are added to grad in place as they are computed, so that
+   * repeated backward passes accumulate. Zeroing grad is up to the caller.
+   *
+   * @param value The value
+   * @param grad The gradient buffer, of the same shape as value
+   * @throws std::invalid_argument If the shapes differ or grad is not
+   * contiguous and writable
+   */
+  Var variable(const Tensor &value, Tensor &grad);
+
+  /**
+   * @brief Computes the gradients of a scalar with respect to all variables
+   *
+   * Nodes are visited in reverse order of recording. Once a node's gradient
+   * has been propagated to its inputs, its value, gradient and saved tensors
+   * are released, except for those of variables. Gradients reaching a node
+   * more than once are accumulated in place.
+   *
+   * @param root The var to differentiate, of size 1
+   * @throws std::invalid_argument If root has more than one element, does not
+   * belong to the tape or does not require gradients
+   */
+  void backward(const Var &root);
+
+  /**
+   * @overload
+   *
+   * @param root The var to differentiate
+   * @param seed The gradient of the final output with respect to root, of the
+   * same shape as root
+   */
+  void backward(const Var &root, const Tensor &seed);
+
+  /**
+   * @brief Sets a function to be called when the gradient of a variable is
+   * complete
+   *
+   * During backward, the hook is passed the gradient buffer of each variable
+   * created with one, as soon as the earliest recorded operation using the
+   * variable has been differentiated and before backward continues, so that
+   * work on the gradient (e.g. communication) can overlap with the rest of
+   * backward. Variables are therefore reported roughly in reverse order of
+   * use. The hook is kept by reset.
+   *
+   * @param hook The hook, or an empty function to remove it
+   */
+  void setGradHook(GradHook hook);
+
+  /**
+   * @brief Destroys all recorded nodes and rewinds the arena
+   *
+   * Invalidates all vars recorded on the tape and clears the recompute
+   * statistics.
+   */
+  void reset();
+
+  /** @brief Returns the number of recorded nodes */
+  inline size_t size() const { return size_; }
+
+  /** @brief Returns the arena from which nodes are allocated */
+  inline const Arena &arena() const { return arena_; }
+
+  /**
+   * @brief Returns the cost of recomputing checkpointed segments since the
+   * last reset (see checkpoint)
+   */
+  inline const RecomputeStats &recomputeStats() const { return stats_; }
+
+  // @cond
+  Node *record(Node *node);
+  inline Arena &arena() { return arena_; }
+  inline RecomputeStats &recomputeStats() { return stats_; }
+  // @endcond
+};
+
+/* OPERATIONS */
+
+/** @brief Broadcasting addition (see gs::operator+) */
+Var operator+(const Var &left, const Var &right);
+
+/** @brief Broadcasting subtraction (see gs::operator-) */
+Var operator-(const Var &left, const Var &right);
+
+/** @brief Broadcasting multiplication (see gs::operator*) */
+Var operator*(const Var &left, const Var &right);
+
+/** @brief Broadcasting division (see gs::operator/) */
+Var operator/(const Var &left, const Var &right);
+
+/** @brief Negation */
+Var operator-(const Var &var);
+
+/** @brief Scalar operators */
+Var operator+(const Var &var, double scalar);
+/** @overload */
+Var operator+(double scalar, const Var &var);
+/** @overload */
+Var operator-(const Var &var, double scalar);
+/** @overload */
+Var operator-(double scalar, const Var &var);
+/** @overload */
+Var operator*(const Var &var, double scalar);
+/** @overload */
+Var operator*(double scalar, const Var &var);
+/** @overload */
+Var operator/(const Var &var, double scalar);
+/** @overload */
+Var operator/(double scalar, const Var &var);
+
+/** @brief Computes scale * x + shift (see gs::affine) */
+Var affine(const Var &var, double scale, double shift);
+
+/** @brief Elementwise exponential (see gs::exp) */
+Var exp(const Var &var);
+
+/** @brief Elementwise natural logarithm (see gs::log) */
+Var log(const Var &var);
+
+/** @brief Elementwise hyperbolic tangent (see gs::tanh) */
+Var tanh(const Var &var);
+
+/** @brief Logistic sigmoid (see gs::sigmoid) */
+Var sigmoid(const Var &var);
+
+/** @brief ReLU activation (see gs::relu) */
+Var relu(const Var &var);
+
+/** @brief GELU activation (see gs::gelu) */
+Var gelu(const Var &var);
+
+/** @brief Softmax along an axis (see gs::softmax) */
+Var softmax(const Var &var, size_t axis);
+
+/** @brief Log-softmax along an axis (see gs::logSoftmax) */
+Var logSoftmax(const Var &var, size_t axis);
+
+/** @brief Tensor contraction (see gs::dot) */
+Var dot(const Var &left, const Var &right);
+
+/** @brief 2D convolution of images in the given layout (see gs::conv) */
+Var conv(const Var &input, const Var &kernel, Layout layout,
+         const ConvOptions &options = ConvOptions{});
+
+/** @brief Max pooling over trailing dimensions (see gs::maxPool) */
+Var maxPool(const Var &input, const array_t &poolShape,
+            const PoolOptions &options);
+
+/** @brief 2D max pooling of images in the given layout (see gs::maxPool) */
+Var maxPool(const Var &input, const array_t &poolShape, Layout layout,
+            const PoolOptions &options = PoolOptions{});
+
+/** @brief Adds a per-channel bias to images (see gs::addBias) */
+Var addBias(const Var &input, const Var &bias, Layout layout);
+
+/** @brief Gathers elements along an axis (see gs::gather) */
+Var gather(const Var &var, size_t axis, const Tensor &indices);
+
+/** @brief Selects slices along an axis (see gs::indexSelect) */
+Var indexSelect(const Var &var, size_t axis, const Tensor &indices);
+
+/** @brief Reshapes a var (see Tensor::reshape) */
+Var reshape(const Var &var, const array_t &shape);
+
+/** @brief Flattens a var (see gs::flatten) */
+Var flatten(const Var &var);
+
+/** @brief Sums all elements into a scalar */
+Var sum(const Var &var);
+
+/* CHECKPOINTING */
+
+/**
+ * @brief Records a function without retaining its intermediates
+ *
+ * The function is evaluated on a temporary tape that is discarded
+ * immediately, so that only the inputs and output are retained. When backward
+ * reaches the output, the function is evaluated again on a temporary tape and
+ * differentiated there, and the cost is added to Tape::recomputeStats.
+ *
+ * The function must compute its result from the vars it is passed alone
+ * (closing over vars of the outer tape is an error), and must compute the
+ * same result when called again. It is stored until the tape is reset.
+ *
+ * @param function The function
+ * @param inputs Its inputs, e.g. an activation followed by parameters
+ * @return The output of the function
+ * @throws std::invalid_argument If inputs is empty or its vars were recorded
+ * on different tapes
+ */
+Var checkpoint(const Function &function, const std::vector<Var> &inputs);
+
+/**
+ * @brief Applies a sequence of layers, checkpointing groups of them
+ *
+ * Each layer is called with the output of the previous layer (initially
+ * input) followed by params. The layers are split into the given number of
+ * consecutive segments of (almost) equal length, each recorded with
+ * checkpoint. For n layers, k segments retain O(k + n / k) activations at the
+ * cost of one extra forward pass: k = 0 records the layers directly and
+ * retains all activations, while k close to sqrt(n) minimizes memory.
+ *
+ * @param layers The layers
+ * @param input The input of the first layer
+ * @param params Additional inputs passed to every layer
+ * @param segments The number of segments, which is capped at the number of
+ * layers
+ * @return The output of the last layer
+ */
+Var checkpointSequential(const std::vector<Function> &layers, const Var &input,
+                         const std::vector<Var> &params, size_t segments);
+
+} // namespace ad
+} // namespace gs
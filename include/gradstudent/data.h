@@ -0,0 +1,243 @@
+/**
+ * @file data.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Data loading
+ * @version 0.1
+ * @date 2024-06-04
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gradstudent/tensor.h"
+
+namespace gs {
+namespace data {
+
+/**
+ * @brief A minibatch produced by a DataLoader
+ *
+ * Holds one preallocated tensor per field (e.g. images and labels), with the
+ * examples of the batch along the first axis. Batches are recycled by the
+ * loader, so their tensors are allocated once.
+ */
+class Batch {
+
+private:
+  friend class DataLoader;
+  friend class Sampler;
+
+  size_t epoch_ = 0;
+  size_t index_ = 0;
+  size_t begin_ = 0;
+  size_t size_ = 0;
+  size_t offset_ = 0; // row of the fields holding the first example
+  std::vector<Tensor> fields_;
+  std::exception_ptr error_;
+
+public:
+  /** @brief Allocates a batch of the given capacity */
+  Batch(size_t capacity, const std::vector<array_t> &exampleShapes);
+
+  Batch(const Batch &) = delete;
+  Batch &operator=(const Batch &) = delete;
+
+  /** @brief Returns the epoch of the batch, counting from 0 */
+  inline size_t epoch() const { return epoch_; }
+
+  /** @brief Returns the index of the batch within its epoch */
+  inline size_t index() const { return index_; }
+
+  /** @brief Returns the position of the first example within the epoch */
+  inline size_t begin() const { return begin_; }
+
+  /**
+   * @brief Returns the number of examples, which may be smaller than the
+   * capacity for the last batch of an epoch
+   */
+  inline size_t size() const { return size_; }
+
+  /** @brief Returns the number of fields */
+  inline size_t fields() const { return fields_.size(); }
+
+  /**
+   * @brief Returns a view of the size() examples of field k
+   *
+   * @throws std::out_of_range If there is no field k
+   */
+  Tensor operator[](size_t k);
+
+  /** @overload */
+  const Tensor operator[](size_t k) const;
+};
+
+/** @brief Options of a DataLoader */
+struct LoaderOptions {
+  /** @brief Number of examples per batch */
+  size_t batchSize = 64;
+  /** @brief Number of producer threads */
+  size_t workers = 1;
+  /** @brief Number of batches prepared ahead of the consumer */
+  size_t prefetch = 2;
+};
+
+/**
+ * @brief Produces minibatches on background threads
+ *
+ * Producer threads fill batches in order of position, epoch after epoch,
+ * while the consumer works on earlier ones. There are prefetch + 1 batches:
+ * the one returned by the latest call to next and those being filled or
+ * waiting to be consumed, so that producers stay at most prefetch batches
+ * ahead and no tensors are allocated after construction.
+ *
+ * Producers run kernels serially (see parallelFor), leaving the other
+ * threads to the consumer.
+ */
+class DataLoader {
+
+public:
+  /**
+   * @brief Fills a batch with the examples at its positions of its epoch
+   *
+   * Called concurrently from the producer threads, on different batches.
+   */
+  using Fill = std::function<void(Batch &batch)>;
+
+private:
+  size_t examples_;
+  LoaderOptions options_;
+  Fill fill_;
+  std::vector<std::unique_ptr<Batch>> slots_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<Batch *> free_;
+  std::map<size_t, Batch *> ready_; // keyed by global batch number
+  size_t produced_ = 0;             // next global batch number to claim
+  size_t consumed_ = 0;             // next global batch number to return
+  Batch *current_ = nullptr;        // batch held by the consumer
+  bool stop_ = false;
+  std::vector<std::thread> threads_;
+
+  void produce();
+
+public:
+  /**
+   * @brief Starts producing batches
+   *
+   * @param examples The number of examples per epoch
+   * @param exampleShapes The shape of each field of an example
+   * @param fill The function filling batches
+   * @param options The options
+   * @throws std::invalid_argument If there are no examples, or the batch
+   * size, number of workers or prefetch depth is 0
+   */
+  DataLoader(size_t examples, const std::vector<array_t> &exampleShapes,
+             Fill fill, const LoaderOptions &options = LoaderOptions{});
+
+  DataLoader(const DataLoader &) = delete;
+  DataLoader &operator=(const DataLoader &) = delete;
+
+  /** @brief Stops the producers, after they finish their current batches */
+  ~DataLoader();
+
+  /**
+   * @brief Returns the next batch, blocking until it is ready
+   *
+   * The batch remains valid until the next call, which recycles it.
+   *
+   * @throws Any exception thrown by the fill function for this batch
+   */
+  const Batch &next();
+
+  /** @brief Returns the number of batches per epoch */
+  size_t batches() const;
+};
+
+/** @brief Options of a Sampler */
+struct SamplerOptions {
+  /** @brief Number of examples per batch */
+  size_t batchSize = 64;
+  /** @brief Whether to visit the examples of each epoch in random order */
+  bool shuffle = true;
+  /** @brief Seed of the random orders */
+  uint64_t seed = 0;
+};
+
+/**
+ * @brief Draws minibatches from tensors held in memory
+ *
+ * The examples are the rows of the sources (e.g. images and labels) along
+ * their first axis. Each epoch visits every example once, sequentially or in
+ * a random order determined by the seed and the epoch alone, and identical on
+ * all platforms.
+ *
+ * Sequential batches are read-only views of the sources, so no data is
+ * copied. Shuffled batches are gathered row by row (in parallel for large
+ * batches) into a single batch allocated on construction, which is recycled
+ * by each call to next.
+ */
+class Sampler {
+
+private:
+  std::vector<Tensor> sources_; // contiguous read-only views
+  size_t examples_;
+  SamplerOptions options_;
+  std::vector<size_t> order_;
+  Batch batch_;
+  size_t produced_ = 0; // global number of the next batch
+
+  void shuffle(size_t epoch);
+
+  void gather();
+
+public:
+  /**
+   * @brief Constructs a sampler
+   *
+   * Contiguous sources are shared rather than copied, so they must not be
+   * modified while the sampler is in use.
+   *
+   * @param sources The tensors holding the examples
+   * @param options The options
+   * @throws std::invalid_argument If there are no sources, a source is a
+   * scalar or they have different numbers of examples, or if there are no
+   * examples or the batch size is 0
+   */
+  explicit Sampler(const std::vector<const Tensor *> &sources,
+                   const SamplerOptions &options = SamplerOptions{});
+
+  Sampler(const Sampler &) = delete;
+  Sampler &operator=(const Sampler &) = delete;
+
+  /**
+   * @brief Returns the next batch
+   *
+   * The batch remains valid until the next call, which recycles it.
+   */
+  const Batch &next();
+
+  /** @brief Returns the number of batches per epoch */
+  size_t batches() const;
+
+  /**
+   * @brief Returns the example at each position of the epoch of the latest
+   * batch
+   */
+  inline const std::vector<size_t> &order() const { return order_; }
+};
+
+} // namespace data
+} // namespace gs
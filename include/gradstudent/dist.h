@@ -0,0 +1,202 @@
+/**
+ * @file dist.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Data-parallel training
+ * @version 0.1
+ * @date 2024-06-02
+ *
+ * @copyright Copyright (c) 2024
+ *
+ * Replicas of a model either run as threads of one process (DataParallel) or
+ * as separate processes on one host (ProcessGroup).
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gradstudent/autograd.h"
+#include "gradstudent/tensor.h"
+
+namespace gs {
+namespace dist {
+
+/**
+ * @brief Loss of a model on a shard of a minibatch
+ *
+ * Called with a tape on which the parameters have been recorded as variables
+ * (in the order given to the trainer) and the inputs and targets of the
+ * shard, and must return the mean loss over the examples of the shard,
+ * recorded on that tape. The function is called concurrently from several
+ * threads, each with its own tape.
+ */
+using LossFunction = std::function<ad::Var(
+    ad::Tape &tape, const std::vector<ad::Var> &params, const Tensor &inputs,
+    const Tensor &targets)>;
+
+/**
+ * @brief Computes gradients of minibatches with one model replica per thread
+ *
+ * Each step splits a minibatch along its first axis into one shard per
+ * replica and runs forward and backward on each shard in its own thread, with
+ * its own tape and gradient buffers. Parameters are only read during a step,
+ * so replicas share them instead of holding copies.
+ *
+ * Gradients are combined by an all-reduce that overlaps with backward: as
+ * soon as the gradient of a parameter is complete on every replica (see
+ * ad::Tape::setGradHook), replica r sums the r-th of equal shards of that
+ * gradient over all replicas into the output buffer (a reduce-scatter), in
+ * blocks that stay in cache. Since the output is shared, every replica then
+ * sees the full reduced gradient once the step completes, which takes the
+ * place of the all-gather.
+ */
+class DataParallel {
+
+private:
+  struct Replica;
+
+  std::vector<Tensor *> params_;
+  std::vector<Tensor *> grads_;
+  LossFunction loss_;
+  std::vector<std::unique_ptr<Replica>> replicas_;
+
+public:
+  /**
+   * @brief Constructs a trainer
+   *
+   * @param params The parameters, which must outlive the trainer
+   * @param grads Buffers receiving the gradients, in the same order, which
+   * must outlive the trainer and be contiguous and writable
+   * @param loss The loss function
+   * @param replicas The number of replicas, defaulting to numThreads (0)
+   * @throws std::invalid_argument If the numbers or shapes of parameters and
+   * gradients differ or a gradient buffer is not contiguous or is read-only
+   */
+  DataParallel(std::vector<Tensor *> params, std::vector<Tensor *> grads,
+               LossFunction loss, size_t replicas = 0);
+
+  DataParallel(const DataParallel &) = delete;
+  DataParallel &operator=(const DataParallel &) = delete;
+
+  ~DataParallel();
+
+  /**
+   * @brief Computes the gradient of the mean loss over a minibatch
+   *
+   * Overwrites the gradient buffers. Each replica's loss is weighted by the
+   * size of its shard, so that the result does not depend on the number of
+   * replicas (up to rounding). Minibatches smaller than the number of
+   * replicas use one replica per example.
+   *
+   * @param inputs The inputs, with examples along the first axis
+   * @param targets The targets, with examples along the first axis
+   * @return The mean loss
+   * @throws std::invalid_argument If the minibatch is empty or inputs and
+   * targets have different numbers of examples; exceptions thrown by the loss
+   * function or backward are rethrown
+   */
+  double step(const Tensor &inputs, const Tensor &targets);
+
+  /** @brief Returns the number of replicas */
+  inline size_t replicas() const { return replicas_.size(); }
+};
+
+/**
+ * @brief Group of processes on one host that all-reduce tensors through shared
+ * memory
+ *
+ * Rank 0 creates a POSIX shared-memory segment holding one region of the
+ * given capacity per rank, and a Unix domain socket (in the abstract
+ * namespace) to which the other ranks connect. Tensors returned by allocate
+ * live directly in the calling rank's region, so that gradients can be
+ * computed into them (e.g. as gradient buffers of ad::Tape::variable) and
+ * reduced without being copied in or out.
+ *
+ * allReduce sums the allocated tensors across ranks with a reduce-scatter
+ * followed by an all-gather: each rank sums its shard of the regions of all
+ * ranks, visiting them in ring order from its own, and then copies the shards
+ * reduced by the others. Ranks synchronize through the sockets, so that a
+ * rank that exits or crashes makes collective calls fail on the others
+ * instead of hanging them.
+ *
+ * All ranks must allocate tensors of the same sizes in the same order.
+ */
+class ProcessGroup {
+
+private:
+  struct Segment;
+
+  size_t rank_;
+  size_t size_;
+  size_t capacity_;
+  std::shared_ptr<Segment> segment_;
+  std::vector<int> peers_; // sockets to the other ranks (rank 0), or to rank 0
+  size_t used_ = 0;
+
+  void join(const std::string &name, const std::string &shmName,
+            size_t bytes);
+  void exchange(size_t value);
+
+public:
+  /**
+   * @brief Joins a process group, blocking until all ranks have joined
+   *
+   * @param name The name of the group, unique on the host
+   * @param rank The rank of the calling process, in [0, size)
+   * @param size The number of processes
+   * @param capacity The number of elements of each rank's region
+   * @throws std::invalid_argument If the rank is out of range
+   * @throws std::system_error If shared memory or sockets cannot be set up,
+   * or rank 0 cannot be reached within 60 seconds
+   */
+  ProcessGroup(const std::string &name, size_t rank, size_t size,
+               size_t capacity);
+
+  ProcessGroup(const ProcessGroup &) = delete;
+  ProcessGroup &operator=(const ProcessGroup &) = delete;
+
+  /**
+   * @brief Leaves the group
+   *
+   * Allocated tensors remain valid, since the segment stays mapped while they
+   * exist. (Its name is unlinked as soon as all ranks have mapped it, so that
+   * it is released even if processes crash.)
+   */
+  ~ProcessGroup();
+
+  /**
+   * @brief Allocates a zero-initialized tensor in this rank's region
+   *
+   * @throws std::invalid_argument If the region is full
+   */
+  Tensor allocate(const array_t &shape);
+
+  /**
+   * @brief Replaces every allocated tensor by its sum over all ranks
+   *
+   * @param scale Factor applied to the sums, e.g. 1 / size() for a mean
+   * @throws std::invalid_argument If the ranks allocated different numbers of
+   * elements
+   * @throws std::runtime_error If another rank left the group
+   */
+  void allReduce(double scale = 1);
+
+  /**
+   * @brief Blocks until all ranks have called barrier
+   *
+   * @throws std::runtime_error If another rank left the group
+   */
+  void barrier();
+
+  /** @brief Returns the rank of the calling process */
+  inline size_t rank() const { return rank_; }
+
+  /** @brief Returns the number of processes */
+  inline size_t size() const { return size_; }
+};
+
+} // namespace dist
+} // namespace gs
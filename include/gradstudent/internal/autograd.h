@@ -0,0 +1,133 @@
+/**
+ * @file autograd.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Tape nodes and gradient helpers
+ * @version 0.1
+ * @date 2024-05-27
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "gradstudent/autograd.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+
+namespace gs {
+namespace ad {
+
+/** @brief Operations that can be recorded on a tape */
+enum class Op {
+  CONSTANT,
+  VARIABLE,
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  NEG,
+  AFFINE, // scale * x + shift, with the scale in Node::scalar
+  RDIV,   // c / x, with c in Node::scalar
+  EXP,
+  LOG,
+  TANH,
+  SIGMOID,
+  RELU,
+  GELU,
+  SOFTMAX,
+  LOG_SOFTMAX,
+  DOT,
+  RESHAPE,
+  SUM,
+  CONV,         // with the layout and resolved options in the node
+  MAX_POOL,     // with the indices of the maxima in Node::saved
+  ADD_BIAS,     // with the layout in the node
+  GATHER,       // with the axis and the indices in Node::saved
+  INDEX_SELECT, // with the axis and the indices in Node::saved
+  CHECKPOINT    // with the recomputed function in Node::segment
+};
+
+/** @brief A checkpointed function and its inputs (see checkpoint) */
+struct Segment {
+  Function function;
+  std::vector<Node *> inputs;
+  Tape *tape; // the tape on which the segment is recorded
+};
+
+/**
+ * @brief A recorded operation
+ *
+ * Nodes form an intrusive list in order of recording and refer to their
+ * inputs, which are always recorded earlier.
+ */
+struct Node {
+  Op op;
+  Node *prev = nullptr;               // previously recorded node
+  std::array<Node *, 2> inputs = {};  // unused inputs are null
+  bool requiresGrad = false;
+  bool ownsGrad = false;              // grad may be updated in place
+  bool gradReady = false;             // the grad hook was called (variables)
+  std::optional<Tensor> value;
+  std::optional<Tensor> grad;
+  Tensor *sink = nullptr;             // external gradient buffer (variables)
+  double scalar = 0;                  // see Op
+  size_t axis = 0;                    // axis (softmax, indexing)
+  Layout layout = Layout::NCHW;       // image layout (conv, bias)
+  ConvOptions options;                // convolution options
+  std::optional<Tensor> saved;        // saved for backward (pooling, indices)
+  std::unique_ptr<Segment> segment;   // recomputed function (checkpoint)
+  Node *firstUse = nullptr;           // earliest recorded consumer (variables)
+
+  Node(Op op, const Tensor &value, Node *left = nullptr,
+       Node *right = nullptr);
+};
+
+/**
+ * @brief Stores a read-only view of a tensor in a slot
+ *
+ * The view shares the tensor's data, so that no copy is made.
+ */
+void hold(std::optional<Tensor> &slot, const Tensor &tensor);
+
+/**
+ * @brief Adds src to dst in place
+ *
+ * @throws std::invalid_argument If the shapes differ
+ */
+void addInto(Tensor &dst, const Tensor &src);
+
+/**
+ * @brief Sums a gradient over broadcast dimensions
+ *
+ * Reduces a gradient with respect to the result of a broadcasting operation
+ * to the shape of one of its operands. Returns a view of grad if the shapes
+ * already agree.
+ */
+Tensor sumTo(const Tensor &grad, const array_t &shape);
+
+/** @brief Adds a gradient contribution to a node */
+void accumulate(Node &node, const Tensor &grad);
+
+/**
+ * @brief Propagates the gradient of a node to its inputs
+ *
+ * Must only be called on nodes whose gradient is complete, i.e. in reverse
+ * order of recording.
+ */
+void backwardNode(Node &node);
+
+/**
+ * @brief Propagates the gradient of a checkpoint node to its inputs
+ *
+ * Recomputes the forward pass of the segment on a temporary tape and
+ * differentiates it there.
+ */
+void checkpointBackward(Node &node);
+
+} // namespace ad
+} // namespace gs
@@ -0,0 +1,125 @@
+/**
+ * @file conv.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Specialized convolution kernels
+ * @version 0.1
+ * @date 2024-05-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+
+namespace gs {
+
+/**
+ * @brief Replaces empty convolution options by their defaults
+ *
+ * @param options The options
+ * @param n The number of convolved dimensions
+ * @return Options with one entry per convolved dimension
+ * @throws std::invalid_argument If an option has the wrong size or a stride or
+ * dilation is zero
+ */
+ConvOptions resolveConvOptions(const ConvOptions &options, size_t n);
+
+/**
+ * @brief Returns true if the Winograd kernel applies to the given convolution
+ *
+ * Winograd convolution applies to 2D convolutions with 3x3 kernels, i.e. to
+ * calls to conv with n = 2 whose kernel has spatial shape (3, 3) and whose
+ * remaining (contracted) dimensions match those of the input.
+ */
+bool winogradApplicable(const Tensor &input, const Tensor &kernel, size_t n);
+
+/**
+ * @brief Computes a 2D convolution with a 3x3 kernel using Winograd's minimal
+ * filtering algorithm
+ *
+ * Uses F(4x4, 3x3) tiles for large outputs and F(2x2, 3x3) tiles otherwise.
+ * Transformed filters are cached, so that repeated convolutions with the same
+ * kernel skip the filter transform. Arguments and result are as for conv.
+ */
+Tensor winogradConv(const Tensor &input, const Tensor &kernel);
+
+/**
+ * @brief Returns true if FFT convolution is expected to outperform direct
+ * convolution
+ *
+ * FFT convolution applies to 1D and 2D convolutions whose kernel's remaining
+ * (contracted) dimensions match those of the input. It is preferred when the
+ * estimated cost of the transforms is less than that of direct convolution,
+ * which grows with the kernel size.
+ */
+bool fftConvPreferred(const Tensor &input, const Tensor &kernel, size_t n);
+
+/**
+ * @brief Computes a 1D or 2D convolution using fast Fourier transforms
+ *
+ * Each input channel is transformed once and the transform is reused across
+ * all filters. Arguments and result are as for conv.
+ */
+Tensor fftConv(const Tensor &input, const Tensor &kernel, size_t n);
+
+/**
+ * @brief Returns true if the direct kernel applies to the given convolution
+ *
+ * The direct kernel applies to convolutions whose kernel's remaining
+ * (contracted) dimensions match those of the input.
+ */
+bool directConvApplicable(const Tensor &input, const Tensor &kernel, size_t n);
+
+/**
+ * @brief Computes a convolution by direct summation over each window
+ *
+ * Strides, dilations and padding are handled inside the kernel: only the
+ * selected windows are computed and padding is treated as virtual zeros, so no
+ * padded copy of the input is made. Arguments and result are as for conv, with
+ * each option of size n.
+ *
+ * @throws std::invalid_argument If the dilated kernel exceeds the padded input
+ */
+Tensor directConv(const Tensor &input, const Tensor &kernel, size_t n,
+                  const ConvOptions &options);
+
+/**
+ * @brief Computes a 2D convolution of images in the given layout by direct
+ * summation
+ *
+ * Arguments and result are as for the layout-aware conv, with each option of
+ * size 2. Shapes are assumed to have been validated.
+ */
+Tensor directConv2d(const Tensor &input, const Tensor &kernel, Layout layout,
+                    const ConvOptions &options);
+
+/**
+ * @brief Computes the gradients of a 2D convolution of images in the given
+ * layout
+ *
+ * The windows of each image are unrolled into the rows (NHWC) or columns
+ * (NCHW) of a matrix, so that both gradients are blocked GEMMs against the
+ * output gradient: the kernel gradient with the unrolled input, and the input
+ * gradient with the kernel, after which overlapping windows are folded back
+ * into the image. In NHWC layout, the GEMMs span several images at a time.
+ * Arguments are as for the layout-aware conv, with each option of size 2.
+ * Shapes are assumed to have been validated.
+ *
+ * @param grad The gradient with respect to the output
+ * @param input The input images
+ * @param kernel The kernel
+ * @param layout The layout of the images and kernel
+ * @param options The stride, dilation and padding
+ * @param inputGrad If not null, a newly allocated tensor of the shape of input
+ * to which the input gradient is written
+ * @param kernelGrad If not null, a newly allocated tensor of the shape of
+ * kernel to which the kernel gradient is written
+ */
+void conv2dBackward(const Tensor &grad, const Tensor &input,
+                    const Tensor &kernel, Layout layout,
+                    const ConvOptions &options, Tensor *inputGrad,
+                    Tensor *kernelGrad);
+
+} // namespace gs
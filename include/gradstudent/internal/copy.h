@@ -0,0 +1,39 @@
+/**
+ * @file copy.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Strided copy engine
+ * @version 0.1
+ * @date 2024-05-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "gradstudent/array.h"
+
+namespace gs {
+
+/**
+ * @brief Copies the elements of one strided buffer into another
+ *
+ * Both buffers are interpreted as tensors of the given shape with the given
+ * strides. The loop order is chosen from both sets of strides: dimensions are
+ * ordered to make writes as sequential as possible and dimensions that are
+ * contiguous in both buffers are merged. When the innermost destination
+ * dimension is strided in the source but another dimension is contiguous in
+ * the source (as in a transpose), the copy proceeds in cache-sized 2D tiles.
+ * Large copies are split across threads.
+ *
+ * The buffers must not overlap.
+ *
+ * @param dst Pointer to the first destination element
+ * @param dstStrides Destination strides
+ * @param src Pointer to the first source element
+ * @param srcStrides Source strides
+ * @param shape Common shape
+ */
+void stridedCopy(double *dst, const array_t &dstStrides, const double *src,
+                 const array_t &srcStrides, const array_t &shape);
+
+} // namespace gs
@@ -0,0 +1,128 @@
+/**
+ * @file fft.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Fast Fourier transforms
+ * @version 0.1
+ * @date 2024-05-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <complex>
+#include <vector>
+
+#include "gradstudent/array.h"
+
+namespace gs {
+
+/** @brief Returns the smallest power of two greater than or equal to n */
+size_t nextPow2(size_t n);
+
+/**
+ * @brief Complex FFT of a fixed power-of-two size
+ *
+ * Iterative radix-2 Cooley-Tukey transform with precomputed twiddle factors.
+ * Transforms are unnormalized, i.e. an inverse transform following a forward
+ * transform scales the input by the transform size.
+ */
+class FFT {
+public:
+  /** @brief Construct a new FFT object for the given (power of two) size */
+  explicit FFT(size_t n);
+
+  /** @brief Returns the transform size */
+  size_t size() const { return n_; }
+
+  /**
+   * @brief Transforms the given data in place
+   *
+   * @param data Pointer to size() complex values
+   * @param inverse Whether to compute the inverse transform
+   */
+  void transform(std::complex<double> *data, bool inverse) const;
+
+private:
+  size_t n_;
+  std::vector<std::complex<double>> twiddles_; // exp(-2 pi i k / n), k < n / 2
+  std::vector<size_t> bitrev_;
+};
+
+/**
+ * @brief Real-to-complex FFT of a fixed even power-of-two size
+ *
+ * A real sequence of length n has a conjugate-symmetric spectrum, so only the
+ * n / 2 + 1 non-negative frequencies are computed. The transform is computed
+ * with a complex FFT of size n / 2 by packing even and odd elements into the
+ * real and imaginary parts of a complex sequence.
+ */
+class RealFFT {
+public:
+  /** @brief Construct a new RealFFT object for the given size (at least 2) */
+  explicit RealFFT(size_t n);
+
+  /** @brief Returns the transform size */
+  size_t size() const { return n_; }
+
+  /**
+   * @brief Forward transform
+   *
+   * @param in Pointer to size() real values
+   * @param out Pointer to size() / 2 + 1 complex values
+   */
+  void forward(const double *in, std::complex<double> *out) const;
+
+  /**
+   * @brief Unnormalized inverse transform
+   *
+   * @param in Pointer to size() / 2 + 1 complex values
+   * @param out Pointer to size() real values
+   */
+  void inverse(const std::complex<double> *in, double *out) const;
+
+private:
+  size_t n_;
+  FFT half_;
+  std::vector<std::complex<double>> twiddles_; // exp(-2 pi i k / n), k < n / 2
+};
+
+/**
+ * @brief Two-dimensional real-to-complex FFT
+ *
+ * Transforms a row-major array of rows x cols real values into a row-major
+ * array of rows x (cols / 2 + 1) complex values. Both dimensions must be powers
+ * of two and cols must be at least 2.
+ */
+class RealFFT2D {
+public:
+  /** @brief Construct a new RealFFT2D object */
+  RealFFT2D(size_t rows, size_t cols);
+
+  /** @brief Returns the number of rows */
+  size_t rows() const { return colFFT_.size(); }
+
+  /** @brief Returns the number of real columns */
+  size_t cols() const { return rowFFT_.size(); }
+
+  /** @brief Returns the number of complex columns in the spectrum */
+  size_t spectrumCols() const { return rowFFT_.size() / 2 + 1; }
+
+  /** @brief Forward transform */
+  void forward(const double *in, std::complex<double> *out) const;
+
+  /**
+   * @brief Unnormalized inverse transform
+   *
+   * The input spectrum is overwritten.
+   */
+  void inverse(std::complex<double> *in, double *out) const;
+
+private:
+  FFT colFFT_;     // complex transform along columns
+  RealFFT rowFFT_; // real transform along rows
+
+  void transformColumns(std::complex<double> *data, bool inverse) const;
+};
+
+} // namespace gs
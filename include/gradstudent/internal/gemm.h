@@ -0,0 +1,47 @@
+/**
+ * @file gemm.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Cache-blocked matrix multiplication
+ * @version 0.1
+ * @date 2024-05-29
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <cstddef>
+
+namespace gs {
+
+/**
+ * @brief Computes C = alpha op(A) op(B) + beta C for row-major matrices
+ *
+ * op(A) is m x k and op(B) is k x n, where op(X) is X or its transpose
+ * according to transA and transB, so that transposed products need no
+ * transposed copy. Row i of each matrix X starts at X + i * ldX.
+ *
+ * Panels of op(A) and op(B) are packed into contiguous buffers sized for the
+ * L2 and L3 caches and multiplied by a register-blocked micro-kernel (SSE2
+ * when available). Row blocks of C are computed in parallel. When beta is
+ * zero, C is not read, so it may be uninitialized.
+ *
+ * @param transA Whether A is stored as k x m
+ * @param transB Whether B is stored as n x k
+ * @param m Number of rows of C
+ * @param n Number of columns of C
+ * @param k Contracted size
+ * @param alpha Scale of the product
+ * @param a Pointer to A
+ * @param lda Leading dimension of A
+ * @param b Pointer to B
+ * @param ldb Leading dimension of B
+ * @param beta Scale of C
+ * @param c Pointer to C
+ * @param ldc Leading dimension of C
+ */
+void gemm(bool transA, bool transB, size_t m, size_t n, size_t k, double alpha,
+          const double *a, size_t lda, const double *b, size_t ldb,
+          double beta, double *c, size_t ldc);
+
+} // namespace gs
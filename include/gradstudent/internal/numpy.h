@@ -0,0 +1,36 @@
+/**
+ * @file numpy.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Parsing of NPY headers
+ * @version 0.1
+ * @date 2024-06-05
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <istream>
+#include <string>
+
+#include "gradstudent/array.h"
+
+namespace gs {
+
+/** @brief Header of an NPY file */
+struct numpy_header {
+  std::string descr;
+  bool fortran_order{};
+  array_t shape;
+};
+
+/**
+ * @brief Parses the header of an NPY file
+ *
+ * Leaves the stream at the start of the array data.
+ *
+ * @throws std::runtime_error If the header is invalid or unsupported
+ */
+numpy_header parse_numpy_header(std::istream &file);
+
+} // namespace gs
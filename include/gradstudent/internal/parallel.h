@@ -0,0 +1,92 @@
+/**
+ * @file parallel.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Helpers for multi-threaded kernels
+ * @version 0.1
+ * @date 2024-05-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "gradstudent/array.h"
+
+namespace gs {
+
+/**
+ * @brief Returns the maximum number of threads used by parallel kernels
+ *
+ * Defaults to the hardware concurrency.
+ */
+size_t numThreads();
+
+/**
+ * @brief Sets the maximum number of threads used by parallel kernels
+ *
+ * A value of 0 restores the default.
+ */
+void setNumThreads(size_t n);
+
+// @cond
+bool &inParallelRegion();
+// @endcond
+
+/**
+ * @brief Splits a range of work items across threads
+ *
+ * Calls fn(begin, end) on disjoint subranges covering [0, n). Each subrange
+ * contains at least grain items (except possibly when n < grain), so that
+ * small workloads run on the calling thread alone. Calls made from within a
+ * parallel region run serially to avoid oversubscription.
+ *
+ * Exceptions thrown by fn are rethrown on the calling thread.
+ *
+ * @param n Number of work items
+ * @param grain Minimum number of work items per thread
+ * @param fn Callable with signature void(size_t begin, size_t end)
+ */
+template <typename F> void parallelFor(size_t n, size_t grain, const F &fn) {
+  grain = std::max<size_t>(grain, 1);
+  size_t numChunks = std::min(numThreads(), n / grain);
+  if (numChunks <= 1 || inParallelRegion()) {
+    if (n > 0) {
+      fn(0, n);
+    }
+    return;
+  }
+
+  std::vector<std::exception_ptr> errors(numChunks);
+  auto work = [&](size_t chunk) {
+    bool &flag = inParallelRegion();
+    flag = true;
+    try {
+      fn(chunk * n / numChunks, (chunk + 1) * n / numChunks);
+    } catch (...) {
+      errors[chunk] = std::current_exception();
+    }
+    flag = false;
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(numChunks - 1);
+  for (size_t chunk = 1; chunk < numChunks; ++chunk) {
+    threads.emplace_back(work, chunk);
+  }
+  work(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (const auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+} // namespace gs
@@ -39,6 +39,26 @@ template <typename Iterable> size_t prod(const Iterable &iterable) {
 }
 // @endcond
 
+/**
+ * @brief Computes strides for viewing a strided buffer with a new shape
+ *
+ * A view with the new shape exists whenever each group of dimensions that is
+ * merged or split by the reshape is contiguous in the buffer, as is always the
+ * case for tensors with default strides. If such a view exists, the output
+ * parameter is set to its strides.
+ *
+ * The shapes must have the same number of elements.
+ *
+ * @param[out] out Strides of the view (should be uninitialized).
+ * @param shape Current shape.
+ * @param strides Current strides.
+ * @param newShape Shape of the view.
+ * @return true If the buffer can be viewed with the new shape.
+ * @return false If a copy is required.
+ */
+bool reshapeStrides(array_t &out, const array_t &shape, const array_t &strides,
+                    const array_t &newShape);
+
 /**
  * @brief Broadcasts two shapes to a common shape.
  *
@@ -65,4 +85,30 @@ std::vector<int> broadcastShapes(array_t &out, const array_t &left,
 void checkCompatibleShape(const Tensor &, const Tensor &);
 // @endcond
 
+/**
+ * @brief Returns true if the tensor has default strides
+ *
+ * Strides of unit dimensions are ignored.
+ */
+bool isContiguous(const Tensor &tensor);
+
+/**
+ * @brief Returns a tensor with default strides and the same elements
+ *
+ * The result is a read-only view if the tensor is already contiguous and a
+ * copy otherwise. Useful for kernels that operate on raw buffers.
+ */
+Tensor contiguous(const Tensor &tensor);
+
+/**
+ * @brief Returns a pointer to the elements of a tensor, for writing
+ *
+ * The tensor must be contiguous and own writable data (e.g. be freshly
+ * constructed), so that writes through the pointer reach its elements. Useful
+ * for kernels that write to raw buffers.
+ *
+ * @throws std::invalid_argument If the tensor is read-only or not contiguous
+ */
+double *mutableData(Tensor &tensor);
+
 } // namespace gs
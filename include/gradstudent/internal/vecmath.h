@@ -0,0 +1,72 @@
+/**
+ * @file vecmath.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Vectorized elementwise math kernels
+ * @version 0.1
+ * @date 2024-05-24
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <cstddef>
+
+namespace gs {
+
+/*
+ * Each kernel writes f(in[i]) to out[i] for i < n, where in and out are
+ * contiguous and may alias. The kernels use SSE2 when available and are
+ * otherwise evaluated one element at a time with the same arithmetic, so
+ * results do not depend on alignment or on the position of an element.
+ *
+ * Error bounds are with respect to the exact result rounded to double and
+ * hold for all finite inputs unless stated otherwise. Special values (NaN,
+ * infinities, zeros) are handled as by the C library.
+ */
+
+/**
+ * @brief Computes exp elementwise
+ *
+ * Cody-Waite range reduction to |r| <= ln(2) / 2 followed by a degree 13
+ * polynomial. Error is at most 1 ulp (subnormal results are additionally
+ * rounded to the subnormal grid).
+ */
+void vecExp(const double *in, double *out, size_t n);
+
+/**
+ * @brief Computes the natural logarithm elementwise
+ *
+ * Reduction to a mantissa in [sqrt(2) / 2, sqrt(2)) followed by a degree 11
+ * series in s^2 with s = f / (2 + f). Error is at most 1 ulp. Negative inputs
+ * give NaN and zero gives -infinity.
+ */
+void vecLog(const double *in, double *out, size_t n);
+
+/**
+ * @brief Computes tanh elementwise
+ *
+ * Evaluated as -e / (e + 2) with e = expm1(-2 |x|), which avoids cancellation
+ * near zero. Error is at most 3 ulp.
+ */
+void vecTanh(const double *in, double *out, size_t n);
+
+/**
+ * @brief Computes the logistic sigmoid 1 / (1 + exp(-x)) elementwise
+ *
+ * Evaluated from exp(-|x|) so that no intermediate overflows. Error is at most
+ * 3 ulp.
+ */
+void vecSigmoid(const double *in, double *out, size_t n);
+
+/**
+ * @brief Computes the GELU activation elementwise
+ *
+ * Uses the tanh approximation x * sigmoid(z) with
+ * z = 2 sqrt(2 / pi) (x + 0.044715 x^3). Error is at most 4 ulp for x >= -1.
+ * Below, the rounding error of z is amplified by the exponential and the error
+ * is at most 4 |z| ulp.
+ */
+void vecGelu(const double *in, double *out, size_t n);
+
+} // namespace gs
@@ -0,0 +1,175 @@
+/**
+ * @file io.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Asynchronous file reading
+ * @version 0.1
+ * @date 2024-06-05
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gradstudent/tensor.h"
+
+namespace gs {
+namespace io {
+
+/** @brief Implementations of asynchronous reads */
+enum class Backend {
+  AUTO,  // io_uring if the kernel allows it, and threads otherwise
+  URING, // Linux io_uring, used through raw system calls
+  THREADS
+};
+
+/** @brief Options of an AsyncReader */
+struct ReaderOptions {
+  /** @brief Maximum number of reads submitted but not yet completed */
+  size_t queueDepth = 64;
+  /** @brief Number of threads of the thread backend */
+  size_t threads = 4;
+  /** @brief Backend to use */
+  Backend backend = Backend::AUTO;
+};
+
+/** @brief Outcome of a read */
+struct Completion {
+  /** @brief Tag passed to AsyncReader::read */
+  uint64_t tag;
+  /**
+   * @brief Number of bytes read, which may be smaller than requested (e.g. at
+   * the end of a file), as with pread
+   */
+  size_t bytes;
+  /** @brief 0 on success, and an errno value otherwise */
+  int error;
+};
+
+/** @brief A read waiting to be submitted */
+struct ReadRequest {
+  int fd;
+  void *dst;
+  size_t bytes;
+  uint64_t offset;
+  uint64_t tag;
+};
+
+/**
+ * @brief Reads files asynchronously, batching submissions
+ *
+ * Reads are queued by read, submitted together by submit (one system call
+ * for io_uring) and reported by wait in order of completion, so that callers
+ * can process each read (e.g. decode it) while others are in flight. Reads
+ * go directly into the caller's buffers, such as the data of a tensor, which
+ * must stay valid until their completion is reported.
+ *
+ * A reader must only be used by one thread at a time.
+ */
+class AsyncReader {
+
+public:
+  // @cond
+  class Engine;
+  // @endcond
+
+private:
+  ReaderOptions options_;
+  std::unique_ptr<Engine> engine_;
+  std::vector<ReadRequest> queued_;
+  std::deque<Completion> completed_; // reaped while making room for reads
+  size_t inFlight_ = 0;
+
+  void reap(size_t min);
+
+public:
+  /**
+   * @brief Constructs a reader
+   *
+   * @throws std::invalid_argument If the queue depth or number of threads is
+   * 0
+   * @throws std::system_error If io_uring is requested but unavailable
+   */
+  explicit AsyncReader(const ReaderOptions &options = ReaderOptions{});
+
+  AsyncReader(const AsyncReader &) = delete;
+  AsyncReader &operator=(const AsyncReader &) = delete;
+
+  /** @brief Waits for all submitted reads, discarding their completions */
+  ~AsyncReader();
+
+  /**
+   * @brief Queues a read
+   *
+   * Submits the queued reads first if the queue depth would otherwise be
+   * exceeded, waiting for earlier reads to complete if necessary.
+   *
+   * @param fd File descriptor to read from
+   * @param dst Destination buffer of at least bytes bytes
+   * @param bytes Number of bytes to read (at most 1 GiB are read at once)
+   * @param offset Offset in the file
+   * @param tag Value identifying the read in its completion
+   */
+  void read(int fd, void *dst, size_t bytes, uint64_t offset, uint64_t tag);
+
+  /** @brief Submits all queued reads */
+  void submit();
+
+  /**
+   * @brief Submits queued reads and waits for completions
+   *
+   * @param completions Vector to which completions are appended
+   * @param min Minimum number of completions to wait for, capped at the
+   * number of reads not yet reported
+   * @return The number of completions appended, including any that were
+   * already available
+   */
+  size_t wait(std::vector<Completion> &completions, size_t min = 1);
+
+  /** @brief Returns the number of reads not yet reported by wait */
+  inline size_t pending() const {
+    return queued_.size() + inFlight_ + completed_.size();
+  }
+
+  /** @brief Returns the backend in use (never AUTO) */
+  Backend backend() const;
+};
+
+/**
+ * @brief Reads NPY files concurrently (see read_numpy)
+ *
+ * Headers are read first, then data is read straight into the buffers of the
+ * resulting tensors.
+ *
+ * @param files The files to read
+ * @param options Options of the reader used
+ * @return The tensors, in the order of the files
+ * @throws std::runtime_error If a file cannot be read or is not supported by
+ * read_numpy
+ */
+std::vector<Tensor> readNumpy(const std::vector<std::string> &files,
+                              const ReaderOptions &options = ReaderOptions{});
+
+/**
+ * @brief Reads PGM images concurrently (see read_image)
+ *
+ * Each image is converted as soon as its read completes, while other reads
+ * are in flight.
+ *
+ * @param files The images to read
+ * @param options Options of the reader used
+ * @return The images, in the order of the files
+ * @throws std::runtime_error If a file cannot be read or is not an 8-bit
+ * binary PGM image
+ */
+std::vector<Tensor> readImages(const std::vector<std::string> &files,
+                               const ReaderOptions &options = ReaderOptions{});
+
+} // namespace io
+} // namespace gs
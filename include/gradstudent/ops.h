@@ -12,6 +12,7 @@
 
 #include <initializer_list>
 #include <tuple>
+#include <vector>
 
 #include "gradstudent/array.h"
 #include "gradstudent/tensor.h"
@@ -20,11 +21,88 @@ namespace gs {
 
 /* OPERATORS */
 
+/**
+ * @brief Computes scale * x + shift elementwise in a single pass.
+ *
+ * @param tensor The input tensor x
+ * @param scale The scale
+ * @param shift The shift
+ * @return Tensor
+ */
+Tensor affine(const Tensor &tensor, double scale, double shift);
+
+/* ELEMENTWISE MATH */
+
+/**
+ * @brief Computes the exponential elementwise.
+ *
+ * Large tensors are processed by multiple threads. Error is at most 1 ulp.
+ */
+Tensor exp(const Tensor &tensor);
+
+/**
+ * @brief Computes the natural logarithm elementwise.
+ *
+ * Large tensors are processed by multiple threads. Error is at most 1 ulp.
+ * Negative elements give NaN and zeros give -infinity.
+ */
+Tensor log(const Tensor &tensor);
+
+/**
+ * @brief Computes the hyperbolic tangent elementwise.
+ *
+ * Large tensors are processed by multiple threads. Error is at most 3 ulp.
+ */
+Tensor tanh(const Tensor &tensor);
+
 /* ACTIVATIONS */
 
 /** @brief Computes the ReLU activation elementwise */
 Tensor relu(const Tensor &tensor);
 
+/**
+ * @brief Computes the logistic sigmoid 1 / (1 + exp(-x)) elementwise
+ *
+ * Large tensors are processed by multiple threads. Error is at most 3 ulp.
+ */
+Tensor sigmoid(const Tensor &tensor);
+
+/**
+ * @brief Computes the GELU activation elementwise
+ *
+ * Uses the tanh approximation 0.5 x (1 + tanh(sqrt(2 / pi) (x + 0.044715
+ * x^3))). See vecGelu in internal/vecmath.h for error bounds.
+ */
+Tensor gelu(const Tensor &tensor);
+
+/**
+ * @brief Computes the softmax along an axis
+ *
+ * Each slice along the axis is mapped to exp(x - m) / s, where m is its
+ * maximum and s is the sum of exp(x - m), so that large inputs do not
+ * overflow. The maximum and sum are computed together in a single pass over
+ * the input and independent slices are processed in parallel.
+ *
+ * @param tensor The input tensor
+ * @param axis The axis to normalize over
+ * @return A tensor of the same shape whose slices along the axis sum to 1
+ * @throws std::invalid_argument If the axis is out of range
+ */
+Tensor softmax(const Tensor &tensor, size_t axis);
+
+/**
+ * @brief Computes the logarithm of the softmax along an axis
+ *
+ * Computed directly as x - m - log(s) (see softmax), which is accurate even
+ * where the softmax underflows.
+ *
+ * @param tensor The input tensor
+ * @param axis The axis to normalize over
+ * @return Tensor
+ * @throws std::invalid_argument If the axis is out of range
+ */
+Tensor logSoftmax(const Tensor &tensor, size_t axis);
+
 /* REDUCTIONS */
 
 /** Computes the argmax over all elements */
@@ -59,6 +137,21 @@ Tensor norm2(const Tensor &tensor);
 
 /* SLIDING WINDOW TRANSFORMS */
 
+/**
+ * @brief Stride, dilation and zero-padding of a convolution
+ *
+ * Each member is either empty, in which case the default applies along every
+ * convolved dimension, or has one entry per convolved dimension.
+ */
+struct ConvOptions {
+  /** @brief Step between consecutive windows (default 1) */
+  array_t stride;
+  /** @brief Step between consecutive kernel elements in a window (default 1) */
+  array_t dilation;
+  /** @brief Number of zeros implicitly added at both ends (default 0) */
+  array_t padding;
+};
+
 /**
  * @brief Computes the convolution of an input tensor with a kernel.
  *
@@ -77,10 +170,29 @@ Tensor norm2(const Tensor &tensor);
  * @param n The number of dimensions over which to perform the convolution.
  * @return Tensor
  * @todo Support broadcasting
- * @todo Support padding
  */
 Tensor conv(const Tensor &input, const Tensor &kernel, size_t n = 0);
 
+/**
+ * @brief Computes a strided, dilated and/or padded convolution.
+ *
+ * As conv, except that windows start every s_j elements, kernel elements are
+ * applied to every d_j-th input element and the input is treated as if
+ * extended by q_j zeros at both ends, where s, d and q are the stride,
+ * dilation and padding. The output then has p_j = (m_j + 2 q_j - d_j (k_j - 1)
+ * - 1) / s_j + 1. Padding is never materialized.
+ *
+ * @param input The input tensor
+ * @param kernel The kernel tensor
+ * @param options The stride, dilation and padding
+ * @param n The number of dimensions over which to perform the convolution.
+ * @return Tensor
+ * @throws std::invalid_argument If an option has the wrong size, a stride or
+ * dilation is zero, or the dilated kernel exceeds the padded input.
+ */
+Tensor conv(const Tensor &input, const Tensor &kernel,
+            const ConvOptions &options, size_t n = 0);
+
 /**
  * @brief Max pooling operation
  *
@@ -96,19 +208,373 @@ Tensor conv(const Tensor &input, const Tensor &kernel, size_t n = 0);
  */
 Tensor maxPool(const Tensor &input, const array_t &poolShape);
 
+/**
+ * @brief Window strides and zero-padding of a pooling operation
+ *
+ * Each member is either empty, in which case the default applies along every
+ * pooled dimension, or has one entry per pooled dimension.
+ */
+struct PoolOptions {
+  /** @brief Step between consecutive windows (default the window shape) */
+  array_t stride;
+  /** @brief Number of elements implicitly added at both ends (default 0) */
+  array_t padding;
+};
+
+/**
+ * @brief Max pooling with configurable strides and padding
+ *
+ * Pools over the trailing poolShape.size() dimensions of the input, treating
+ * any leading dimensions as a batch. Along each pooled dimension j the output
+ * has (m_j + 2 q_j - k_j) / s_j + 1 elements, where m, k, s and q are the
+ * input shape, window shape, stride and padding. Windows may overlap and need
+ * not cover the input. Padding elements never contribute to the result.
+ *
+ * @param input The input tensor
+ * @param poolShape The shape of the pooling window
+ * @param options The stride and padding
+ * @return Tensor
+ * @throws std::invalid_argument If an option has the wrong size, the window
+ * exceeds the padded input, or the padding is not smaller than the window.
+ */
+Tensor maxPool(const Tensor &input, const array_t &poolShape,
+               const PoolOptions &options);
+
+/**
+ * @brief Max pooling that also returns the location of each maximum
+ *
+ * As maxPool, additionally returning a tensor of the same shape as the result
+ * whose elements are the flat (row-major) indices into the input of the
+ * corresponding maxima. Ties are resolved in favour of the first maximum.
+ *
+ * @param input The input tensor
+ * @param poolShape The shape of the pooling window
+ * @param options The stride and padding
+ * @return The pooled tensor and the tensor of indices
+ */
+std::tuple<Tensor, Tensor>
+maxPoolWithIndices(const Tensor &input, const array_t &poolShape,
+                   const PoolOptions &options = PoolOptions{});
+
+/**
+ * @brief Gradient of max pooling with respect to its input
+ *
+ * Scatters each element of grad to the input position of the corresponding
+ * maximum, as returned by maxPoolWithIndices, summing the contributions of
+ * overlapping windows.
+ *
+ * @param grad The gradient with respect to the pooled tensor
+ * @param indices The indices returned by maxPoolWithIndices
+ * @param inputShape The shape of the pooled input
+ * @return A tensor of shape inputShape
+ * @throws std::invalid_argument If grad and indices have different shapes
+ */
+Tensor maxPoolBackward(const Tensor &grad, const Tensor &indices,
+                       const array_t &inputShape);
+
+/**
+ * @brief Average pooling
+ *
+ * Arguments and result are as for maxPool. Each output is the mean of the
+ * input elements in its window, excluding padding.
+ *
+ * @param input The input tensor
+ * @param poolShape The shape of the pooling window
+ * @param options The stride and padding
+ * @return Tensor
+ */
+Tensor avgPool(const Tensor &input, const array_t &poolShape,
+               const PoolOptions &options = PoolOptions{});
+
+/**
+ * @brief Global max pooling
+ *
+ * Computes the maximum over the trailing n dimensions of the input.
+ *
+ * @param input The input tensor
+ * @param n The number of pooled dimensions
+ * @return A tensor with the shape of the remaining leading dimensions
+ */
+Tensor globalMaxPool(const Tensor &input, size_t n);
+
+/**
+ * @brief Global average pooling
+ *
+ * Computes the mean over the trailing n dimensions of the input.
+ *
+ * @param input The input tensor
+ * @param n The number of pooled dimensions
+ * @return A tensor with the shape of the remaining leading dimensions
+ */
+Tensor globalAvgPool(const Tensor &input, size_t n);
+
+/* LAYOUT-AWARE OPERATIONS */
+
+/**
+ * @brief Memory layout of image tensors
+ *
+ * Images have shape (c, h, w) in NCHW layout and (h, w, c) in NHWC layout,
+ * optionally preceded by a batch dimension.
+ */
+enum class Layout { NCHW, NHWC };
+
+/**
+ * @brief Computes a 2D convolution of images in the given layout.
+ *
+ * The output is produced directly in the same layout as the input, with one
+ * channel per filter, so that consecutive layers need no permutes. Padding is
+ * never materialized.
+ *
+ * @param input The input images, of shape ([n,] c, h, w) for NCHW or
+ * ([n,] h, w, c) for NHWC
+ * @param kernel The kernel, of shape (f, c, kh, kw) for NCHW or (f, kh, kw, c)
+ * for NHWC
+ * @param layout The layout of the input, kernel and output
+ * @param options The stride, dilation and padding, each of size 2 or empty
+ * @return The output images, of shape ([n,] f, p, q) for NCHW or
+ * ([n,] p, q, f) for NHWC
+ * @throws std::invalid_argument If the shapes or options are incompatible
+ */
+Tensor conv(const Tensor &input, const Tensor &kernel, Layout layout,
+            const ConvOptions &options = ConvOptions{});
+
+/**
+ * @brief 2D max pooling of images in the given layout
+ *
+ * Pools over the spatial dimensions, as maxPool does over trailing dimensions.
+ * The output has the same layout as the input.
+ *
+ * @param input The input images, of shape ([n,] c, h, w) for NCHW or
+ * ([n,] h, w, c) for NHWC
+ * @param poolShape The shape of the pooling window, of size 2
+ * @param layout The layout of the input and output
+ * @param options The stride and padding
+ * @return Tensor
+ */
+Tensor maxPool(const Tensor &input, const array_t &poolShape, Layout layout,
+               const PoolOptions &options = PoolOptions{});
+
+/**
+ * @brief 2D max pooling of images that also returns the location of each
+ * maximum
+ *
+ * Arguments are as for the layout-aware maxPool and results as for
+ * maxPoolWithIndices.
+ */
+std::tuple<Tensor, Tensor>
+maxPoolWithIndices(const Tensor &input, const array_t &poolShape,
+                   Layout layout, const PoolOptions &options = PoolOptions{});
+
+/**
+ * @brief 2D average pooling of images in the given layout
+ *
+ * Arguments and result are as for the layout-aware maxPool.
+ */
+Tensor avgPool(const Tensor &input, const array_t &poolShape, Layout layout,
+               const PoolOptions &options = PoolOptions{});
+
+/**
+ * @brief Adds a per-channel bias to images in the given layout
+ *
+ * @param input The input images, of shape ([n,] c, h, w) for NCHW or
+ * ([n,] h, w, c) for NHWC
+ * @param bias The bias, of shape (c,)
+ * @param layout The layout of the input and output
+ * @return Tensor
+ */
+Tensor addBias(const Tensor &input, const Tensor &bias, Layout layout);
+
+/* FUSED OPERATIONS */
+
+/** @brief Activation functions supported by fused kernels */
+enum class Activation { NONE, RELU };
+
+/** @brief Pooling reductions supported by fused kernels */
+enum class PoolType { NONE, MAX, AVG };
+
+/**
+ * @brief Elementwise operations applied to the output of a fused convolution
+ *
+ * The convolution output is offset by the bias, passed through the activation
+ * function and reduced over disjoint pooling windows, in that order.
+ */
+struct ConvEpilogue {
+  /** @brief Activation function */
+  Activation activation = Activation::NONE;
+  /** @brief Pooling reduction */
+  PoolType pool = PoolType::NONE;
+  /** @brief Pooling window shape (ignored if pool is NONE) */
+  array_t poolShape;
+};
+
+/**
+ * @brief Computes a 2D convolution followed by bias, activation and pooling.
+ *
+ * Equivalent to (but faster than) applying conv with n = 2, adding the bias
+ * along the channel dimension, applying the activation and pooling each
+ * channel. The epilogue is applied to each convolution output while it is
+ * still in registers, so no intermediate tensors are created.
+ *
+ * The input has shape (h, w, c) and the kernel has shape (f, kh, kw, c). The
+ * output has shape (p, q, f), where (p, q) is (h - kh + 1, w - kw + 1)
+ * divided by the pooling window shape.
+ *
+ * @param input The input tensor, with channels last
+ * @param kernel The kernel tensor, with filters first and channels last
+ * @param bias The bias tensor, of shape (f,)
+ * @param epilogue The operations to apply to the convolution output
+ * @return Tensor
+ * @throws std::invalid_argument If the shapes are incompatible or the pooling
+ * window is empty or does not divide the convolution output shape.
+ */
+Tensor convBlock(const Tensor &input, const Tensor &kernel, const Tensor &bias,
+                 const ConvEpilogue &epilogue);
+
+/* INDEXING */
+
+/**
+ * @brief Gathers elements along an axis
+ *
+ * For an axis of 1, result[i][j][k] = tensor[i][indices[i][j][k]][k], and
+ * likewise for other axes and ranks. Indices are integral values stored as
+ * doubles (as returned by maxPoolWithIndices). Rows of the result are
+ * processed in parallel.
+ *
+ * @param tensor The tensor to gather from
+ * @param axis The axis along which to index
+ * @param indices Indices into the axis, of the shape of the tensor except
+ * along the axis
+ * @return A tensor of the shape of the indices
+ * @throws std::invalid_argument If the axis is out of range, the indices do
+ * not have the expected shape or an index is out of range or not an integer
+ */
+Tensor gather(const Tensor &tensor, size_t axis, const Tensor &indices);
+
+/**
+ * @brief Scatters elements along an axis
+ *
+ * The inverse of gather: returns a copy of the tensor in which, for an axis
+ * of 1, result[i][indices[i][j][k]][k] = src[i][j][k]. Where indices repeat,
+ * the last element written (in row-major order of the indices) wins. Disjoint
+ * regions of the result are written in parallel.
+ *
+ * @param tensor The tensor to scatter into
+ * @param axis The axis along which to index
+ * @param indices Indices into the axis, of the shape of the tensor except
+ * along the axis
+ * @param src The elements to scatter, of the shape of the indices
+ * @return A tensor of the shape of the tensor
+ * @throws std::invalid_argument If the axis is out of range, the indices or
+ * source do not have the expected shape or an index is out of range or not
+ * an integer
+ */
+Tensor scatter(const Tensor &tensor, size_t axis, const Tensor &indices,
+               const Tensor &src);
+
+/**
+ * @brief Scatters elements along an axis, summing them
+ *
+ * As scatter, adding the elements of src to the copy of the tensor instead
+ * of overwriting them. Each element of the result is owned by a single
+ * thread, which adds its contributions in row-major order of the indices, so
+ * results do not depend on the number of threads.
+ */
+Tensor scatterAdd(const Tensor &tensor, size_t axis, const Tensor &indices,
+                  const Tensor &src);
+
+/**
+ * @brief Selects slices along an axis
+ *
+ * Slice i of the result along the axis is slice indices[i] of the tensor
+ * (e.g. rows of an embedding table for an axis of 0). Slices are copied as
+ * contiguous rows, in parallel.
+ *
+ * @param tensor The tensor to select from
+ * @param axis The axis along which to index
+ * @param indices A rank 1 tensor of indices into the axis
+ * @return A tensor of the shape of the tensor, except along the axis, whose
+ * size is that of the indices
+ * @throws std::invalid_argument If the axis is out of range, the indices are
+ * not of rank 1 or an index is out of range or not an integer
+ */
+Tensor indexSelect(const Tensor &tensor, size_t axis, const Tensor &indices);
+
+/**
+ * @brief Adds slices along an axis
+ *
+ * The adjoint of indexSelect: returns a copy of the tensor to which slice i
+ * of src along the axis is added at slice indices[i]. As for scatterAdd,
+ * each slice of the result is owned by a single thread.
+ *
+ * @param tensor The tensor to add into
+ * @param axis The axis along which to index
+ * @param indices A rank 1 tensor of indices into the axis
+ * @param src The slices to add, of the shape of indexSelect(tensor, axis,
+ * indices)
+ * @return A tensor of the shape of the tensor
+ * @throws std::invalid_argument If the axis is out of range, the indices or
+ * source do not have the expected shape or an index is out of range or not
+ * an integer
+ */
+Tensor indexAdd(const Tensor &tensor, size_t axis, const Tensor &indices,
+                const Tensor &src);
+
+/* JOINING */
+
+/**
+ * @brief Concatenates tensors along an axis
+ *
+ * The result is allocated once and each tensor is copied straight into its
+ * part of it (see split) by the strided copy engine, which reduces copies of
+ * contiguous data to memcpy. Many tensors are copied in parallel, and large
+ * ones are split across threads.
+ *
+ * @param tensors The tensors, which must have the same shape except along the
+ * axis
+ * @param axis The axis along which to concatenate
+ * @return The concatenated tensor
+ * @throws std::invalid_argument If there are no tensors, the axis is out of
+ * range or the shapes do not match
+ */
+Tensor concat(const std::vector<const Tensor *> &tensors, size_t axis);
+
+/**
+ * @brief Stacks tensors along a new axis
+ *
+ * As concat, copying the tensors into the views of the result returned by
+ * unstack.
+ *
+ * @param tensors The tensors, which must have the same shape
+ * @param axis The position of the new axis in the result
+ * @return A tensor whose slice i along the axis is tensor i
+ * @throws std::invalid_argument If there are no tensors, the axis exceeds
+ * their rank or their shapes differ
+ */
+Tensor stack(const std::vector<const Tensor *> &tensors, size_t axis = 0);
+
 /* VIEWS */
 
 /**
  * @brief Flattens a tensor.
  *
- * Produces a new tensor with a single dimension containing all
- * the elements of the original tensor.
+ * Produces a tensor with a single dimension containing all the elements of the
+ * original tensor in lexicographic order. The result is a read-only view of
+ * the original tensor when its strides allow it (see Tensor::reshape) and a
+ * compact copy otherwise.
  *
  * @param tensor The tensor to be flattened.
  * @return The flattened tensor.
  */
 Tensor flatten(const Tensor &tensor);
 
+/**
+ * @overload
+ *
+ * @param tensor The tensor to be flattened.
+ * @param[out] copied Set to true if the result is a copy rather than a view.
+ */
+Tensor flatten(const Tensor &tensor, bool &copied);
+
 /**
  * @brief Permutes the dimensions of a tensor.
  *
@@ -169,6 +635,43 @@ Tensor slice(Tensor &tensor, const array_t &mIdx);
  */
 const Tensor slice(const Tensor &tensor, const array_t &mIdx);
 
+/**
+ * @brief Splits a tensor into consecutive parts along an axis
+ *
+ * Produces views of the original tensor, so that results can be written
+ * straight into their final positions of a preallocated tensor (e.g. by
+ * several producers), with no concatenation afterwards.
+ *
+ * @param tensor The tensor to be split
+ * @param sizes The sizes of the parts along the axis, which must add up to the
+ * size of the axis
+ * @param axis The axis along which to split
+ * @return The parts, in order
+ * @throws std::invalid_argument If the axis is out of range or the sizes do
+ * not add up to the size of the axis
+ */
+std::vector<Tensor> split(Tensor &tensor, const std::vector<size_t> &sizes,
+                          size_t axis);
+
+/** @overload */
+std::vector<Tensor> split(const Tensor &tensor,
+                          const std::vector<size_t> &sizes, size_t axis);
+
+/**
+ * @brief Splits a tensor into its slices along an axis
+ *
+ * Produces views of the original tensor, with the axis removed (see split).
+ *
+ * @param tensor The tensor to be split
+ * @param axis The axis along which to split
+ * @return The slices, in order
+ * @throws std::invalid_argument If the axis is out of range
+ */
+std::vector<Tensor> unstack(Tensor &tensor, size_t axis);
+
+/** @overload */
+std::vector<Tensor> unstack(const Tensor &tensor, size_t axis);
+
 /**
  * @brief Broadcasts a tensor to a given shape.
  *
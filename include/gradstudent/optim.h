@@ -0,0 +1,149 @@
+/**
+ * @file optim.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Fused optimizers
+ * @version 0.1
+ * @date 2024-05-31
+ *
+ * @copyright Copyright (c) 2024
+ *
+ * Optimizers update parameters in place from gradient buffers, such as those
+ * passed to Tape::variable. A step visits every parameter in a single
+ * multi-threaded launch, in which each element of the parameters, gradients
+ * and optimizer state is read once and written at most once.
+ */
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "gradstudent/tensor.h"
+
+namespace gs {
+namespace optim {
+
+/**
+ * @brief Base class of optimizers
+ *
+ * Parameters and gradients are held by pointer and must outlive the
+ * optimizer. Both must be contiguous and parameters must not be read-only
+ * views, so that they can be updated in place.
+ */
+class Optimizer {
+
+protected:
+  std::vector<Tensor *> params_;
+  std::vector<Tensor *> grads_;
+  size_t steps_ = 0;
+
+  /**
+   * @throws std::invalid_argument If the numbers or shapes of parameters and
+   * gradients differ or a tensor is not contiguous or is read-only
+   */
+  Optimizer(std::vector<Tensor *> params, std::vector<Tensor *> grads);
+
+public:
+  Optimizer(const Optimizer &) = delete;
+  Optimizer &operator=(const Optimizer &) = delete;
+
+  virtual ~Optimizer() = default;
+
+  /** @brief Updates all parameters from their gradients */
+  virtual void step() = 0;
+
+  /** @brief Sets all gradients to zero */
+  void zeroGrad();
+
+  /** @brief Returns the number of steps taken */
+  inline size_t steps() const { return steps_; }
+};
+
+/** @brief Hyperparameters of SGD */
+struct SGDOptions {
+  /** @brief Learning rate */
+  double lr = 0.01;
+  /** @brief Momentum factor (0 disables momentum and its state) */
+  double momentum = 0;
+  /** @brief L2 penalty added to the gradient */
+  double weightDecay = 0;
+  /** @brief Whether to use Nesterov momentum */
+  bool nesterov = false;
+};
+
+/**
+ * @brief Stochastic gradient descent with momentum
+ *
+ * With gradient g, parameter p and velocity b (initially zero), each step
+ * computes g' = g + weightDecay p and b = momentum b + g', then updates
+ * p -= lr d, where d is b, or g' + momentum b with Nesterov momentum.
+ */
+class SGD : public Optimizer {
+
+private:
+  SGDOptions options_;
+  std::vector<Tensor> velocity_;
+
+public:
+  /**
+   * @brief Constructs an optimizer for the given parameters
+   *
+   * @param params The parameters
+   * @param grads The gradients, in the same order
+   * @param options The hyperparameters
+   * @throws std::invalid_argument If the arguments are invalid (see
+   * Optimizer)
+   */
+  SGD(std::vector<Tensor *> params, std::vector<Tensor *> grads,
+      const SGDOptions &options = SGDOptions{});
+
+  void step() override;
+};
+
+/** @brief Hyperparameters of Adam */
+struct AdamOptions {
+  /** @brief Learning rate */
+  double lr = 1e-3;
+  /** @brief Decay rate of the first moment estimate */
+  double beta1 = 0.9;
+  /** @brief Decay rate of the second moment estimate */
+  double beta2 = 0.999;
+  /** @brief Term added to the denominator for numerical stability */
+  double eps = 1e-8;
+  /** @brief Decoupled weight decay (as in AdamW) */
+  double weightDecay = 0;
+};
+
+/**
+ * @brief Adam optimizer with decoupled weight decay
+ *
+ * With gradient g, parameter p and moment estimates m and v (initially zero),
+ * step t computes m = beta1 m + (1 - beta1) g and
+ * v = beta2 v + (1 - beta2) g^2, then updates
+ * p = (1 - lr weightDecay) p - lr / c1 * m / (sqrt(v) / sqrt(c2) + eps), where
+ * c1 = 1 - beta1^t and c2 = 1 - beta2^t correct the bias of the estimates.
+ */
+class Adam : public Optimizer {
+
+private:
+  AdamOptions options_;
+  std::vector<Tensor> m_;
+  std::vector<Tensor> v_;
+
+public:
+  /**
+   * @brief Constructs an optimizer for the given parameters
+   *
+   * @param params The parameters
+   * @param grads The gradients, in the same order
+   * @param options The hyperparameters
+   * @throws std::invalid_argument If the arguments are invalid (see
+   * Optimizer)
+   */
+  Adam(std::vector<Tensor *> params, std::vector<Tensor *> grads,
+       const AdamOptions &options = AdamOptions{});
+
+  void step() override;
+};
+
+} // namespace optim
+} // namespace gs
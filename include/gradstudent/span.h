@@ -0,0 +1,161 @@
+/**
+ * @file span.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Raw strided tensor accessors
+ * @version 0.1
+ * @date 2024-05-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <array>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+#include "gradstudent/tensor.h"
+
+namespace gs {
+
+/**
+ * @brief Strided view of a tensor's data buffer with a fixed rank
+ *
+ * Exposes the data pointer, shape and strides of a tensor for use in custom
+ * kernels. Unlike Tensor::operator[], which checks writability on every call,
+ * a mutable TensorSpan performs the copy-on-write check once, on construction.
+ * Since the rank is a template parameter, multi-index computations unroll to
+ * plain pointer arithmetic.
+ *
+ * A span does not own its data. It remains valid as long as the tensor it was
+ * constructed from is neither destroyed nor written to through a copy-on-write
+ * path (e.g. Tensor::operator[] on a read-only view).
+ *
+ * @tparam N The tensor rank
+ * @tparam Const Whether the span provides read-only access
+ */
+template <size_t N, bool Const = false> class TensorSpan {
+
+public:
+  /** @brief Possibly const element type */
+  using element_type = std::conditional_t<Const, const double, double>;
+
+  /** @brief Possibly const type of the tensor accessed by the span */
+  using tensor_type = std::conditional_t<Const, const Tensor, Tensor>;
+
+  /** @brief Fixed-size index type */
+  using index_type = std::array<size_t, N>;
+
+  /**
+   * @brief Construct a new TensorSpan object
+   *
+   * If the span is mutable and the tensor is a read-only view, the tensor's
+   * data is copied first (see Tensor).
+   *
+   * @param tensor The tensor to access
+   * @throws std::invalid_argument If the tensor rank is not N
+   */
+  explicit TensorSpan(tensor_type &tensor) {
+    if (tensor.ndims() != N) {
+      std::stringstream ss;
+      ss << "Expected tensor of rank " << N << ", got rank " << tensor.ndims();
+      throw std::invalid_argument(ss.str());
+    }
+    if constexpr (!Const) {
+      tensor.ensureWritable();
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    data_ = tensor.data_.get() + tensor.offset_;
+    for (size_t i = 0; i < N; ++i) {
+      shape_[i] = tensor.shape_[i];
+      strides_[i] = tensor.strides_[i];
+    }
+  }
+
+  /** @brief Returns a pointer to the element at the all-zero multi-index */
+  element_type *data() const { return data_; }
+
+  /** @brief Returns the span shape */
+  const index_type &shape() const { return shape_; }
+
+  /** @brief Returns the span strides */
+  const index_type &strides() const { return strides_; }
+
+  /** @brief Returns the size of the given dimension */
+  size_t extent(size_t i) const { return shape_[i]; }
+
+  /** @brief Returns the stride of the given dimension */
+  size_t stride(size_t i) const { return strides_[i]; }
+
+  /** @brief Returns the number of elements */
+  size_t size() const {
+    size_t result = 1;
+    for (size_t i = 0; i < N; ++i) {
+      result *= shape_[i];
+    }
+    return result;
+  }
+
+  /** @brief Returns true if the span has default (row-major) strides */
+  bool contiguous() const {
+    size_t expected = 1;
+    for (size_t i = N; i-- > 0;) {
+      if (shape_[i] != 1 && strides_[i] != expected) {
+        return false;
+      }
+      expected *= shape_[i];
+    }
+    return true;
+  }
+
+  /**
+   * @brief Element access
+   *
+   * Does not perform bounds checking.
+   *
+   * @param idx N indices, one per dimension
+   */
+  template <typename... Idx> element_type &operator()(Idx... idx) const {
+    static_assert(sizeof...(Idx) == N, "Expected one index per dimension");
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return data_[offsetHelper(std::make_index_sequence<N>{},
+                              static_cast<size_t>(idx)...)];
+  }
+
+  /** @overload */
+  element_type &operator[](const index_type &idx) const {
+    size_t offset = 0;
+    for (size_t i = 0; i < N; ++i) {
+      offset += idx[i] * strides_[i];
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return data_[offset];
+  }
+
+private:
+  element_type *data_{};
+  index_type shape_{};
+  index_type strides_{};
+
+  template <size_t... Is, typename... Idx>
+  size_t offsetHelper(std::index_sequence<Is...>, Idx... idx) const {
+    return ((idx * strides_[Is]) + ... + 0);
+  }
+};
+
+/**
+ * @brief Constructs a mutable span of the given rank
+ *
+ * @tparam N The tensor rank
+ */
+template <size_t N> TensorSpan<N> makeSpan(Tensor &tensor) {
+  return TensorSpan<N>(tensor);
+}
+
+/** @overload */
+template <size_t N> TensorSpan<N, true> makeSpan(const Tensor &tensor) {
+  return TensorSpan<N, true>(tensor);
+}
+
+} // namespace gs
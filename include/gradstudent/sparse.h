@@ -0,0 +1,124 @@
+/**
+ * @file sparse.h
+ * @author Ben Wallace (me@bcwallace.com)
+ * @brief Sparse matrices
+ * @version 0.1
+ * @date 2024-06-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "gradstudent/tensor.h"
+
+namespace gs {
+
+/**
+ * @brief A sparse matrix in block compressed sparse row (BSR) format
+ *
+ * The matrix is divided into blocks of blockRows x blockCols elements, of
+ * which only those holding a nonzero element are stored, block row by block
+ * row, as dense row-major blocks. Blocks of 1 x 1 give the compressed sparse
+ * row (CSR) format. Larger blocks suit weights pruned in blocks: they need
+ * fewer indices, and products with them are vectorized within each block.
+ * Blocks on the last block row or column may extend past the matrix, in
+ * which case their extra elements are zero.
+ *
+ * Memory and the cost of products are proportional to the number of stored
+ * blocks rather than to the size of the matrix.
+ */
+class SparseMatrix {
+
+private:
+  size_t rows_;
+  size_t cols_;
+  size_t blockRows_;
+  size_t blockCols_;
+  std::vector<size_t> rowStarts_;    // first block of each block row, and end
+  std::vector<size_t> blockColumns_; // block column of each block
+  std::vector<double> values_;       // elements of the blocks, row-major
+
+  SparseMatrix(size_t rows, size_t cols, size_t blockRows, size_t blockCols);
+
+public:
+  /**
+   * @brief Converts a dense matrix to CSR format
+   *
+   * @param dense A rank 2 tensor
+   * @param threshold Elements of at most this magnitude are dropped
+   * @throws std::invalid_argument If the tensor is not of rank 2
+   */
+  static SparseMatrix fromDense(const Tensor &dense, double threshold = 0);
+
+  /**
+   * @brief Converts a dense matrix to BSR format
+   *
+   * Elements of magnitude at most the threshold are treated as zero, and
+   * blocks holding only such elements are dropped.
+   *
+   * @param dense A rank 2 tensor
+   * @param blockRows The number of rows of each block
+   * @param blockCols The number of columns of each block
+   * @param threshold Elements of at most this magnitude are dropped
+   * @throws std::invalid_argument If the tensor is not of rank 2 or a block
+   * dimension is 0
+   */
+  static SparseMatrix fromDense(const Tensor &dense, size_t blockRows,
+                                size_t blockCols, double threshold = 0);
+
+  /** @brief Returns the matrix as a dense tensor */
+  Tensor toDense() const;
+
+  /** @brief Returns the number of rows */
+  inline size_t rows() const { return rows_; }
+
+  /** @brief Returns the number of columns */
+  inline size_t cols() const { return cols_; }
+
+  /** @brief Returns the number of rows of each block */
+  inline size_t blockRows() const { return blockRows_; }
+
+  /** @brief Returns the number of columns of each block */
+  inline size_t blockCols() const { return blockCols_; }
+
+  /** @brief Returns the number of stored blocks */
+  inline size_t blocks() const { return blockColumns_.size(); }
+
+  /**
+   * @brief Returns the number of stored elements
+   *
+   * This is blocks() * blockRows() * blockCols(), which counts zeros within
+   * stored blocks (including padding past the matrix), so that in BSR format
+   * it may exceed the number of nonzero elements.
+   */
+  inline size_t storedElements() const { return values_.size(); }
+
+  /** @brief Returns the number of bytes used by the stored blocks */
+  size_t bytes() const;
+
+  friend Tensor dot(const SparseMatrix &left, const Tensor &right);
+};
+
+/**
+ * @brief Computes the product of a sparse matrix and a tensor
+ *
+ * As dot for dense tensors, contracting the columns of the matrix with the
+ * first axis of the tensor. A tensor of rank 1 gives a matrix-vector product
+ * (SpMV), and other tensors a matrix-matrix product (SpMM) with the remaining
+ * axes flattened into columns, each stored block updating rows of the result
+ * with vectorized row operations. Block rows are processed in parallel.
+ *
+ * @param left The sparse matrix
+ * @param right A tensor whose first axis matches the columns of the matrix
+ * @return A tensor of shape {left.rows()} followed by the remaining axes of
+ * right
+ * @throws std::invalid_argument If right is a scalar or its first axis does
+ * not match the columns of the matrix
+ */
+Tensor dot(const SparseMatrix &left, const Tensor &right);
+
+} // namespace gs
@@ -43,6 +43,7 @@ private:
 
 public:
   template <bool... Const> friend class TensorIter;
+  template <size_t N, bool Const> friend class TensorSpan;
 
   /* CONSTRUCTORS */
 
@@ -81,6 +82,16 @@ public:
    */
   Tensor(const array_t &shape, const array_t &strides);
 
+  /**
+   * @brief External buffer constructor
+   *
+   * Constructs a tensor with the given shape and default strides over an
+   * existing buffer of at least as many elements, which is shared rather than
+   * copied (e.g. memory mapped from a shared-memory segment). The buffer's
+   * deleter runs when the last tensor using it is destroyed.
+   */
+  Tensor(const array_t &shape, std::shared_ptr<double[]> data);
+
   /**
    * @brief Scalar tensor constructor.
    *
@@ -212,14 +223,24 @@ public:
   /**
    * @brief Reshapes the tensor
    *
-   * Returns a view of the tensor with the given shape, whose corresponding
-   * size must be the same as the tensor size.
+   * Returns a tensor with the given shape, whose corresponding size must be
+   * the same as the tensor size. When the tensor's strides allow it (e.g. when
+   * the tensor is contiguous or the reshaped dimensions are contiguous), the
+   * result is a view of the tensor. Otherwise, the result is a compact copy.
    *
    * @param shape The new shape
    * @return Tensor
    */
   Tensor reshape(const array_t &shape);
 
+  /**
+   * @overload
+   *
+   * @param shape The new shape
+   * @param[out] copied Set to true if the result is a copy rather than a view
+   */
+  Tensor reshape(const array_t &shape, bool &copied);
+
   /**
    * @brief Returns a view of the tensor with the given shape and strides.
    * The shape and strides arrays must have the same size and the size corresponding
@@ -234,6 +255,9 @@ public:
   /** @overload */
   const Tensor reshape(const array_t &shape) const;
 
+  /** @overload */
+  const Tensor reshape(const array_t &shape, bool &copied) const;
+
   /** @overload */
   const Tensor reshape(const array_t &shape, const array_t &strides) const;
 
@@ -285,6 +309,40 @@ public:
    */
   friend Tensor operator*(const Tensor &, const Tensor &);
 
+  /**
+   * @brief Element-wise division operator for tensors.
+   *
+   * Tensors must be broadcastable. Division is correctly rounded.
+   *
+   * @return The result of element-wise division of the two tensors.
+   * @throws std::invalid_argument If the tensors cannot be broadcasted.
+   */
+  friend Tensor operator/(const Tensor &, const Tensor &);
+
+  /**
+   * @brief Scalar operators for tensors.
+   *
+   * Apply the operation to each element of the tensor and the scalar, without
+   * constructing and broadcasting a scalar tensor.
+   *
+   * @return The result of the element-wise operation.
+   */
+  friend Tensor operator+(const Tensor &, double);
+  /** @overload */
+  friend Tensor operator+(double, const Tensor &);
+  /** @overload */
+  friend Tensor operator-(const Tensor &, double);
+  /** @overload */
+  friend Tensor operator-(double, const Tensor &);
+  /** @overload */
+  friend Tensor operator*(const Tensor &, double);
+  /** @overload */
+  friend Tensor operator*(double, const Tensor &);
+  /** @overload */
+  friend Tensor operator/(const Tensor &, double);
+  /** @overload */
+  friend Tensor operator/(double, const Tensor &);
+
   /**
    * @brief Equality operator for tensors.
    * @return True if the two tensors have the same shape and are element-wise
@@ -15,7 +15,9 @@ Array::Array(std::initializer_list<size_t> data)
     : Array(std::vector<size_t>(data)) {}
 
 Array::Array(const std::vector<size_t> &data) : Array(data.size(), sentinel{}) {
-  std::memcpy(data_.get(), data.data(), size_ * sizeof(size_t));
+  if (size_ > 0) {
+    std::memcpy(data_.get(), data.data(), size_ * sizeof(size_t));
+  }
 }
 
 // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+#include "gradstudent/internal/autograd.h"
+
+namespace gs {
+namespace ad {
+
+namespace {
+
+// Records the inputs of a segment on a temporary tape, as variables if
+// withGrad is set and they require gradients, and as constants otherwise
+std::vector<Var> recordInputs(Tape &tape, const Segment &segment,
+                              bool withGrad) {
+  std::vector<Var> result;
+  result.reserve(segment.inputs.size());
+  for (Node *input : segment.inputs) {
+    const Tensor &value = *input->value;
+    result.push_back(withGrad && input->requiresGrad ? tape.variable(value)
+                                                     : tape.constant(value));
+  }
+  return result;
+}
+
+void addStats(RecomputeStats &dst, const RecomputeStats &src) {
+  dst.segments += src.segments;
+  dst.nodes += src.nodes;
+  dst.seconds += src.seconds;
+}
+
+} // namespace
+
+void checkpointBackward(Node &node) {
+  const Segment &segment = *node.segment;
+  Tape tape;
+  std::vector<Var> inputs = recordInputs(tape, segment, true);
+
+  auto start = std::chrono::steady_clock::now();
+  Var output = segment.function(inputs);
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  RecomputeStats &stats = segment.tape->recomputeStats();
+  stats.segments += 1;
+  stats.nodes += tape.size() - inputs.size();
+  stats.seconds += elapsed.count();
+
+  if (output.requiresGrad()) {
+    tape.backward(output, *node.grad);
+    // nested checkpoints were recomputed on the temporary tape
+    addStats(stats, tape.recomputeStats());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      const std::optional<Tensor> &grad = inputs[i].node()->grad;
+      if (grad) {
+        accumulate(*segment.inputs[i], *grad);
+      }
+    }
+  }
+}
+
+Var checkpoint(const Function &function, const std::vector<Var> &inputs) {
+  if (inputs.empty()) {
+    throw std::invalid_argument("Checkpoint requires at least one input");
+  }
+  Tape &outer = inputs[0].tape();
+  auto segment = std::make_unique<Segment>();
+  segment->function = function;
+  segment->tape = &outer;
+  for (const Var &input : inputs) {
+    if (&input.tape() != &outer) {
+      throw std::invalid_argument("Vars were recorded on different tapes");
+    }
+    segment->inputs.push_back(input.node());
+  }
+
+  // intermediates are released with the temporary tape
+  Tape tape;
+  Var output = function(recordInputs(tape, *segment, false));
+  Node *node = outer.arena().create<Node>(Op::CHECKPOINT, output.value());
+  for (Node *input : segment->inputs) {
+    node->requiresGrad = node->requiresGrad || input->requiresGrad;
+  }
+  node->segment = std::move(segment);
+  return {&outer, outer.record(node)};
+}
+
+Var checkpointSequential(const std::vector<Function> &layers, const Var &input,
+                         const std::vector<Var> &params, size_t segments) {
+  auto apply = [](const std::vector<Function> &group, Var x,
+                  const std::vector<Var> &params) {
+    std::vector<Var> args{x};
+    args.insert(args.end(), params.begin(), params.end());
+    for (const Function &layer : group) {
+      args[0] = layer(args);
+    }
+    return args[0];
+  };
+  if (segments == 0) {
+    return apply(layers, input, params);
+  }
+
+  segments = std::min(segments, layers.size());
+  Var x = input;
+  for (size_t j = 0; j < segments; ++j) {
+    std::vector<Function> group(
+        layers.begin() + static_cast<ptrdiff_t>(j * layers.size() / segments),
+        layers.begin() +
+            static_cast<ptrdiff_t>((j + 1) * layers.size() / segments));
+    std::vector<Var> inputs{x};
+    inputs.insert(inputs.end(), params.begin(), params.end());
+    x = checkpoint(
+        [group, apply](const std::vector<Var> &args) {
+          return apply(group, args[0],
+                       std::vector<Var>(args.begin() + 1, args.end()));
+        },
+        inputs);
+  }
+  return x;
+}
+
+} // namespace ad
+} // namespace gs
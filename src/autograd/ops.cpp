@@ -0,0 +1,447 @@
+#include <cmath>
+#include <sstream>
+
+#include "gradstudent/internal/autograd.h"
+#include "gradstudent/internal/conv.h"
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/iter.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+namespace ad {
+
+namespace {
+
+/* RECORDING */
+
+Var record(Op op, const Tensor &value, const Var &input) {
+  Tape &tape = input.tape();
+  return {&tape, tape.record(tape.arena().create<Node>(op, value,
+                                                        input.node()))};
+}
+
+Var record(Op op, const Tensor &value, const Var &left, const Var &right) {
+  if (&left.tape() != &right.tape()) {
+    throw std::invalid_argument("Vars were recorded on different tapes");
+  }
+  Tape &tape = left.tape();
+  return {&tape, tape.record(tape.arena().create<Node>(
+                     op, value, left.node(), right.node()))};
+}
+
+Var recordScalar(Op op, const Tensor &value, const Var &input, double scalar) {
+  Var result = record(op, value, input);
+  result.node()->scalar = scalar;
+  return result;
+}
+
+/* GRADIENT KERNELS */
+
+// Computes f(g, x) elementwise over tensors of the same shape
+template <typename F>
+Tensor zip(const Tensor &grad, const Tensor &x, F f) {
+  Tensor result(grad.shape());
+  if (!isContiguous(grad) || !isContiguous(x)) {
+    for (const auto &[r, g, v] : TensorIter(result, grad, x)) {
+      r = f(g, v);
+    }
+    return result;
+  }
+  const Tensor g = flatten(grad);
+  const Tensor v = flatten(x);
+  const double *gData = makeSpan<1>(g).data();
+  const double *vData = makeSpan<1>(v).data();
+  double *out = mutableData(result);
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  parallelFor(result.size(), 1 << 16, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      out[i] = f(gData[i], vData[i]);
+    }
+  });
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result;
+}
+
+// Gradient of softmax (or log-softmax) along an axis given its output y:
+// y * (g - sum(g * y)) (respectively g - exp(y) * sum(g))
+Tensor softmaxGrad(const Tensor &grad, const Tensor &y, size_t axis,
+                   bool log) {
+  const array_t &shape = y.shape();
+  const size_t n = shape[axis];
+  const size_t inner = prod(shape.sliceFrom(axis + 1));
+  const size_t outer = prod(shape.sliceTo(axis));
+  const Tensor g = flatten(grad);
+  const Tensor v = flatten(y);
+  const double *gData = makeSpan<1>(g).data();
+  const double *yData = makeSpan<1>(v).data();
+  Tensor result(array_t{y.size()});
+  double *out = makeSpan<1>(result).data();
+
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  parallelFor(outer * inner, (1 << 14) / n + 1, [&](size_t begin, size_t end) {
+    for (size_t t = begin; t < end; ++t) {
+      size_t base = (t / inner) * n * inner + t % inner;
+      double s = 0;
+      for (size_t j = 0; j < n; ++j) {
+        size_t i = base + j * inner;
+        s += log ? gData[i] : gData[i] * yData[i];
+      }
+      for (size_t j = 0; j < n; ++j) {
+        size_t i = base + j * inner;
+        out[i] = log ? gData[i] - std::exp(yData[i]) * s
+                     : yData[i] * (gData[i] - s);
+      }
+    }
+  });
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result.reshape(shape);
+}
+
+// Gradients of dot(a, b) viewed as a matrix product of shape (m, k) x (k, n).
+// Both are GEMMs that read the transposed operand in place.
+void dotGrad(Node &node) {
+  const Tensor &a = *node.inputs[0]->value;
+  const Tensor &b = *node.inputs[1]->value;
+  const Tensor &grad = *node.grad;
+  const size_t k = b.shape()[0];
+  if (k == 0) {
+    // the contraction is empty, so the inputs are too
+    for (Node *input : node.inputs) {
+      accumulate(*input, Tensor::fill(input->value->shape(), 0));
+    }
+    return;
+  }
+  const size_t m = a.size() / k;
+  const size_t n = b.size() / k;
+  const Tensor g = grad.reshape({m, n});
+  if (node.inputs[0]->requiresGrad) {
+    const Tensor bt = permute(b.reshape({k, n}), {1, 0});
+    accumulate(*node.inputs[0], dot(g, bt).reshape(a.shape()));
+  }
+  if (node.inputs[1]->requiresGrad) {
+    const Tensor at = permute(a.reshape({m, k}), {1, 0});
+    accumulate(*node.inputs[1], dot(at, g).reshape(b.shape()));
+  }
+}
+
+// Gradients of a layout-aware convolution
+void convGrad(Node &node) {
+  Node &input = *node.inputs[0];
+  Node &kernel = *node.inputs[1];
+  std::optional<Tensor> inputGrad;
+  std::optional<Tensor> kernelGrad;
+  if (input.requiresGrad) {
+    inputGrad.emplace(input.value->shape());
+  }
+  if (kernel.requiresGrad) {
+    kernelGrad.emplace(kernel.value->shape());
+  }
+  conv2dBackward(*node.grad, *input.value, *kernel.value, node.layout,
+                 node.options, inputGrad ? &*inputGrad : nullptr,
+                 kernelGrad ? &*kernelGrad : nullptr);
+  if (inputGrad) {
+    accumulate(input, *inputGrad);
+  }
+  if (kernelGrad) {
+    accumulate(kernel, *kernelGrad);
+  }
+}
+
+// Sums the gradient of images in NCHW layout over all but the channel axis
+Tensor channelSum(const Tensor &grad) {
+  const array_t &shape = grad.shape();
+  const size_t rank = shape.size();
+  const size_t channels = shape[rank - 3];
+  const size_t plane = shape[rank - 2] * shape[rank - 1];
+  const size_t batch = grad.size() / (channels * plane);
+  const Tensor g = flatten(grad);
+  const double *gData = makeSpan<1>(g).data();
+  Tensor result = Tensor::fill(array_t{channels}, 0);
+  double *out = makeSpan<1>(result).data();
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  for (size_t b = 0; b < batch; ++b) {
+    for (size_t ch = 0; ch < channels; ++ch) {
+      const double *src = gData + (b * channels + ch) * plane;
+      double s = 0;
+      for (size_t i = 0; i < plane; ++i) {
+        s += src[i];
+      }
+      out[ch] += s;
+    }
+  }
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result;
+}
+
+} // namespace
+
+void backwardNode(Node &node) {
+  const Tensor &g = *node.grad;
+  Node *left = node.inputs[0];
+  Node *right = node.inputs[1];
+  auto x = [&]() -> const Tensor & { return *left->value; };
+  auto y = [&]() -> const Tensor & { return *node.value; };
+
+  switch (node.op) {
+  case Op::CONSTANT:
+  case Op::VARIABLE:
+    break;
+  case Op::ADD:
+    accumulate(*left, sumTo(g, left->value->shape()));
+    accumulate(*right, sumTo(g, right->value->shape()));
+    break;
+  case Op::SUB:
+    accumulate(*left, sumTo(g, left->value->shape()));
+    if (right->requiresGrad) {
+      accumulate(*right, -sumTo(g, right->value->shape()));
+    }
+    break;
+  case Op::MUL:
+    if (left->requiresGrad) {
+      accumulate(*left, sumTo(g * *right->value, left->value->shape()));
+    }
+    if (right->requiresGrad) {
+      accumulate(*right, sumTo(g * *left->value, right->value->shape()));
+    }
+    break;
+  case Op::DIV:
+    if (left->requiresGrad) {
+      accumulate(*left, sumTo(g / *right->value, left->value->shape()));
+    }
+    if (right->requiresGrad) {
+      // d(a / b) / db = -(a / b) / b
+      accumulate(*right, sumTo(-(g * y()) / *right->value,
+                               right->value->shape()));
+    }
+    break;
+  case Op::NEG:
+    accumulate(*left, -g);
+    break;
+  case Op::AFFINE:
+    accumulate(*left, g * node.scalar);
+    break;
+  case Op::RDIV:
+    // d(c / x) / dx = -(c / x) / x
+    accumulate(*left, -(g * y()) / x());
+    break;
+  case Op::EXP:
+    accumulate(*left, g * y());
+    break;
+  case Op::LOG:
+    accumulate(*left, g / x());
+    break;
+  case Op::TANH:
+    accumulate(*left, zip(g, y(), [](double gi, double yi) {
+                 return gi * (1 - yi * yi);
+               }));
+    break;
+  case Op::SIGMOID:
+    accumulate(*left, zip(g, y(), [](double gi, double yi) {
+                 return gi * yi * (1 - yi);
+               }));
+    break;
+  case Op::RELU:
+    accumulate(*left, zip(g, x(), [](double gi, double xi) {
+                 return xi > 0 ? gi : 0.0;
+               }));
+    break;
+  case Op::GELU:
+    accumulate(*left, zip(g, x(), [](double gi, double xi) {
+                 constexpr double c = 1.59576912160573071176; // 2 sqrt(2 / pi)
+                 constexpr double a = 0.044715;
+                 double z = c * (xi + a * xi * xi * xi);
+                 double s = 1 / (1 + std::exp(-z));
+                 return gi * (s + xi * s * (1 - s) * c * (1 + 3 * a * xi * xi));
+               }));
+    break;
+  case Op::SOFTMAX:
+    accumulate(*left, softmaxGrad(g, y(), node.axis, false));
+    break;
+  case Op::LOG_SOFTMAX:
+    accumulate(*left, softmaxGrad(g, y(), node.axis, true));
+    break;
+  case Op::DOT:
+    dotGrad(node);
+    break;
+  case Op::RESHAPE:
+    accumulate(*left, g.reshape(left->value->shape()));
+    break;
+  case Op::SUM:
+    accumulate(*left, Tensor::fill(left->value->shape(), g[0]));
+    break;
+  case Op::CONV:
+    convGrad(node);
+    break;
+  case Op::MAX_POOL:
+    accumulate(*left, maxPoolBackward(g, *node.saved, x().shape()));
+    break;
+  case Op::ADD_BIAS:
+    accumulate(*left, g);
+    if (right->requiresGrad) {
+      accumulate(*right, node.layout == Layout::NHWC
+                             ? sumTo(g, right->value->shape())
+                             : channelSum(g));
+    }
+    break;
+  case Op::GATHER:
+    accumulate(*left, scatterAdd(Tensor::fill(x().shape(), 0), node.axis,
+                                 *node.saved, g));
+    break;
+  case Op::INDEX_SELECT:
+    accumulate(*left, indexAdd(Tensor::fill(x().shape(), 0), node.axis,
+                               *node.saved, g));
+    break;
+  case Op::CHECKPOINT:
+    checkpointBackward(node);
+    break;
+  }
+}
+
+/* OPERATIONS */
+
+Var operator+(const Var &left, const Var &right) {
+  return record(Op::ADD, left.value() + right.value(), left, right);
+}
+
+Var operator-(const Var &left, const Var &right) {
+  return record(Op::SUB, left.value() - right.value(), left, right);
+}
+
+Var operator*(const Var &left, const Var &right) {
+  return record(Op::MUL, left.value() * right.value(), left, right);
+}
+
+Var operator/(const Var &left, const Var &right) {
+  return record(Op::DIV, left.value() / right.value(), left, right);
+}
+
+Var operator-(const Var &var) { return record(Op::NEG, -var.value(), var); }
+
+Var operator+(const Var &var, double scalar) {
+  return recordScalar(Op::AFFINE, var.value() + scalar, var, 1);
+}
+
+Var operator+(double scalar, const Var &var) { return var + scalar; }
+
+Var operator-(const Var &var, double scalar) {
+  return recordScalar(Op::AFFINE, var.value() - scalar, var, 1);
+}
+
+Var operator-(double scalar, const Var &var) {
+  return recordScalar(Op::AFFINE, scalar - var.value(), var, -1);
+}
+
+Var operator*(const Var &var, double scalar) {
+  return recordScalar(Op::AFFINE, var.value() * scalar, var, scalar);
+}
+
+Var operator*(double scalar, const Var &var) { return var * scalar; }
+
+Var operator/(const Var &var, double scalar) {
+  return recordScalar(Op::AFFINE, var.value() / scalar, var, 1 / scalar);
+}
+
+Var operator/(double scalar, const Var &var) {
+  return recordScalar(Op::RDIV, scalar / var.value(), var, scalar);
+}
+
+Var affine(const Var &var, double scale, double shift) {
+  return recordScalar(Op::AFFINE, affine(var.value(), scale, shift), var,
+                      scale);
+}
+
+Var exp(const Var &var) { return record(Op::EXP, exp(var.value()), var); }
+
+Var log(const Var &var) { return record(Op::LOG, log(var.value()), var); }
+
+Var tanh(const Var &var) { return record(Op::TANH, tanh(var.value()), var); }
+
+Var sigmoid(const Var &var) {
+  return record(Op::SIGMOID, sigmoid(var.value()), var);
+}
+
+Var relu(const Var &var) { return record(Op::RELU, relu(var.value()), var); }
+
+Var gelu(const Var &var) { return record(Op::GELU, gelu(var.value()), var); }
+
+Var softmax(const Var &var, size_t axis) {
+  Var result = record(Op::SOFTMAX, softmax(var.value(), axis), var);
+  result.node()->axis = axis;
+  return result;
+}
+
+Var logSoftmax(const Var &var, size_t axis) {
+  Var result = record(Op::LOG_SOFTMAX, logSoftmax(var.value(), axis), var);
+  result.node()->axis = axis;
+  return result;
+}
+
+Var dot(const Var &left, const Var &right) {
+  return record(Op::DOT, dot(left.value(), right.value()), left, right);
+}
+
+Var conv(const Var &input, const Var &kernel, Layout layout,
+         const ConvOptions &options) {
+  Var result = record(Op::CONV, conv(input.value(), kernel.value(), layout,
+                                     options),
+                      input, kernel);
+  result.node()->layout = layout;
+  result.node()->options = resolveConvOptions(options, 2);
+  return result;
+}
+
+Var maxPool(const Var &input, const array_t &poolShape,
+            const PoolOptions &options) {
+  auto [pooled, indices] =
+      maxPoolWithIndices(input.value(), poolShape, options);
+  Var result = record(Op::MAX_POOL, pooled, input);
+  hold(result.node()->saved, indices);
+  return result;
+}
+
+Var maxPool(const Var &input, const array_t &poolShape, Layout layout,
+            const PoolOptions &options) {
+  auto [pooled, indices] =
+      maxPoolWithIndices(input.value(), poolShape, layout, options);
+  Var result = record(Op::MAX_POOL, pooled, input);
+  hold(result.node()->saved, indices);
+  return result;
+}
+
+Var gather(const Var &var, size_t axis, const Tensor &indices) {
+  Var result = record(Op::GATHER, gather(var.value(), axis, indices), var);
+  result.node()->axis = axis;
+  hold(result.node()->saved, indices);
+  return result;
+}
+
+Var indexSelect(const Var &var, size_t axis, const Tensor &indices) {
+  Var result =
+      record(Op::INDEX_SELECT, indexSelect(var.value(), axis, indices), var);
+  result.node()->axis = axis;
+  hold(result.node()->saved, indices);
+  return result;
+}
+
+Var addBias(const Var &input, const Var &bias, Layout layout) {
+  Var result = record(Op::ADD_BIAS,
+                      addBias(input.value(), bias.value(), layout), input,
+                      bias);
+  result.node()->layout = layout;
+  return result;
+}
+
+Var reshape(const Var &var, const array_t &shape) {
+  return record(Op::RESHAPE, var.value().reshape(shape), var);
+}
+
+Var flatten(const Var &var) { return reshape(var, {var.value().size()}); }
+
+Var sum(const Var &var) {
+  return record(Op::SUM, Tensor(gs::sum(var.value())), var);
+}
+
+} // namespace ad
+} // namespace gs
@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+#include "gradstudent/internal/autograd.h"
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/iter.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+namespace ad {
+
+/* ARENA */
+
+Arena::Arena(size_t blockSize) : blockSize_(blockSize) {}
+
+void *Arena::allocate(size_t bytes, size_t align) {
+  while (true) {
+    if (current_ < blocks_.size()) {
+      Block &block = blocks_[current_];
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      void *ptr = block.data.get() + offset_;
+      size_t space = block.size - offset_;
+      if (std::align(align, bytes, ptr, space) != nullptr) {
+        size_t start = block.size - space;
+        offset_ = start + bytes;
+        used_ += bytes;
+        return ptr;
+      }
+      ++current_;
+      offset_ = 0;
+      continue;
+    }
+    size_t size = std::max(blockSize_, bytes + align);
+    blocks_.push_back({std::make_unique<std::byte[]>(size), size});
+  }
+}
+
+void Arena::reset() {
+  current_ = 0;
+  offset_ = 0;
+  used_ = 0;
+}
+
+size_t Arena::capacity() const {
+  size_t result = 0;
+  for (const auto &block : blocks_) {
+    result += block.size;
+  }
+  return result;
+}
+
+/* NODES */
+
+Node::Node(Op op, const Tensor &value, Node *left, Node *right)
+    : op(op), inputs{left, right} {
+  hold(this->value, value);
+  for (Node *input : inputs) {
+    requiresGrad = requiresGrad || (input != nullptr && input->requiresGrad);
+  }
+}
+
+void hold(std::optional<Tensor> &slot, const Tensor &tensor) {
+  slot.reset();
+  slot.emplace(tensor.shape(), tensor.strides(), tensor, tensor.offset(),
+               true);
+}
+
+void addInto(Tensor &dst, const Tensor &src) {
+  if (dst.shape() != src.shape()) {
+    std::stringstream ss;
+    ss << "Can't add gradient of shape " << src.shape()
+       << " to gradient of shape " << dst.shape();
+    throw std::invalid_argument(ss.str());
+  }
+  if (!isContiguous(dst)) {
+    for (const auto &[d, s] : TensorIter(dst, src)) {
+      d += s;
+    }
+    return;
+  }
+  double *out = mutableData(dst);
+  const Tensor in = flatten(src);
+  const double *inData = makeSpan<1>(in).data();
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  parallelFor(dst.size(), 1 << 16, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      out[i] += inData[i];
+    }
+  });
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+Tensor sumTo(const Tensor &grad, const array_t &shape) {
+  if (grad.shape() == shape) {
+    return Tensor(grad.shape(), grad.strides(), grad, grad.offset(), true);
+  }
+  Tensor result = Tensor::fill(shape, 0);
+
+  // common case of an operand broadcast along leading axes (e.g. a bias)
+  const array_t &gShape = grad.shape();
+  if (shape.size() <= gShape.size() &&
+      gShape.sliceFrom(gShape.size() - shape.size()) == shape) {
+    const Tensor in = flatten(grad);
+    const double *inData = makeSpan<1>(in).data();
+    double *out = mutableData(result);
+    size_t n = result.size();
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    for (size_t r = 0; r < grad.size() / n; ++r) {
+      for (size_t j = 0; j < n; ++j) {
+        out[j] += inData[r * n + j];
+      }
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return result;
+  }
+
+  Tensor target = broadcast(result, gShape);
+  for (const auto &[r, g] : TensorIter(target, grad)) {
+    r += g;
+  }
+  return result;
+}
+
+void accumulate(Node &node, const Tensor &grad) {
+  if (!node.requiresGrad) {
+    return;
+  }
+  if (node.sink != nullptr) {
+    addInto(*node.sink, grad);
+  } else if (!node.grad) {
+    // the gradient may be shared with another input, so hold it read-only
+    hold(node.grad, grad);
+    node.ownsGrad = false;
+  } else {
+    if (!node.ownsGrad) {
+      Tensor sum = *node.grad + grad;
+      node.grad.reset();
+      node.grad.emplace(sum.shape(), sum.strides(), sum, sum.offset(), false);
+      node.ownsGrad = true;
+      return;
+    }
+    addInto(*node.grad, grad);
+  }
+}
+
+/* VARS */
+
+const Tensor &Var::value() const {
+  if (!node_->value) {
+    throw std::invalid_argument("Value was released by backward");
+  }
+  return *node_->value;
+}
+
+const Tensor &Var::grad() const {
+  if (!node_->grad) {
+    throw std::invalid_argument("No gradient available");
+  }
+  return *node_->grad;
+}
+
+bool Var::requiresGrad() const { return node_->requiresGrad; }
+
+bool Var::released() const { return !node_->value; }
+
+/* TAPE */
+
+Tape::Tape(size_t blockSize) : arena_(blockSize) {}
+
+Tape::~Tape() { reset(); }
+
+Node *Tape::record(Node *node) {
+  auto use = [node](Node *input) {
+    if (input != nullptr && input->firstUse == nullptr) {
+      input->firstUse = node;
+    }
+  };
+  for (Node *input : node->inputs) {
+    use(input);
+  }
+  if (node->segment) {
+    for (Node *input : node->segment->inputs) {
+      use(input);
+    }
+  }
+  node->prev = last_;
+  last_ = node;
+  ++size_;
+  return node;
+}
+
+Var Tape::constant(const Tensor &value) {
+  return {this, record(arena_.create<Node>(Op::CONSTANT, value))};
+}
+
+Var Tape::variable(const Tensor &value) {
+  Node *node = arena_.create<Node>(Op::VARIABLE, value);
+  node->requiresGrad = true;
+  return {this, record(node)};
+}
+
+Var Tape::variable(const Tensor &value, Tensor &grad) {
+  if (grad.shape() != value.shape()) {
+    std::stringstream ss;
+    ss << "Expected gradient buffer of shape " << value.shape() << ", got "
+       << grad.shape();
+    throw std::invalid_argument(ss.str());
+  }
+  if (!isContiguous(grad) || grad.ro()) {
+    throw std::invalid_argument(
+        "Gradient buffer must be contiguous and writable");
+  }
+  Node *node = arena_.create<Node>(Op::VARIABLE, value);
+  node->requiresGrad = true;
+  node->sink = &grad;
+  return {this, record(node)};
+}
+
+void Tape::backward(const Var &root) {
+  if (root.node()->value && root.value().size() != 1) {
+    std::stringstream ss;
+    ss << "Expected a scalar to differentiate, got shape "
+       << root.value().shape();
+    throw std::invalid_argument(ss.str());
+  }
+  backward(root, Tensor::fill(root.value().shape(), 1));
+}
+
+void Tape::backward(const Var &root, const Tensor &seed) {
+  if (&root.tape() != this) {
+    throw std::invalid_argument("Var was recorded on a different tape");
+  }
+  if (!root.requiresGrad()) {
+    throw std::invalid_argument("Var does not depend on any variable");
+  }
+  if (seed.shape() != root.value().shape()) {
+    std::stringstream ss;
+    ss << "Expected seed of shape " << root.value().shape() << ", got "
+       << seed.shape();
+    throw std::invalid_argument(ss.str());
+  }
+
+  // reports the gradient of a variable once no later node can contribute
+  auto ready = [this](Node *input, const Node *user) {
+    if (input != nullptr && input->sink != nullptr && !input->gradReady &&
+        input->firstUse == user) {
+      input->gradReady = true;
+      if (gradHook_) {
+        gradHook_(*input->sink);
+      }
+    }
+  };
+
+  accumulate(*root.node(), seed);
+  for (Node *node = last_; node != nullptr; node = node->prev) {
+    if (node->op == Op::VARIABLE) {
+      // unused variables
+      ready(node, nullptr);
+      continue;
+    }
+    if (node->requiresGrad && node->grad) {
+      backwardNode(*node);
+    }
+    for (Node *input : node->inputs) {
+      ready(input, node);
+    }
+    if (node->segment) {
+      for (Node *input : node->segment->inputs) {
+        ready(input, node);
+      }
+    }
+    node->value.reset();
+    node->grad.reset();
+    node->saved.reset();
+  }
+}
+
+void Tape::setGradHook(GradHook hook) { gradHook_ = std::move(hook); }
+
+void Tape::reset() {
+  for (Node *node = last_; node != nullptr;) {
+    Node *prev = node->prev;
+    node->~Node();
+    node = prev;
+  }
+  last_ = nullptr;
+  size_ = 0;
+  stats_ = RecomputeStats{};
+  arena_.reset();
+}
+
+} // namespace ad
+} // namespace gs
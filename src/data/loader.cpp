@@ -0,0 +1,129 @@
+#include <sstream>
+#include <utility>
+
+#include "gradstudent/data.h"
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/ops.h"
+
+namespace gs {
+namespace data {
+
+/* BATCH */
+
+Batch::Batch(size_t capacity, const std::vector<array_t> &exampleShapes) {
+  // fields are constructed in place, since copying a tensor copies its data
+  fields_.reserve(exampleShapes.size());
+  for (const array_t &shape : exampleShapes) {
+    array_t batchShape(shape.size() + 1, 0);
+    batchShape[0] = capacity;
+    for (size_t i = 0; i < shape.size(); ++i) {
+      batchShape[i + 1] = shape[i];
+    }
+    fields_.emplace_back(batchShape);
+  }
+}
+
+Tensor Batch::operator[](size_t k) {
+  return truncate(fields_.at(k), {offset_}, {offset_ + size_});
+}
+
+// NOLINTNEXTLINE(readability-const-return-type)
+const Tensor Batch::operator[](size_t k) const {
+  return truncate(fields_.at(k), {offset_}, {offset_ + size_});
+}
+
+/* DATA LOADER */
+
+DataLoader::DataLoader(size_t examples,
+                       const std::vector<array_t> &exampleShapes, Fill fill,
+                       const LoaderOptions &options)
+    : examples_(examples), options_(options), fill_(std::move(fill)) {
+  if (examples == 0 || options.batchSize == 0 || options.workers == 0 ||
+      options.prefetch == 0) {
+    std::stringstream ss;
+    ss << "Invalid data loader: " << examples << " examples, batch size "
+       << options.batchSize << ", " << options.workers
+       << " workers and prefetch depth " << options.prefetch;
+    throw std::invalid_argument(ss.str());
+  }
+  for (size_t i = 0; i <= options.prefetch; ++i) {
+    slots_.push_back(
+        std::make_unique<Batch>(options.batchSize, exampleShapes));
+    free_.push_back(slots_.back().get());
+  }
+  for (size_t i = 0; i < options.workers; ++i) {
+    threads_.emplace_back([this] { produce(); });
+  }
+}
+
+DataLoader::~DataLoader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+size_t DataLoader::batches() const {
+  return (examples_ + options_.batchSize - 1) / options_.batchSize;
+}
+
+void DataLoader::produce() {
+  inParallelRegion() = true;
+  const size_t perEpoch = batches();
+  while (true) {
+    Batch *batch = nullptr;
+    size_t number = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stop_ || !free_.empty(); });
+      if (stop_) {
+        return;
+      }
+      batch = free_.back();
+      free_.pop_back();
+      number = produced_++;
+    }
+
+    batch->epoch_ = number / perEpoch;
+    batch->index_ = number % perEpoch;
+    batch->begin_ = batch->index_ * options_.batchSize;
+    batch->size_ = std::min(options_.batchSize, examples_ - batch->begin_);
+    batch->error_ = nullptr;
+    try {
+      fill_(*batch);
+    } catch (...) {
+      batch->error_ = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ready_[number] = batch;
+    }
+    cv_.notify_all();
+  }
+}
+
+const Batch &DataLoader::next() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (current_ != nullptr) {
+    free_.push_back(current_);
+    current_ = nullptr;
+    cv_.notify_all();
+  }
+  cv_.wait(lock, [this] { return ready_.count(consumed_) > 0; });
+  auto it = ready_.find(consumed_);
+  current_ = it->second;
+  ready_.erase(it);
+  ++consumed_;
+  if (current_->error_) {
+    std::rethrow_exception(current_->error_);
+  }
+  return *current_;
+}
+
+} // namespace data
+} // namespace gs
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <sstream>
+
+#include "gradstudent/data.h"
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+namespace data {
+
+namespace {
+
+// minimum number of elements gathered by each thread
+constexpr size_t parallelGrain = 1 << 16;
+
+// Returns the number of examples of the sources, checking that they agree
+size_t countExamples(const std::vector<const Tensor *> &sources,
+                     const SamplerOptions &options) {
+  bool valid = !sources.empty() && options.batchSize > 0;
+  for (const Tensor *source : sources) {
+    valid = valid && source->ndims() > 0 &&
+            source->shape()[0] == sources.front()->shape()[0];
+  }
+  size_t examples = valid ? sources.front()->shape()[0] : 0;
+  if (examples == 0) {
+    std::stringstream ss;
+    ss << "Invalid sampler: batch size " << options.batchSize
+       << " and sources of shapes";
+    for (const Tensor *source : sources) {
+      ss << " " << source->shape();
+    }
+    throw std::invalid_argument(ss.str());
+  }
+  return examples;
+}
+
+} // namespace
+
+Sampler::Sampler(const std::vector<const Tensor *> &sources,
+                 const SamplerOptions &options)
+    : examples_(countExamples(sources, options)), options_(options),
+      order_(examples_), batch_(0, {}) {
+  // fields are constructed in place, since copying a tensor copies its data
+  sources_.reserve(sources.size());
+  batch_.fields_.reserve(sources.size());
+  for (const Tensor *source : sources) {
+    const Tensor compact = contiguous(*source);
+    sources_.emplace_back(compact.shape(), compact.strides(), compact,
+                          compact.offset(), true);
+    if (options.shuffle) {
+      array_t shape = compact.shape();
+      shape[0] = std::min(options.batchSize, examples_);
+      batch_.fields_.emplace_back(shape);
+    } else {
+      batch_.fields_.emplace_back(compact.shape(), compact.strides(), compact,
+                                  compact.offset(), true);
+    }
+  }
+  std::iota(order_.begin(), order_.end(), 0);
+}
+
+size_t Sampler::batches() const {
+  return (examples_ + options_.batchSize - 1) / options_.batchSize;
+}
+
+void Sampler::shuffle(size_t epoch) {
+  std::iota(order_.begin(), order_.end(), 0);
+  std::seed_seq seq{static_cast<uint32_t>(options_.seed),
+                    static_cast<uint32_t>(options_.seed >> 32),
+                    static_cast<uint32_t>(epoch),
+                    static_cast<uint32_t>(uint64_t{epoch} >> 32)};
+  std::mt19937_64 engine(seq);
+  // Fisher-Yates rather than std::shuffle, whose results depend on the
+  // standard library
+  for (size_t i = examples_ - 1; i > 0; --i) {
+    std::swap(order_[i], order_[engine() % (i + 1)]);
+  }
+}
+
+void Sampler::gather() {
+  const size_t numFields = sources_.size();
+  std::vector<const double *> src(numFields);
+  std::vector<double *> dst(numFields);
+  std::vector<size_t> rows(numFields);
+  size_t rowElements = 0;
+  for (size_t k = 0; k < numFields; ++k) {
+    const Tensor source = flatten(sources_[k]);
+    src[k] = makeSpan<1>(source).data();
+    dst[k] = mutableData(batch_.fields_[k]);
+    rows[k] = source.size() / examples_;
+    rowElements += rows[k];
+  }
+
+  const size_t *positions = &order_[batch_.begin_];
+  const size_t grain = parallelGrain / std::max<size_t>(rowElements, 1);
+  parallelFor(batch_.size_, grain, [&](size_t begin, size_t end) {
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    for (size_t k = 0; k < numFields; ++k) {
+      const size_t row = rows[k];
+      if (row == 1) {
+        for (size_t j = begin; j < end; ++j) {
+          dst[k][j] = src[k][positions[j]];
+        }
+        continue;
+      }
+      for (size_t j = begin; j < end; ++j) {
+        std::memcpy(dst[k] + j * row, src[k] + positions[j] * row,
+                    row * sizeof(double));
+      }
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  });
+}
+
+const Batch &Sampler::next() {
+  const size_t perEpoch = batches();
+  const size_t epoch = produced_ / perEpoch;
+  const size_t index = produced_ % perEpoch;
+  ++produced_;
+  if (options_.shuffle && index == 0) {
+    shuffle(epoch);
+  }
+
+  batch_.epoch_ = epoch;
+  batch_.index_ = index;
+  batch_.begin_ = index * options_.batchSize;
+  batch_.size_ = std::min(options_.batchSize, examples_ - batch_.begin_);
+  if (options_.shuffle) {
+    gather();
+  } else {
+    batch_.offset_ = batch_.begin_;
+  }
+  return batch_;
+}
+
+} // namespace data
+} // namespace gs
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "gradstudent/dist.h"
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+namespace dist {
+
+namespace {
+
+// number of elements reduced at a time, small enough to stay in L1
+constexpr size_t reduceBlock = 2048;
+
+// Progress of the all-reduce during a step
+struct Exchange {
+  size_t active;                // number of replicas taking part
+  std::vector<double *> out;    // output gradients
+  std::vector<size_t> ready;    // number of replicas done with each gradient
+  bool failed = false;          // a replica threw
+  std::mutex mutex;
+  std::condition_variable cv;
+};
+
+} // namespace
+
+struct DataParallel::Replica {
+  ad::Tape tape;
+  std::vector<Tensor> grads;
+  std::vector<double *> data;
+  std::unordered_map<const Tensor *, size_t> index;
+  std::deque<size_t> pending; // completed gradients whose shard is not reduced
+};
+
+namespace {
+
+// Sums shard r of gradient i over the active replicas into the output
+template <typename Replicas>
+void reduceShard(const Replicas &replicas, const Exchange &ex, size_t i,
+                 size_t r, size_t n) {
+  const size_t begin = r * n / ex.active;
+  const size_t end = (r + 1) * n / ex.active;
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  double *out = ex.out[i];
+  for (size_t b = begin; b < end; b += reduceBlock) {
+    const size_t e = std::min(end, b + reduceBlock);
+    const double *src = replicas[0]->data[i];
+    std::copy(src + b, src + e, out + b);
+    for (size_t k = 1; k < ex.active; ++k) {
+      src = replicas[k]->data[i];
+      for (size_t j = b; j < e; ++j) {
+        out[j] += src[j];
+      }
+    }
+  }
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+} // namespace
+
+DataParallel::DataParallel(std::vector<Tensor *> params,
+                           std::vector<Tensor *> grads, LossFunction loss,
+                           size_t replicas)
+    : params_(std::move(params)), grads_(std::move(grads)),
+      loss_(std::move(loss)) {
+  if (params_.size() != grads_.size()) {
+    std::stringstream ss;
+    ss << "Expected one gradient per parameter, got " << params_.size()
+       << " parameters and " << grads_.size() << " gradients";
+    throw std::invalid_argument(ss.str());
+  }
+  for (size_t i = 0; i < params_.size(); ++i) {
+    if (params_[i]->shape() != grads_[i]->shape()) {
+      std::stringstream ss;
+      ss << "Parameter " << i << " has shape " << params_[i]->shape()
+         << " but its gradient has shape " << grads_[i]->shape();
+      throw std::invalid_argument(ss.str());
+    }
+    if (!isContiguous(*grads_[i]) || grads_[i]->ro()) {
+      std::stringstream ss;
+      ss << "Gradient " << i << " must be contiguous and writable";
+      throw std::invalid_argument(ss.str());
+    }
+  }
+
+  replicas = replicas == 0 ? numThreads() : replicas;
+  for (size_t r = 0; r < replicas; ++r) {
+    auto replica = std::make_unique<Replica>();
+    replica->grads.reserve(params_.size());
+    for (const Tensor *param : params_) {
+      replica->grads.push_back(Tensor::fill(param->shape(), 0));
+    }
+    for (size_t i = 0; i < params_.size(); ++i) {
+      replica->data.push_back(mutableData(replica->grads[i]));
+      replica->index[&replica->grads[i]] = i;
+    }
+    replicas_.push_back(std::move(replica));
+  }
+}
+
+DataParallel::~DataParallel() = default;
+
+double DataParallel::step(const Tensor &inputs, const Tensor &targets) {
+  const size_t batch = inputs.ndims() == 0 ? 0 : inputs.shape()[0];
+  if (batch == 0) {
+    throw std::invalid_argument("Expected a non-empty minibatch");
+  }
+  if (targets.ndims() == 0 || targets.shape()[0] != batch) {
+    std::stringstream ss;
+    ss << "Expected targets for " << batch << " examples, got shape "
+       << targets.shape();
+    throw std::invalid_argument(ss.str());
+  }
+
+  Exchange ex;
+  ex.active = std::min(replicas_.size(), batch);
+  ex.ready.assign(params_.size(), 0);
+  for (Tensor *grad : grads_) {
+    ex.out.push_back(mutableData(*grad));
+  }
+  std::vector<double> losses(ex.active);
+  std::vector<std::exception_ptr> errors(ex.active);
+
+  auto work = [&](size_t r) {
+    Replica &replica = *replicas_[r];
+    // reduces the shards of gradients complete on all replicas, in order
+    auto drain = [&](bool wait) {
+      while (!replica.pending.empty()) {
+        size_t i = replica.pending.front();
+        {
+          std::unique_lock<std::mutex> lock(ex.mutex);
+          if (wait) {
+            ex.cv.wait(lock, [&] {
+              return ex.ready[i] == ex.active || ex.failed;
+            });
+          }
+          if (ex.failed || ex.ready[i] != ex.active) {
+            return;
+          }
+        }
+        reduceShard(replicas_, ex, i, r, params_[i]->size());
+        replica.pending.pop_front();
+      }
+    };
+    replica.tape.setGradHook([&](Tensor &grad) {
+      size_t i = replica.index.at(&grad);
+      {
+        std::lock_guard<std::mutex> lock(ex.mutex);
+        if (++ex.ready[i] == ex.active) {
+          ex.cv.notify_all();
+        }
+      }
+      replica.pending.push_back(i);
+      drain(false);
+    });
+
+    try {
+      for (size_t i = 0; i < params_.size(); ++i) {
+        double *data = replica.data[i];
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        std::fill(data, data + params_[i]->size(), 0.0);
+      }
+      const size_t begin = r * batch / ex.active;
+      const size_t end = (r + 1) * batch / ex.active;
+      std::vector<ad::Var> vars;
+      vars.reserve(params_.size());
+      for (size_t i = 0; i < params_.size(); ++i) {
+        vars.push_back(replica.tape.variable(*params_[i], replica.grads[i]));
+      }
+      ad::Var loss =
+          loss_(replica.tape, vars, truncate(inputs, {begin}, {end}),
+                truncate(targets, {begin}, {end}));
+      const double weight =
+          static_cast<double>(end - begin) / static_cast<double>(batch);
+      losses[r] = weight * loss.value()[0];
+      replica.tape.backward(loss, Tensor::fill(loss.value().shape(), weight));
+      drain(true);
+    } catch (...) {
+      errors[r] = std::current_exception();
+      std::lock_guard<std::mutex> lock(ex.mutex);
+      ex.failed = true;
+      ex.cv.notify_all();
+    }
+    replica.pending.clear();
+    replica.tape.reset();
+    replica.tape.setGradHook(nullptr);
+  };
+
+  // replicas run their kernels serially, like the workers of parallelFor
+  auto worker = [&](size_t r) {
+    bool &flag = inParallelRegion();
+    flag = true;
+    work(r);
+    flag = false;
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(ex.active - 1);
+  for (size_t r = 1; r < ex.active; ++r) {
+    threads.emplace_back(worker, r);
+  }
+  if (ex.active > 1) {
+    worker(0);
+  } else {
+    work(0);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (const auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  double result = 0;
+  for (double loss : losses) {
+    result += loss;
+  }
+  return result;
+}
+
+} // namespace dist
+} // namespace gs
@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "gradstudent/dist.h"
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+
+namespace gs {
+namespace dist {
+
+namespace {
+
+// number of elements reduced at a time, small enough to stay in L1
+constexpr size_t reduceBlock = 2048;
+
+// allocations are aligned to cache lines
+constexpr size_t alignment = 64 / sizeof(double);
+
+// how long ranks wait for each other to join
+constexpr auto joinTimeout = std::chrono::seconds(60);
+
+[[noreturn]] void throwErrno(const std::string &what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Returns the address of the coordination socket, in the abstract namespace
+std::pair<sockaddr_un, socklen_t> socketAddress(const std::string &name) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  std::string path = "gradstudent-" + name;
+  if (path.size() + 1 > sizeof(addr.sun_path)) {
+    throw std::invalid_argument("Process group name is too long: " + name);
+  }
+  // the leading null byte of sun_path selects the abstract namespace
+  std::copy(path.begin(), path.end(), &addr.sun_path[1]);
+  return {addr, static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 +
+                                       path.size())};
+}
+
+void sendAll(int fd, const void *data, size_t bytes, size_t peer) {
+  const auto *p = static_cast<const char *>(data);
+  while (bytes > 0) {
+    ssize_t n = send(fd, p, bytes, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      std::stringstream ss;
+      ss << "Rank " << peer << " left the process group";
+      throw std::runtime_error(ss.str());
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    p += n;
+    bytes -= static_cast<size_t>(n);
+  }
+}
+
+void recvAll(int fd, void *data, size_t bytes, size_t peer) {
+  auto *p = static_cast<char *>(data);
+  while (bytes > 0) {
+    ssize_t n = recv(fd, p, bytes, 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      std::stringstream ss;
+      ss << "Rank " << peer << " left the process group";
+      throw std::runtime_error(ss.str());
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    p += n;
+    bytes -= static_cast<size_t>(n);
+  }
+}
+
+} // namespace
+
+// A mapping of the shared-memory segment, released with the last tensor
+struct ProcessGroup::Segment {
+  double *data = nullptr;
+  size_t bytes = 0;
+
+  Segment(int fd, size_t bytes) : bytes(bytes) {
+    void *addr =
+        mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      throwErrno("mmap");
+    }
+    data = static_cast<double *>(addr);
+  }
+
+  Segment(const Segment &) = delete;
+  Segment &operator=(const Segment &) = delete;
+
+  ~Segment() { munmap(data, bytes); }
+
+  double *region(size_t rank, size_t capacity) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return data + rank * capacity;
+  }
+};
+
+ProcessGroup::ProcessGroup(const std::string &name, size_t rank, size_t size,
+                           size_t capacity)
+    : rank_(rank), size_(size),
+      capacity_((capacity + alignment - 1) / alignment * alignment) {
+  if (rank >= size) {
+    std::stringstream ss;
+    ss << "Rank " << rank << " out of range for a group of size " << size;
+    throw std::invalid_argument(ss.str());
+  }
+  const std::string shmName = "/gradstudent-" + name;
+  const size_t bytes = std::max<size_t>(size * capacity_, 1) * sizeof(double);
+  try {
+    join(name, shmName, bytes);
+  } catch (...) {
+    for (int fd : peers_) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+    if (rank == 0) {
+      shm_unlink(shmName.c_str());
+    }
+    throw;
+  }
+}
+
+// Connects the ranks and maps the segment
+void ProcessGroup::join(const std::string &name, const std::string &shmName,
+                        size_t bytes) {
+  const auto [addr, addrLen] = socketAddress(name);
+  const auto *sockAddr = reinterpret_cast<const sockaddr *>(&addr);
+  int fd = -1;
+  if (rank_ == 0) {
+    // a segment left over by a crashed run is replaced
+    shm_unlink(shmName.c_str());
+    fd = shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      throwErrno("shm_open");
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+      close(fd);
+      throwErrno("ftruncate");
+    }
+    segment_ = std::make_shared<Segment>(fd, bytes);
+    close(fd);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+      throwErrno("socket");
+    }
+    if (bind(listener, sockAddr, addrLen) != 0 ||
+        listen(listener, static_cast<int>(size_)) != 0) {
+      close(listener);
+      throwErrno("bind");
+    }
+    // accept fails instead of waiting forever for a rank that never starts
+    timeval timeout{
+        std::chrono::duration_cast<std::chrono::seconds>(joinTimeout).count(),
+        0};
+    setsockopt(listener, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    peers_.assign(size_, -1);
+    for (size_t i = 1; i < size_; ++i) {
+      int peer = accept(listener, nullptr, nullptr);
+      if (peer < 0) {
+        close(listener);
+        throwErrno("accept");
+      }
+      uint64_t peerRank = 0;
+      recvAll(peer, &peerRank, sizeof(peerRank), i);
+      if (peerRank == 0 || peerRank >= size_ || peers_[peerRank] != -1) {
+        close(peer);
+        close(listener);
+        std::stringstream ss;
+        ss << "Unexpected rank " << peerRank << " joined the process group";
+        throw std::runtime_error(ss.str());
+      }
+      peers_[peerRank] = peer;
+    }
+    close(listener);
+  } else {
+    int sock = -1;
+    auto deadline = std::chrono::steady_clock::now() + joinTimeout;
+    while (true) {
+      sock = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (sock < 0) {
+        throwErrno("socket");
+      }
+      if (connect(sock, sockAddr, addrLen) == 0) {
+        break;
+      }
+      int error = errno;
+      close(sock);
+      if (std::chrono::steady_clock::now() > deadline) {
+        throw std::system_error(error, std::generic_category(), "connect");
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    peers_.push_back(sock);
+    const uint64_t ownRank = rank_;
+    sendAll(sock, &ownRank, sizeof(ownRank), 0);
+  }
+
+  // the segment exists once rank 0 has accepted all ranks
+  exchange(capacity_);
+  if (rank_ != 0) {
+    fd = shm_open(shmName.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+      throwErrno("shm_open");
+    }
+    segment_ = std::make_shared<Segment>(fd, bytes);
+    close(fd);
+  }
+  exchange(capacity_);
+  if (rank_ == 0) {
+    shm_unlink(shmName.c_str());
+  }
+}
+
+ProcessGroup::~ProcessGroup() {
+  for (int fd : peers_) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+}
+
+// Blocks until all ranks have called exchange with the same value
+void ProcessGroup::exchange(size_t value) {
+  const auto own = static_cast<uint64_t>(value);
+  uint8_t same = 1;
+  if (rank_ == 0) {
+    for (size_t peer = 1; peer < size_; ++peer) {
+      uint64_t other = 0;
+      recvAll(peers_[peer], &other, sizeof(other), peer);
+      same = same != 0 && other == own ? 1 : 0;
+    }
+    for (size_t peer = 1; peer < size_; ++peer) {
+      sendAll(peers_[peer], &same, sizeof(same), peer);
+    }
+  } else {
+    sendAll(peers_[0], &own, sizeof(own), 0);
+    recvAll(peers_[0], &same, sizeof(same), 0);
+  }
+  if (same == 0) {
+    throw std::invalid_argument(
+        "Ranks of the process group disagree on the size of their regions");
+  }
+}
+
+Tensor ProcessGroup::allocate(const array_t &shape) {
+  const size_t n = prod(shape);
+  const size_t begin = (used_ + alignment - 1) / alignment * alignment;
+  if (begin + n > capacity_) {
+    std::stringstream ss;
+    ss << "Cannot allocate " << n << " elements in a region of "
+       << capacity_ << " elements with " << begin << " in use";
+    throw std::invalid_argument(ss.str());
+  }
+  used_ = begin + n;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  double *data = segment_->region(rank_, capacity_) + begin;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  std::fill(data, data + n, 0.0);
+  // the deleter keeps the segment mapped while the tensor exists
+  return {shape, std::shared_ptr<double[]>(
+                     data, [segment = segment_](double *) {})};
+}
+
+void ProcessGroup::allReduce(double scale) {
+  // all ranks have finished writing their regions
+  exchange(used_);
+  const size_t n = used_;
+  const size_t begin = rank_ * n / size_;
+  const size_t end = (rank_ + 1) * n / size_;
+  double *own = segment_->region(rank_, capacity_);
+
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  const size_t blocks = (end - begin + reduceBlock - 1) / reduceBlock;
+  parallelFor(blocks, 4, [&](size_t first, size_t last) {
+    for (size_t block = first; block < last; ++block) {
+      const size_t b = begin + block * reduceBlock;
+      const size_t e = std::min(end, b + reduceBlock);
+      for (size_t k = 1; k < size_; ++k) {
+        const double *src = segment_->region((rank_ + k) % size_, capacity_);
+        for (size_t j = b; j < e; ++j) {
+          own[j] += src[j];
+        }
+      }
+      if (scale != 1) {
+        for (size_t j = b; j < e; ++j) {
+          own[j] *= scale;
+        }
+      }
+    }
+  });
+
+  // all shards are reduced
+  exchange(used_);
+  for (size_t k = 1; k < size_; ++k) {
+    const size_t peer = (rank_ + k) % size_;
+    const double *src = segment_->region(peer, capacity_);
+    const size_t b = peer * n / size_;
+    const size_t e = (peer + 1) * n / size_;
+    std::copy(src + b, src + e, own + b);
+  }
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+  // no rank writes its region again before the others have read from it
+  exchange(used_);
+}
+
+void ProcessGroup::barrier() { exchange(used_); }
+
+} // namespace dist
+} // namespace gs
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "gradstudent/internal/copy.h"
+#include "gradstudent/internal/parallel.h"
+
+namespace gs {
+
+namespace {
+
+// minimum number of elements copied by each thread
+constexpr size_t parallelGrain = 1 << 16;
+
+// side length of the square tiles used for transposed copies
+constexpr size_t tileSize = 32;
+
+struct Dim {
+  size_t size;
+  size_t dst;
+  size_t src;
+};
+
+// Drops trivial dimensions, orders the remaining ones by decreasing
+// destination stride and merges dimensions that are contiguous in both
+// buffers.
+std::vector<Dim> canonicalDims(const array_t &shape, const array_t &dstStrides,
+                               const array_t &srcStrides) {
+  std::vector<Dim> dims;
+  for (size_t i = 0; i < shape.size(); ++i) {
+    if (shape[i] != 1) {
+      dims.push_back({shape[i], dstStrides[i], srcStrides[i]});
+    }
+  }
+  std::stable_sort(dims.begin(), dims.end(), [](const Dim &a, const Dim &b) {
+    return a.dst != b.dst ? a.dst > b.dst : a.src > b.src;
+  });
+
+  std::vector<Dim> result;
+  for (const Dim &dim : dims) {
+    if (!result.empty()) {
+      Dim &last = result.back();
+      if (last.dst == dim.dst * dim.size && last.src == dim.src * dim.size) {
+        last = {last.size * dim.size, dim.dst, dim.src};
+        continue;
+      }
+    }
+    result.push_back(dim);
+  }
+  return result;
+}
+
+// Tracks buffer offsets while iterating over a set of outer dimensions in
+// lexicographic order.
+class Odometer {
+public:
+  Odometer(const std::vector<Dim> &dims, size_t flat)
+      : dims_(dims), idx_(dims.size(), 0) {
+    for (size_t i = dims_.size(); i-- > 0;) {
+      idx_[i] = flat % dims_[i].size;
+      flat /= dims_[i].size;
+      dst_ += idx_[i] * dims_[i].dst;
+      src_ += idx_[i] * dims_[i].src;
+    }
+  }
+
+  size_t dst() const { return dst_; }
+  size_t src() const { return src_; }
+
+  void next() {
+    for (size_t i = dims_.size(); i-- > 0;) {
+      dst_ += dims_[i].dst;
+      src_ += dims_[i].src;
+      if (++idx_[i] < dims_[i].size) {
+        return;
+      }
+      dst_ -= dims_[i].dst * dims_[i].size;
+      src_ -= dims_[i].src * dims_[i].size;
+      idx_[i] = 0;
+    }
+  }
+
+private:
+  const std::vector<Dim> &dims_;
+  std::vector<size_t> idx_;
+  size_t dst_ = 0;
+  size_t src_ = 0;
+};
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+void copyRow(double *dst, size_t dstStride, const double *src,
+             size_t srcStride, size_t n) {
+  if (dstStride == 1 && srcStride == 1) {
+    std::memcpy(dst, src, n * sizeof(double));
+  } else if (dstStride == 1 && srcStride == 0) {
+    std::fill(dst, dst + n, *src);
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      dst[i * dstStride] = src[i * srcStride];
+    }
+  }
+}
+
+// Copies a tile that is contiguous along columns in the destination and
+// along rows in the source, i.e. dst[r * ldd + c] = src[r + c * lds].
+void transposeTile(double *dst, size_t ldd, const double *src, size_t lds,
+                   size_t rows, size_t cols) {
+  size_t r = 0;
+#ifdef __SSE2__
+  // transpose 2x2 blocks in registers
+  for (; r + 2 <= rows; r += 2) {
+    size_t c = 0;
+    for (; c + 2 <= cols; c += 2) {
+      __m128d a = _mm_loadu_pd(src + r + c * lds);
+      __m128d b = _mm_loadu_pd(src + r + (c + 1) * lds);
+      _mm_storeu_pd(dst + r * ldd + c, _mm_unpacklo_pd(a, b));
+      _mm_storeu_pd(dst + (r + 1) * ldd + c, _mm_unpackhi_pd(a, b));
+    }
+    for (; c < cols; ++c) {
+      dst[r * ldd + c] = src[r + c * lds];
+      dst[(r + 1) * ldd + c] = src[r + 1 + c * lds];
+    }
+  }
+#endif
+  for (; r < rows; ++r) {
+    for (size_t c = 0; c < cols; ++c) {
+      dst[r * ldd + c] = src[r + c * lds];
+    }
+  }
+}
+
+void tiledCopy(double *dst, const double *src, const std::vector<Dim> &outer,
+               const Dim &tile, const Dim &inner) {
+  size_t outerSize = 1;
+  for (const Dim &dim : outer) {
+    outerSize *= dim.size;
+  }
+  size_t numBlocks = (tile.size + tileSize - 1) / tileSize;
+  parallelFor(outerSize * numBlocks, parallelGrain / (tileSize * inner.size),
+              [&](size_t begin, size_t end) {
+                Odometer odometer(outer, begin / numBlocks);
+                for (size_t item = begin; item < end; ++item) {
+                  size_t block = item % numBlocks;
+                  if (item > begin && block == 0) {
+                    odometer.next();
+                  }
+                  size_t r0 = block * tileSize;
+                  size_t rows = std::min(tileSize, tile.size - r0);
+                  for (size_t c0 = 0; c0 < inner.size; c0 += tileSize) {
+                    transposeTile(dst + odometer.dst() + r0 * tile.dst + c0,
+                                  tile.dst,
+                                  src + odometer.src() + r0 + c0 * inner.src,
+                                  inner.src, rows,
+                                  std::min(tileSize, inner.size - c0));
+                  }
+                }
+              });
+}
+
+void rowCopy(double *dst, const double *src, const std::vector<Dim> &outer,
+             const Dim &inner) {
+  if (outer.empty()) {
+    parallelFor(inner.size, parallelGrain, [&](size_t begin, size_t end) {
+      copyRow(dst + begin * inner.dst, inner.dst, src + begin * inner.src,
+              inner.src, end - begin);
+    });
+    return;
+  }
+
+  size_t outerSize = 1;
+  for (const Dim &dim : outer) {
+    outerSize *= dim.size;
+  }
+  parallelFor(outerSize, parallelGrain / inner.size,
+              [&](size_t begin, size_t end) {
+                Odometer odometer(outer, begin);
+                for (size_t i = begin; i < end; ++i, odometer.next()) {
+                  copyRow(dst + odometer.dst(), inner.dst,
+                          src + odometer.src(), inner.src, inner.size);
+                }
+              });
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+} // namespace
+
+void stridedCopy(double *dst, const array_t &dstStrides, const double *src,
+                 const array_t &srcStrides, const array_t &shape) {
+  if (std::find(shape.begin(), shape.end(), 0) != shape.end()) {
+    return;
+  }
+
+  auto dims = canonicalDims(shape, dstStrides, srcStrides);
+  if (dims.empty()) {
+    *dst = *src;
+    return;
+  }
+
+  Dim inner = dims.back();
+  dims.pop_back();
+
+  // a dimension that is contiguous in the source but not innermost in the
+  // destination calls for a tiled (transposed) copy
+  if (inner.dst == 1 && inner.src != 1) {
+    auto it = std::find_if(dims.begin(), dims.end(),
+                           [](const Dim &dim) { return dim.src == 1; });
+    if (it != dims.end()) {
+      Dim tile = *it;
+      dims.erase(it);
+      tiledCopy(dst, src, dims, tile, inner);
+      return;
+    }
+  }
+
+  rowCopy(dst, src, dims, inner);
+}
+
+} // namespace gs
@@ -0,0 +1,180 @@
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#include "gradstudent/internal/fft.h"
+#include "gradstudent/internal/parallel.h"
+
+namespace gs {
+
+namespace {
+
+using complex = std::complex<double>;
+
+constexpr double pi = 3.14159265358979323846;
+
+// plain complex multiplication (std::complex checks for infinities and NaNs)
+inline complex mul(complex a, complex b) {
+  return {a.real() * b.real() - a.imag() * b.imag(),
+          a.real() * b.imag() + a.imag() * b.real()};
+}
+
+std::vector<complex> makeTwiddles(size_t n) {
+  std::vector<complex> result(n / 2);
+  for (size_t k = 0; k < n / 2; ++k) {
+    double angle = -2 * pi * static_cast<double>(k) / static_cast<double>(n);
+    result[k] = {std::cos(angle), std::sin(angle)};
+  }
+  return result;
+}
+
+// number of one-dimensional transforms of the given size per task
+size_t grain(size_t n) { return (1 << 14) / n + 1; }
+
+} // namespace
+
+size_t nextPow2(size_t n) {
+  size_t result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+/* COMPLEX FFT */
+
+FFT::FFT(size_t n) : n_(n), twiddles_(makeTwiddles(n)), bitrev_(n) {
+  if (n == 0 || (n & (n - 1)) != 0) {
+    std::stringstream ss;
+    ss << "FFT size must be a power of two, got " << n;
+    throw std::invalid_argument(ss.str());
+  }
+  size_t bits = 0;
+  while ((size_t{1} << bits) < n) {
+    ++bits;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    size_t r = 0;
+    for (size_t b = 0; b < bits; ++b) {
+      r |= ((i >> b) & 1) << (bits - 1 - b);
+    }
+    bitrev_[i] = r;
+  }
+}
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+void FFT::transform(complex *data, bool inverse) const {
+  for (size_t i = 0; i < n_; ++i) {
+    if (i < bitrev_[i]) {
+      std::swap(data[i], data[bitrev_[i]]);
+    }
+  }
+  for (size_t len = 2; len <= n_; len <<= 1) {
+    size_t half = len / 2;
+    size_t step = n_ / len;
+    for (size_t i = 0; i < n_; i += len) {
+      for (size_t k = 0; k < half; ++k) {
+        complex w = twiddles_[k * step];
+        if (inverse) {
+          w = std::conj(w);
+        }
+        complex u = data[i + k];
+        complex v = mul(data[i + k + half], w);
+        data[i + k] = u + v;
+        data[i + k + half] = u - v;
+      }
+    }
+  }
+}
+
+/* REAL FFT */
+
+RealFFT::RealFFT(size_t n)
+    : n_(n), half_(n / 2), twiddles_(makeTwiddles(n)) {}
+
+void RealFFT::forward(const double *in, complex *out) const {
+  size_t h = n_ / 2;
+  for (size_t k = 0; k < h; ++k) {
+    out[k] = {in[2 * k], in[2 * k + 1]};
+  }
+  half_.transform(out, false);
+
+  // separate the transforms of the even and odd elements and combine them
+  complex z0 = out[0];
+  out[0] = {z0.real() + z0.imag(), 0};
+  out[h] = {z0.real() - z0.imag(), 0};
+  for (size_t k = 1; k <= h / 2; ++k) {
+    complex a = out[k];
+    complex b = std::conj(out[h - k]);
+    complex even = 0.5 * (a + b);
+    complex odd = mul({0, -0.5}, a - b);
+    complex c = out[h - k];
+    complex d = std::conj(out[k]);
+    complex evenMirror = 0.5 * (c + d);
+    complex oddMirror = mul({0, -0.5}, c - d);
+    out[k] = even + mul(twiddles_[k], odd);
+    out[h - k] = evenMirror + mul(twiddles_[h - k], oddMirror);
+  }
+}
+
+void RealFFT::inverse(const complex *in, double *out) const {
+  size_t h = n_ / 2;
+  std::vector<complex> z(h);
+  for (size_t k = 0; k < h; ++k) {
+    complex a = in[k];
+    complex b = std::conj(in[h - k]);
+    complex even = a + b;
+    complex odd = mul(a - b, std::conj(twiddles_[k]));
+    z[k] = even + complex(-odd.imag(), odd.real()); // even + i * odd
+  }
+  half_.transform(z.data(), true);
+  for (size_t k = 0; k < h; ++k) {
+    out[2 * k] = z[k].real();
+    out[2 * k + 1] = z[k].imag();
+  }
+}
+
+/* 2D REAL FFT */
+
+RealFFT2D::RealFFT2D(size_t rows, size_t cols)
+    : colFFT_(rows), rowFFT_(cols) {}
+
+void RealFFT2D::transformColumns(complex *data, bool inverse) const {
+  size_t rows = colFFT_.size();
+  size_t cols = spectrumCols();
+  parallelFor(cols, grain(rows), [&](size_t begin, size_t end) {
+    std::vector<complex> column(rows);
+    for (size_t j = begin; j < end; ++j) {
+      for (size_t i = 0; i < rows; ++i) {
+        column[i] = data[i * cols + j];
+      }
+      colFFT_.transform(column.data(), inverse);
+      for (size_t i = 0; i < rows; ++i) {
+        data[i * cols + j] = column[i];
+      }
+    }
+  });
+}
+
+void RealFFT2D::forward(const double *in, complex *out) const {
+  parallelFor(rows(), grain(cols()), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      rowFFT_.forward(in + i * cols(), out + i * spectrumCols());
+    }
+  });
+  transformColumns(out, false);
+}
+
+void RealFFT2D::inverse(complex *in, double *out) const {
+  transformColumns(in, true);
+  parallelFor(rows(), grain(cols()), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      rowFFT_.inverse(in + i * spectrumCols(), out + i * cols());
+    }
+  });
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+} // namespace gs
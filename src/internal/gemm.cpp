@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "gradstudent/internal/gemm.h"
+#include "gradstudent/internal/parallel.h"
+
+namespace gs {
+
+namespace {
+
+// micro-tile shape, chosen so that the accumulators fit in registers
+constexpr size_t MR = 4;
+constexpr size_t NR = 4;
+
+// Panel sizes: an MC x KC block of A stays in L2 while it is multiplied by a
+// KC x NC panel of B, which stays in L3. Each task covers up to COLS columns
+// of the panel.
+constexpr size_t MC = 96;
+constexpr size_t KC = 256;
+constexpr size_t NC = 2048;
+constexpr size_t COLS = 128;
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+// Packs rows [i0, i0 + mc) and columns [p0, p0 + kc) of op(A) into slivers of
+// MR rows, each stored column by column. Rows past the end are zero.
+void packA(bool trans, const double *a, size_t lda, size_t i0, size_t p0,
+           size_t mc, size_t kc, double *buffer) {
+  for (size_t s = 0; s < mc; s += MR) {
+    size_t rows = std::min(MR, mc - s);
+    for (size_t i = 0; i < MR; ++i) {
+      double *dst = buffer + s * kc + i;
+      if (i >= rows) {
+        for (size_t p = 0; p < kc; ++p) {
+          dst[p * MR] = 0;
+        }
+      } else if (trans) {
+        const double *src = a + p0 * lda + i0 + s + i;
+        for (size_t p = 0; p < kc; ++p) {
+          dst[p * MR] = src[p * lda];
+        }
+      } else {
+        const double *src = a + (i0 + s + i) * lda + p0;
+        for (size_t p = 0; p < kc; ++p) {
+          dst[p * MR] = src[p];
+        }
+      }
+    }
+  }
+}
+
+// Packs rows [p0, p0 + kc) and columns [j0, j0 + nc) of op(B) into slivers of
+// NR columns, each stored row by row. Columns past the end are zero.
+void packB(bool trans, const double *b, size_t ldb, size_t p0, size_t j0,
+           size_t kc, size_t nc, double *buffer) {
+  for (size_t s = 0; s < nc; s += NR) {
+    size_t cols = std::min(NR, nc - s);
+    double *dst = buffer + s * kc;
+    for (size_t p = 0; p < kc; ++p) {
+      for (size_t j = 0; j < NR; ++j) {
+        if (j >= cols) {
+          dst[p * NR + j] = 0;
+        } else if (trans) {
+          dst[p * NR + j] = b[(j0 + s + j) * ldb + p0 + p];
+        } else {
+          dst[p * NR + j] = b[(p0 + p) * ldb + j0 + s + j];
+        }
+      }
+    }
+  }
+}
+
+// Computes the MR x NR product of packed slivers into ab (row-major)
+void microKernel(size_t kc, const double *ap, const double *bp, double *ab) {
+#ifdef __SSE2__
+  __m128d c00 = _mm_setzero_pd();
+  __m128d c01 = _mm_setzero_pd();
+  __m128d c10 = _mm_setzero_pd();
+  __m128d c11 = _mm_setzero_pd();
+  __m128d c20 = _mm_setzero_pd();
+  __m128d c21 = _mm_setzero_pd();
+  __m128d c30 = _mm_setzero_pd();
+  __m128d c31 = _mm_setzero_pd();
+  for (size_t p = 0; p < kc; ++p) {
+    __m128d b0 = _mm_loadu_pd(bp);
+    __m128d b1 = _mm_loadu_pd(bp + 2);
+    __m128d a0 = _mm_set1_pd(ap[0]);
+    __m128d a1 = _mm_set1_pd(ap[1]);
+    c00 = _mm_add_pd(c00, _mm_mul_pd(a0, b0));
+    c01 = _mm_add_pd(c01, _mm_mul_pd(a0, b1));
+    c10 = _mm_add_pd(c10, _mm_mul_pd(a1, b0));
+    c11 = _mm_add_pd(c11, _mm_mul_pd(a1, b1));
+    __m128d a2 = _mm_set1_pd(ap[2]);
+    __m128d a3 = _mm_set1_pd(ap[3]);
+    c20 = _mm_add_pd(c20, _mm_mul_pd(a2, b0));
+    c21 = _mm_add_pd(c21, _mm_mul_pd(a2, b1));
+    c30 = _mm_add_pd(c30, _mm_mul_pd(a3, b0));
+    c31 = _mm_add_pd(c31, _mm_mul_pd(a3, b1));
+    ap += MR;
+    bp += NR;
+  }
+  _mm_storeu_pd(ab, c00);
+  _mm_storeu_pd(ab + 2, c01);
+  _mm_storeu_pd(ab + 4, c10);
+  _mm_storeu_pd(ab + 6, c11);
+  _mm_storeu_pd(ab + 8, c20);
+  _mm_storeu_pd(ab + 10, c21);
+  _mm_storeu_pd(ab + 12, c30);
+  _mm_storeu_pd(ab + 14, c31);
+#else
+  std::fill(ab, ab + MR * NR, 0.0);
+  for (size_t p = 0; p < kc; ++p) {
+    for (size_t i = 0; i < MR; ++i) {
+      for (size_t j = 0; j < NR; ++j) {
+        ab[i * NR + j] += ap[i] * bp[j];
+      }
+    }
+    ap += MR;
+    bp += NR;
+  }
+#endif
+}
+
+// Writes alpha * ab + beta * C to the rows x cols corner of a tile of C
+void storeTile(const double *ab, size_t rows, size_t cols, double alpha,
+               double beta, double *c, size_t ldc) {
+  for (size_t i = 0; i < rows; ++i) {
+    double *row = c + i * ldc;
+    for (size_t j = 0; j < cols; ++j) {
+      row[j] = beta == 0 ? alpha * ab[i * NR + j]
+                         : alpha * ab[i * NR + j] + beta * row[j];
+    }
+  }
+}
+
+} // namespace
+
+void gemm(bool transA, bool transB, size_t m, size_t n, size_t k, double alpha,
+          const double *a, size_t lda, const double *b, size_t ldb,
+          double beta, double *c, size_t ldc) {
+  if (m == 0 || n == 0) {
+    return;
+  }
+  if (k == 0) {
+    for (size_t i = 0; i < m; ++i) {
+      for (size_t j = 0; j < n; ++j) {
+        c[i * ldc + j] = beta == 0 ? 0 : beta * c[i * ldc + j];
+      }
+    }
+    return;
+  }
+
+  std::vector<double> bPack(std::min(KC, k) *
+                            ((std::min(NC, n) + NR - 1) / NR * NR));
+  for (size_t jc = 0; jc < n; jc += NC) {
+    const size_t nc = std::min(NC, n - jc);
+    for (size_t pc = 0; pc < k; pc += KC) {
+      const size_t kc = std::min(KC, k - pc);
+      const double betaPanel = pc == 0 ? beta : 1;
+      packB(transB, b, ldb, pc, jc, kc, nc, bPack.data());
+
+      // tasks are (row block, column chunk) pairs in row-major order, so
+      // that consecutive tasks of a thread share their packed block of A
+      const size_t rowBlocks = (m + MC - 1) / MC;
+      const size_t chunks = (nc + COLS - 1) / COLS;
+      const size_t taskWork = std::min(MC, m) * kc * std::min(COLS, nc);
+      parallelFor(rowBlocks * chunks, (1 << 18) / taskWork + 1,
+                  [&](size_t begin, size_t end) {
+                    std::vector<double> aPack(MC * kc);
+                    double ab[MR * NR];
+                    size_t packed = rowBlocks;
+                    for (size_t t = begin; t < end; ++t) {
+                      const size_t ic = (t / chunks) * MC;
+                      const size_t mc = std::min(MC, m - ic);
+                      if (t / chunks != packed) {
+                        packed = t / chunks;
+                        packA(transA, a, lda, ic, pc, mc, kc, aPack.data());
+                      }
+                      const size_t j0 = (t % chunks) * COLS;
+                      const size_t j1 = std::min(nc, j0 + COLS);
+                      for (size_t jr = j0; jr < j1; jr += NR) {
+                        const size_t cols = std::min(NR, j1 - jr);
+                        for (size_t ir = 0; ir < mc; ir += MR) {
+                          microKernel(kc, aPack.data() + ir * kc,
+                                      bPack.data() + jr * kc, ab);
+                          storeTile(ab, std::min(MR, mc - ir), cols, alpha,
+                                    betaPanel,
+                                    c + (ic + ir) * ldc + jc + jr, ldc);
+                        }
+                      }
+                    }
+                  });
+    }
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+} // namespace gs
@@ -0,0 +1,28 @@
+#include <atomic>
+
+#include "gradstudent/internal/parallel.h"
+
+namespace gs {
+
+namespace {
+
+std::atomic<size_t> maxThreads{0};
+
+} // namespace
+
+size_t numThreads() {
+  size_t n = maxThreads.load(std::memory_order_relaxed);
+  if (n == 0) {
+    n = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+  return n;
+}
+
+void setNumThreads(size_t n) { maxThreads.store(n, std::memory_order_relaxed); }
+
+bool &inParallelRegion() {
+  thread_local bool flag = false;
+  return flag;
+}
+
+} // namespace gs
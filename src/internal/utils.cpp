@@ -2,6 +2,7 @@
 #include <sstream>
 
 #include "gradstudent/internal/utils.h"
+#include "gradstudent/span.h"
 #include "gradstudent/tensor.h"
 
 namespace gs {
@@ -17,6 +18,67 @@ array_t defaultStrides(const array_t &shape) {
   return strides;
 }
 
+bool reshapeStrides(array_t &out, const array_t &shape, const array_t &strides,
+                    const array_t &newShape) {
+  if (prod(newShape) == 0) {
+    out = defaultStrides(newShape);
+    return true;
+  }
+
+  // unit dimensions don't constrain the view
+  std::vector<size_t> oldDims;
+  std::vector<size_t> oldStrides;
+  for (size_t i = 0; i < shape.size(); ++i) {
+    if (shape[i] != 1) {
+      oldDims.push_back(shape[i]);
+      oldStrides.push_back(strides[i]);
+    }
+  }
+
+  // match up groups of old and new dimensions with equal sizes
+  array_t result(newShape.size(), 1);
+  size_t oi = 0;
+  size_t oj = 1;
+  size_t ni = 0;
+  size_t nj = 1;
+  while (ni < newShape.size() && oi < oldDims.size()) {
+    size_t np = newShape[ni];
+    size_t op = oldDims[oi];
+    while (np != op) {
+      if (np < op) {
+        np *= newShape[nj++];
+      } else {
+        op *= oldDims[oj++];
+      }
+    }
+
+    // old dimensions in the group must be contiguous
+    for (size_t ok = oi; ok + 1 < oj; ++ok) {
+      if (oldStrides[ok] != oldDims[ok + 1] * oldStrides[ok + 1]) {
+        return false;
+      }
+    }
+
+    // new dimensions in the group get row-major strides
+    result[nj - 1] = oldStrides[oj - 1];
+    for (size_t nk = nj - 1; nk > ni; --nk) {
+      result[nk - 1] = result[nk] * newShape[nk];
+    }
+
+    ni = nj++;
+    oi = oj++;
+  }
+
+  // any remaining new dimensions have unit size
+  size_t last = ni > 0 ? result[ni - 1] : 1;
+  for (size_t nk = ni; nk < newShape.size(); ++nk) {
+    result[nk] = last;
+  }
+
+  out = result;
+  return true;
+}
+
 std::vector<int> broadcastShapes(array_t &out, const array_t &left,
                                  const array_t &right) {
   out = left.size() > right.size() ? left : right;
@@ -49,6 +111,36 @@ std::vector<int> broadcastShapes(array_t &out, const array_t &left,
   return mask;
 }
 
+bool isContiguous(const Tensor &tensor) {
+  const array_t &shape = tensor.shape();
+  const array_t &strides = tensor.strides();
+  size_t expected = 1;
+  for (size_t i = shape.size(); i-- > 0;) {
+    if (shape[i] != 1 && strides[i] != expected) {
+      return false;
+    }
+    expected *= shape[i];
+  }
+  return true;
+}
+
+Tensor contiguous(const Tensor &tensor) {
+  if (isContiguous(tensor)) {
+    return Tensor(tensor.shape(), tensor.strides(), tensor, tensor.offset(),
+                  true);
+  }
+  return Tensor(tensor);
+}
+
+double *mutableData(Tensor &tensor) {
+  if (tensor.ro() || !isContiguous(tensor)) {
+    throw std::invalid_argument(
+        "Cannot write to the data of a read-only or non-contiguous tensor");
+  }
+  Tensor flat = tensor.reshape({tensor.size()});
+  return makeSpan<1>(flat).data();
+}
+
 void checkCompatibleShape(const Tensor &left, const Tensor &right) {
   if (left.ndims() != right.ndims()) {
     std::ostringstream ss;
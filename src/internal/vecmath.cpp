@@ -0,0 +1,295 @@
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "gradstudent/internal/vecmath.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace gs {
+
+namespace {
+
+/* VECTOR PRIMITIVES */
+
+// A vector of doubles. Comparisons return masks with all bits of a lane set
+// when true, which are combined with select and the bitwise helpers.
+
+#ifdef __SSE2__
+
+struct Vec {
+  __m128d v;
+  static constexpr size_t width = 2;
+};
+
+inline Vec load(const double *p) { return {_mm_loadu_pd(p)}; }
+inline void store(double *p, Vec a) { _mm_storeu_pd(p, a.v); }
+inline Vec splat(double x) { return {_mm_set1_pd(x)}; }
+inline Vec splatBits(uint64_t bits) {
+  return {_mm_castsi128_pd(_mm_set1_epi64x(static_cast<int64_t>(bits)))};
+}
+
+inline Vec operator+(Vec a, Vec b) { return {_mm_add_pd(a.v, b.v)}; }
+inline Vec operator-(Vec a, Vec b) { return {_mm_sub_pd(a.v, b.v)}; }
+inline Vec operator*(Vec a, Vec b) { return {_mm_mul_pd(a.v, b.v)}; }
+inline Vec operator/(Vec a, Vec b) { return {_mm_div_pd(a.v, b.v)}; }
+inline Vec operator&(Vec a, Vec b) { return {_mm_and_pd(a.v, b.v)}; }
+inline Vec operator|(Vec a, Vec b) { return {_mm_or_pd(a.v, b.v)}; }
+
+// as with minpd and maxpd, the second operand is returned if either is NaN
+inline Vec min(Vec a, Vec b) { return {_mm_min_pd(a.v, b.v)}; }
+inline Vec max(Vec a, Vec b) { return {_mm_max_pd(a.v, b.v)}; }
+
+inline Vec lt(Vec a, Vec b) { return {_mm_cmplt_pd(a.v, b.v)}; }
+inline Vec eq(Vec a, Vec b) { return {_mm_cmpeq_pd(a.v, b.v)}; }
+inline Vec isNaN(Vec a) { return {_mm_cmpunord_pd(a.v, a.v)}; }
+
+inline Vec select(Vec mask, Vec a, Vec b) {
+  return {_mm_or_pd(_mm_and_pd(mask.v, a.v), _mm_andnot_pd(mask.v, b.v))};
+}
+
+inline Vec shiftLeft52(Vec a) {
+  return {_mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(a.v), 52))};
+}
+inline Vec shiftRight52(Vec a) {
+  return {_mm_castsi128_pd(_mm_srli_epi64(_mm_castpd_si128(a.v), 52))};
+}
+
+#else
+
+struct Vec {
+  double v;
+  static constexpr size_t width = 1;
+};
+
+inline uint64_t toBits(double x) {
+  uint64_t result = 0;
+  std::memcpy(&result, &x, sizeof(x));
+  return result;
+}
+inline Vec fromBits(uint64_t bits) {
+  double result = 0;
+  std::memcpy(&result, &bits, sizeof(bits));
+  return {result};
+}
+
+inline Vec load(const double *p) { return {*p}; }
+inline void store(double *p, Vec a) { *p = a.v; }
+inline Vec splat(double x) { return {x}; }
+inline Vec splatBits(uint64_t bits) { return fromBits(bits); }
+
+inline Vec operator+(Vec a, Vec b) { return {a.v + b.v}; }
+inline Vec operator-(Vec a, Vec b) { return {a.v - b.v}; }
+inline Vec operator*(Vec a, Vec b) { return {a.v * b.v}; }
+inline Vec operator/(Vec a, Vec b) { return {a.v / b.v}; }
+inline Vec operator&(Vec a, Vec b) {
+  return fromBits(toBits(a.v) & toBits(b.v));
+}
+inline Vec operator|(Vec a, Vec b) {
+  return fromBits(toBits(a.v) | toBits(b.v));
+}
+
+inline Vec min(Vec a, Vec b) { return {a.v < b.v ? a.v : b.v}; }
+inline Vec max(Vec a, Vec b) { return {a.v > b.v ? a.v : b.v}; }
+
+inline Vec mask(bool b) { return fromBits(b ? ~uint64_t{0} : 0); }
+inline Vec lt(Vec a, Vec b) { return mask(a.v < b.v); }
+inline Vec eq(Vec a, Vec b) { return mask(a.v == b.v); }
+inline Vec isNaN(Vec a) { return mask(a.v != a.v); }
+
+inline Vec select(Vec mask, Vec a, Vec b) {
+  return fromBits((toBits(mask.v) & toBits(a.v)) |
+                  (~toBits(mask.v) & toBits(b.v)));
+}
+
+inline Vec shiftLeft52(Vec a) { return fromBits(toBits(a.v) << 52); }
+inline Vec shiftRight52(Vec a) { return fromBits(toBits(a.v) >> 52); }
+
+#endif
+
+/* CONSTANTS */
+
+constexpr double inf = std::numeric_limits<double>::infinity();
+constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+
+constexpr uint64_t signMask = 0x8000000000000000;
+constexpr uint64_t absMask = 0x7fffffffffffffff;
+constexpr uint64_t exponentMask = 0x7ff0000000000000;
+constexpr uint64_t mantissaMask = 0x000fffffffffffff;
+constexpr uint64_t oneBits = 0x3ff0000000000000;
+
+constexpr double log2e = 1.44269504088896338700e+00;
+// ln(2) split so that k * ln2Hi is exact for |k| < 2^20
+constexpr double ln2Hi = 6.93147180369123816490e-01;
+constexpr double ln2Lo = 1.90821492927058770002e-10;
+constexpr double sqrt2 = 1.41421356237309514547e+00;
+constexpr double minNormal = std::numeric_limits<double>::min();
+constexpr double twoPow54 = 18014398509481984.0;
+// 2^52: adding a small non-negative integer stores it in the low mantissa
+// bits; 1.5 * 2^52 additionally rounds any |x| < 2^51 to an integer
+constexpr double twoPow52 = 4503599627370496.0;
+constexpr double roundShift = 6755399441055744.0;
+
+/* CORE APPROXIMATIONS */
+
+inline Vec round(Vec x) { return (x + splat(roundShift)) - splat(roundShift); }
+
+// 2^k for integral k in [-1022, 1023]
+inline Vec pow2(Vec k) { return shiftLeft52(k + splat(1023 + twoPow52)); }
+
+// Reduces x = k ln(2) + r with k integral and |r| <= ln(2) / 2 (approximately)
+// and returns expm1(r). x must lie in [-1100, 1100].
+inline Vec expm1Reduced(Vec x, Vec &k) {
+  k = round(x * splat(log2e));
+  Vec r = (x - k * splat(ln2Hi)) - k * splat(ln2Lo);
+
+  // truncated Taylor series of (exp(r) - 1 - r) / r^2, whose first omitted
+  // term is below 2^-57 relative to the result
+  Vec q = splat(1.0 / 6227020800);
+  q = q * r + splat(1.0 / 479001600);
+  q = q * r + splat(1.0 / 39916800);
+  q = q * r + splat(1.0 / 3628800);
+  q = q * r + splat(1.0 / 362880);
+  q = q * r + splat(1.0 / 40320);
+  q = q * r + splat(1.0 / 5040);
+  q = q * r + splat(1.0 / 720);
+  q = q * r + splat(1.0 / 120);
+  q = q * r + splat(1.0 / 24);
+  q = q * r + splat(1.0 / 6);
+  q = q * r + splat(0.5);
+  return r + r * r * q;
+}
+
+inline Vec expVec(Vec x) {
+  // beyond these bounds the result is 0 or infinity anyway
+  Vec xc = min(max(x, splat(-746)), splat(710));
+  Vec k{};
+  Vec p = expm1Reduced(xc, k);
+  // scale in two steps so that subnormal results and k = 1024 are handled
+  Vec k1 = round(k * splat(0.5));
+  Vec k2 = k - k1;
+  Vec result = ((splat(1) + p) * pow2(k1)) * pow2(k2);
+  return select(isNaN(x), x, result);
+}
+
+// expm1(x) for x in [-40, 0] (where k lies in [-58, 0])
+inline Vec expm1NonPositive(Vec x) {
+  Vec k{};
+  Vec p = expm1Reduced(x, k);
+  Vec scale = pow2(k);
+  return scale * p + (scale - splat(1));
+}
+
+inline Vec logVec(Vec x) {
+  // scale subnormals into the normal range
+  Vec small = lt(x, splat(minNormal));
+  Vec xs = select(small, x * splat(twoPow54), x);
+  Vec bias = select(small, splat(1023 + 54), splat(1023));
+
+  // x = 2^e * m with m in [sqrt(2) / 2, sqrt(2))
+  Vec biased =
+      shiftRight52(xs & splatBits(exponentMask)) | splat(twoPow52);
+  Vec e = (biased - splat(twoPow52)) - bias;
+  Vec m = (xs & splatBits(mantissaMask)) | splatBits(oneBits);
+  Vec big = lt(splat(sqrt2), m);
+  m = select(big, m * splat(0.5), m);
+  e = e + (big & splat(1));
+
+  // log(1 + f) = 2 atanh(s) = f - hfsq + s * (hfsq + R) with s = f / (2 + f)
+  // and R = 2 s^2 / 3 + 2 s^4 / 5 + ..., truncated where s^2 < 0.0295
+  // makes the remainder negligible
+  Vec f = m - splat(1);
+  Vec s = f / (splat(2) + f);
+  Vec z = s * s;
+  Vec r = splat(2.0 / 23);
+  r = r * z + splat(2.0 / 21);
+  r = r * z + splat(2.0 / 19);
+  r = r * z + splat(2.0 / 17);
+  r = r * z + splat(2.0 / 15);
+  r = r * z + splat(2.0 / 13);
+  r = r * z + splat(2.0 / 11);
+  r = r * z + splat(2.0 / 9);
+  r = r * z + splat(2.0 / 7);
+  r = r * z + splat(2.0 / 5);
+  r = r * z + splat(2.0 / 3);
+  r = r * z;
+  Vec hfsq = splat(0.5) * f * f;
+  Vec result =
+      e * splat(ln2Hi) - ((hfsq - (s * (hfsq + r) + e * splat(ln2Lo))) - f);
+
+  result = select(eq(x, splat(inf)), x, result);
+  result = select(eq(x, splat(0)), splat(-inf), result);
+  result = select(lt(x, splat(0)), splat(nan), result);
+  return select(isNaN(x), x, result);
+}
+
+inline Vec tanhVec(Vec x) {
+  Vec a = x & splatBits(absMask);
+  // tanh(20) rounds to 1
+  Vec e = expm1NonPositive(max(splat(-2) * a, splat(-40)));
+  Vec result = (splat(0) - e) / (e + splat(2));
+  result = result | (x & splatBits(signMask));
+  return select(isNaN(x), x, result);
+}
+
+inline Vec sigmoidVec(Vec x) {
+  Vec e = expVec(splat(0) - (x & splatBits(absMask)));
+  Vec d = splat(1) + e;
+  return select(lt(x, splat(0)), e / d, splat(1) / d);
+}
+
+inline Vec geluVec(Vec x) {
+  constexpr double c = 1.59576912160573071176; // 2 sqrt(2 / pi)
+  Vec z = splat(c) * (x + splat(0.044715) * x * x * x);
+  Vec result = x * sigmoidVec(z);
+  // the result underflows to -0 here, avoiding -inf * 0
+  return select(lt(x, splat(-30)), splat(-0.0), result);
+}
+
+/* DRIVER */
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+template <typename F>
+void apply(const double *in, double *out, size_t n, F f) {
+  constexpr size_t w = Vec::width;
+  size_t i = 0;
+  for (; i + w <= n; i += w) {
+    store(out + i, f(load(in + i)));
+  }
+  if (i < n) {
+    // pad the tail to a full vector
+    double buffer[w] = {};
+    std::memcpy(buffer, in + i, (n - i) * sizeof(double));
+    store(buffer, f(load(buffer)));
+    std::memcpy(out + i, buffer, (n - i) * sizeof(double));
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+} // namespace
+
+void vecExp(const double *in, double *out, size_t n) {
+  apply(in, out, n, expVec);
+}
+
+void vecLog(const double *in, double *out, size_t n) {
+  apply(in, out, n, logVec);
+}
+
+void vecTanh(const double *in, double *out, size_t n) {
+  apply(in, out, n, tanhVec);
+}
+
+void vecSigmoid(const double *in, double *out, size_t n) {
+  apply(in, out, n, sigmoidVec);
+}
+
+void vecGelu(const double *in, double *out, size_t n) {
+  apply(in, out, n, geluVec);
+}
+
+} // namespace gs
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gradstudent/internal/numpy.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/io.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+namespace io {
+
+namespace {
+
+// number of bytes read first from each file, which hold its header (and the
+// whole of small files)
+constexpr size_t prefixSize = 4096;
+
+// number of bytes per read of the rest of a file
+constexpr size_t chunkSize = size_t{1} << 20;
+
+// Where the payload of a file (after its header) goes
+struct Payload {
+  char *dst;
+  size_t bytes;
+  size_t offset;
+};
+
+// A read of part of a file
+struct Chunk {
+  size_t file;
+  char *dst;
+  size_t bytes;
+  size_t offset;
+  bool header;
+};
+
+// Descriptors of open files, closed on destruction
+class Files {
+
+private:
+  std::vector<int> fds_;
+  std::vector<size_t> sizes_;
+
+public:
+  explicit Files(const std::vector<std::string> &names) {
+    for (const std::string &name : names) {
+      int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+      struct stat info {};
+      if (fd >= 0 && fstat(fd, &info) != 0) {
+        close(fd);
+        fd = -1;
+      }
+      if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + name);
+      }
+      fds_.push_back(fd);
+      sizes_.push_back(static_cast<size_t>(info.st_size));
+    }
+  }
+
+  Files(const Files &) = delete;
+  Files &operator=(const Files &) = delete;
+
+  ~Files() {
+    for (int fd : fds_) {
+      close(fd);
+    }
+  }
+
+  int fd(size_t i) const { return fds_[i]; }
+
+  size_t size(size_t i) const { return sizes_[i]; }
+};
+
+// Reads the given files in two steps: the first bytes of each file, from
+// which parse(i, prefix) locates the payload of file i, and then the payload,
+// after which done(i) is called. Reads of all files are in flight at once,
+// and payloads contained in the prefix are copied rather than read again.
+template <typename Parse, typename Done>
+void readFiles(const std::vector<std::string> &names, const Files &files,
+               const ReaderOptions &options, const Parse &parse,
+               const Done &done) {
+  const size_t n = names.size();
+  std::vector<std::string> prefixes(n);
+  std::vector<size_t> remaining(n, 0); // payload chunks still to be read
+  std::vector<Chunk> chunks;
+
+  // declared last, so that reads in flight complete before buffers are freed
+  AsyncReader reader(options);
+  auto read = [&](const Chunk &chunk) {
+    chunks.push_back(chunk);
+    reader.read(files.fd(chunk.file), chunk.dst, chunk.bytes, chunk.offset,
+                chunks.size() - 1);
+  };
+
+  for (size_t i = 0; i < n; ++i) {
+    prefixes[i].resize(std::min(prefixSize, files.size(i)));
+    read({i, prefixes[i].data(), prefixes[i].size(), 0, true});
+  }
+
+  std::vector<Completion> completions;
+  while (reader.pending() > 0) {
+    completions.clear();
+    reader.wait(completions);
+    for (const Completion &completion : completions) {
+      const Chunk chunk = chunks[completion.tag];
+      const size_t i = chunk.file;
+      if (completion.error != 0) {
+        throw std::system_error(completion.error, std::generic_category(),
+                                "Cannot read file: " + names[i]);
+      }
+      if (completion.bytes < chunk.bytes) {
+        if (completion.bytes == 0) {
+          throw std::runtime_error("Unexpected end of file: " + names[i]);
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        read({i, chunk.dst + completion.bytes, chunk.bytes - completion.bytes,
+              chunk.offset + completion.bytes, chunk.header});
+        continue;
+      }
+
+      if (!chunk.header) {
+        if (--remaining[i] == 0) {
+          done(i);
+        }
+        continue;
+      }
+      const Payload payload = parse(i, prefixes[i]);
+      if (payload.offset + payload.bytes > files.size(i)) {
+        throw std::runtime_error("Unexpected end of file: " + names[i]);
+      }
+      if (payload.offset + payload.bytes <= prefixes[i].size()) {
+        std::memcpy(payload.dst, prefixes[i].data() + payload.offset,
+                    payload.bytes);
+        done(i);
+        continue;
+      }
+      for (size_t begin = 0; begin < payload.bytes; begin += chunkSize) {
+        ++remaining[i];
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        read({i, payload.dst + begin,
+              std::min(chunkSize, payload.bytes - begin),
+              payload.offset + begin, false});
+      }
+    }
+  }
+}
+
+// Returns views of the tensors, which share their data
+std::vector<Tensor> release(std::vector<std::optional<Tensor>> &tensors) {
+  std::vector<Tensor> result;
+  result.reserve(tensors.size());
+  for (std::optional<Tensor> &tensor : tensors) {
+    result.emplace_back(tensor->shape(), tensor->strides(), *tensor);
+  }
+  return result;
+}
+
+// Returns the next token of a PGM header, skipping whitespace and comments
+std::string pgmToken(const std::string &header, size_t &pos) {
+  while (pos < header.size()) {
+    if (header[pos] == '#') {
+      pos = std::min(header.find('\n', pos), header.size());
+    } else if (std::isspace(static_cast<unsigned char>(header[pos])) != 0) {
+      ++pos;
+    } else {
+      break;
+    }
+  }
+  size_t start = pos;
+  while (pos < header.size() &&
+         std::isspace(static_cast<unsigned char>(header[pos])) == 0) {
+    ++pos;
+  }
+  return header.substr(start, pos - start);
+}
+
+} // namespace
+
+std::vector<Tensor> readNumpy(const std::vector<std::string> &names,
+                              const ReaderOptions &options) {
+  Files files(names);
+  std::vector<std::optional<Tensor>> tensors(names.size());
+  auto parse = [&](size_t i, const std::string &prefix) -> Payload {
+    // the header fits in the prefix unless it is unusually long
+    std::string header = prefix;
+    if (header.size() >= 10) {
+      size_t length = static_cast<unsigned char>(header[8]) +
+                      256 * size_t{static_cast<unsigned char>(header[9])};
+      if (10 + length > header.size() && 10 + length <= files.size(i)) {
+        header.resize(10 + length);
+        if (pread(files.fd(i), header.data(), header.size(), 0) !=
+            static_cast<ssize_t>(header.size())) {
+          throw std::runtime_error("Cannot read file: " + names[i]);
+        }
+      }
+    }
+    std::istringstream stream(header);
+    numpy_header parsed = parse_numpy_header(stream);
+    if (!stream) {
+      throw std::runtime_error("Truncated header: " + names[i]);
+    }
+    if (parsed.fortran_order) {
+      throw std::runtime_error("Fortran order is not supported.");
+    }
+    if (parsed.descr != "<f8") {
+      throw std::runtime_error("Unsupported dtype: " + parsed.descr);
+    }
+    tensors[i].emplace(parsed.shape);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return {reinterpret_cast<char *>(mutableData(*tensors[i])),
+            tensors[i]->size() * sizeof(double),
+            static_cast<size_t>(stream.tellg())};
+  };
+  readFiles(names, files, options, parse, [](size_t) {});
+  return release(tensors);
+}
+
+std::vector<Tensor> readImages(const std::vector<std::string> &names,
+                               const ReaderOptions &options) {
+  Files files(names);
+  std::vector<std::optional<Tensor>> tensors(names.size());
+  std::vector<std::vector<unsigned char>> pixels(names.size());
+  auto parse = [&](size_t i, const std::string &prefix) -> Payload {
+    size_t pos = 0;
+    std::string magic = pgmToken(prefix, pos);
+    if (magic != "P5") {
+      throw std::runtime_error("Unsupported image format. Header: " + magic);
+    }
+    size_t width = 0;
+    size_t height = 0;
+    size_t depth = 0;
+    try {
+      width = std::stoul(pgmToken(prefix, pos));
+      height = std::stoul(pgmToken(prefix, pos));
+      depth = std::stoul(pgmToken(prefix, pos));
+    } catch (const std::logic_error &) {
+      throw std::runtime_error("Cannot parse image header: " + names[i]);
+    }
+    if (depth > 255 || pos >= prefix.size()) {
+      throw std::runtime_error("Unsupported image: " + names[i]);
+    }
+    tensors[i].emplace(array_t{height, width});
+    pixels[i].resize(width * height);
+    // a single whitespace character separates the header from the pixels
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return {reinterpret_cast<char *>(pixels[i].data()), pixels[i].size(),
+            pos + 1};
+  };
+  auto done = [&](size_t i) {
+    Tensor flat = tensors[i]->reshape({pixels[i].size()});
+    double *dst = makeSpan<1>(flat).data();
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    std::copy(pixels[i].begin(), pixels[i].end(), dst);
+    pixels[i] = {};
+  };
+  readFiles(names, files, options, parse, done);
+  return release(tensors);
+}
+
+} // namespace io
+} // namespace gs
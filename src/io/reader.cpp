@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "gradstudent/io.h"
+
+namespace gs {
+namespace io {
+
+/** @brief Backend of an AsyncReader */
+class AsyncReader::Engine {
+public:
+  virtual ~Engine() = default;
+
+  // Starts the given reads
+  virtual void submit(const std::vector<ReadRequest> &requests) = 0;
+
+  // Appends at least min completions, blocking as needed
+  virtual size_t reap(std::deque<Completion> &out, size_t min) = 0;
+
+  virtual Backend backend() const = 0;
+};
+
+namespace {
+
+// longer reads are shortened, which callers handle like short reads
+constexpr size_t maxRead = size_t{1} << 30;
+
+/* IO_URING */
+
+// An io_uring instance, driven through raw system calls. Reads are tagged in
+// their user data, and the kernel consumes submission entries during
+// io_uring_enter, so entries are free again once it returns.
+class UringEngine : public AsyncReader::Engine {
+
+private:
+  int fd_ = -1;
+  io_uring_params params_{};
+  void *sqRing_ = MAP_FAILED;
+  void *cqRing_ = MAP_FAILED;
+  size_t sqRingSize_ = 0;
+  size_t cqRingSize_ = 0;
+  io_uring_sqe *sqes_ = nullptr;
+  size_t sqesSize_ = 0;
+
+  // ring fields, shared with the kernel
+  unsigned *sqTail_ = nullptr;
+  unsigned sqMask_ = 0;
+  unsigned *sqArray_ = nullptr;
+  unsigned *cqHead_ = nullptr;
+  unsigned *cqTail_ = nullptr;
+  unsigned cqMask_ = 0;
+  io_uring_cqe *cqes_ = nullptr;
+
+  template <typename T> T *field(void *ring, unsigned offset) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+  }
+
+  int enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    while (true) {
+      long result = syscall(__NR_io_uring_enter, fd_, toSubmit, minComplete,
+                            flags, nullptr, 0);
+      if (result >= 0) {
+        return static_cast<int>(result);
+      }
+      if (errno != EINTR) {
+        throw std::system_error(errno, std::generic_category(),
+                                "io_uring_enter");
+      }
+    }
+  }
+
+  void release() {
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqesSize_);
+    }
+    if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_) {
+      munmap(cqRing_, cqRingSize_);
+    }
+    if (sqRing_ != MAP_FAILED) {
+      munmap(sqRing_, sqRingSize_);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  // Checks that the kernel supports IORING_OP_READ (5.6 and later), since
+  // earlier kernels with io_uring fail every read
+  void probeRead() {
+    // the probe header is followed by one entry per opcode
+    constexpr size_t header =
+        sizeof(io_uring_probe) / sizeof(io_uring_probe_op);
+    constexpr unsigned numOps = 256;
+    std::vector<io_uring_probe_op> buffer(header + numOps);
+    auto *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+    long result = syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE,
+                          probe, numOps);
+    int error = errno;
+    bool supported = result >= 0 && IORING_OP_READ < probe->ops_len &&
+                     (buffer[header + IORING_OP_READ].flags &
+                      IO_URING_OP_SUPPORTED) != 0;
+    if (!supported) {
+      release();
+      throw std::system_error(result < 0 ? error : EOPNOTSUPP,
+                              std::generic_category(),
+                              "io_uring read operation");
+    }
+  }
+
+public:
+  explicit UringEngine(unsigned entries) {
+    long fd = syscall(__NR_io_uring_setup, entries, &params_);
+    if (fd < 0) {
+      throw std::system_error(errno, std::generic_category(),
+                              "io_uring_setup");
+    }
+    fd_ = static_cast<int>(fd);
+    probeRead();
+
+    sqRingSize_ = params_.sq_off.array + params_.sq_entries * sizeof(unsigned);
+    cqRingSize_ =
+        params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (params_.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+      sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (sqRing_ != MAP_FAILED) {
+      cqRing_ = single ? sqRing_
+                       : mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, fd_,
+                              IORING_OFF_CQ_RING);
+    }
+    sqesSize_ = params_.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = cqRing_ == MAP_FAILED
+                     ? MAP_FAILED
+                     : mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      int error = errno;
+      release();
+      throw std::system_error(error, std::generic_category(), "mmap");
+    }
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+    sqTail_ = field<unsigned>(sqRing_, params_.sq_off.tail);
+    sqMask_ = *field<unsigned>(sqRing_, params_.sq_off.ring_mask);
+    sqArray_ = field<unsigned>(sqRing_, params_.sq_off.array);
+    cqHead_ = field<unsigned>(cqRing_, params_.cq_off.head);
+    cqTail_ = field<unsigned>(cqRing_, params_.cq_off.tail);
+    cqMask_ = *field<unsigned>(cqRing_, params_.cq_off.ring_mask);
+    cqes_ = field<io_uring_cqe>(cqRing_, params_.cq_off.cqes);
+  }
+
+  UringEngine(const UringEngine &) = delete;
+  UringEngine &operator=(const UringEngine &) = delete;
+
+  ~UringEngine() override { release(); }
+
+  void submit(const std::vector<ReadRequest> &requests) override {
+    // the caller keeps at most sq_entries reads in flight
+    unsigned tail = *sqTail_;
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    for (const ReadRequest &request : requests) {
+      unsigned index = tail & sqMask_;
+      io_uring_sqe &sqe = sqes_[index];
+      std::memset(&sqe, 0, sizeof(sqe));
+      sqe.opcode = IORING_OP_READ;
+      sqe.fd = request.fd;
+      sqe.addr = reinterpret_cast<uint64_t>(request.dst);
+      sqe.len = static_cast<uint32_t>(request.bytes);
+      sqe.off = request.offset;
+      sqe.user_data = request.tag;
+      sqArray_[index] = index;
+      ++tail;
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    __atomic_store_n(sqTail_, tail, __ATOMIC_RELEASE);
+
+    auto remaining = static_cast<unsigned>(requests.size());
+    while (remaining > 0) {
+      int submitted = enter(remaining, 0, 0);
+      if (submitted == 0) {
+        throw std::system_error(EIO, std::generic_category(),
+                                "io_uring_enter submitted no reads");
+      }
+      remaining -= static_cast<unsigned>(submitted);
+    }
+  }
+
+  size_t reap(std::deque<Completion> &out, size_t min) override {
+    size_t count = 0;
+    while (true) {
+      unsigned head = *cqHead_;
+      unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+      for (; head != tail; ++head) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        const io_uring_cqe &cqe = cqes_[head & cqMask_];
+        out.push_back({cqe.user_data,
+                       cqe.res < 0 ? 0 : static_cast<size_t>(cqe.res),
+                       cqe.res < 0 ? -cqe.res : 0});
+        ++count;
+      }
+      __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+      if (count >= min) {
+        return count;
+      }
+      enter(0, static_cast<unsigned>(min - count), IORING_ENTER_GETEVENTS);
+    }
+  }
+
+  Backend backend() const override { return Backend::URING; }
+};
+
+/* THREADS */
+
+// A pool of threads issuing blocking preads
+class ThreadEngine : public AsyncReader::Engine {
+
+private:
+  std::mutex mutex_;
+  std::condition_variable requested_;
+  std::condition_variable completed_;
+  std::deque<ReadRequest> requests_;
+  std::deque<Completion> completions_;
+  bool stop_ = false;
+  std::vector<std::thread> threads_;
+
+  void work() {
+    while (true) {
+      ReadRequest request{};
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        requested_.wait(lock, [this] { return stop_ || !requests_.empty(); });
+        if (requests_.empty()) {
+          return;
+        }
+        request = requests_.front();
+        requests_.pop_front();
+      }
+      ssize_t result = -1;
+      do {
+        result = pread(request.fd, request.dst, request.bytes,
+                       static_cast<off_t>(request.offset));
+      } while (result < 0 && errno == EINTR);
+      Completion completion{request.tag,
+                            result < 0 ? 0 : static_cast<size_t>(result),
+                            result < 0 ? errno : 0};
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        completions_.push_back(completion);
+      }
+      completed_.notify_one();
+    }
+  }
+
+public:
+  explicit ThreadEngine(size_t threads) {
+    for (size_t i = 0; i < threads; ++i) {
+      threads_.emplace_back([this] { work(); });
+    }
+  }
+
+  ThreadEngine(const ThreadEngine &) = delete;
+  ThreadEngine &operator=(const ThreadEngine &) = delete;
+
+  ~ThreadEngine() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    requested_.notify_all();
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void submit(const std::vector<ReadRequest> &requests) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requests_.insert(requests_.end(), requests.begin(), requests.end());
+    }
+    requested_.notify_all();
+  }
+
+  size_t reap(std::deque<Completion> &out, size_t min) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    completed_.wait(lock, [&] { return completions_.size() >= min; });
+    size_t count = completions_.size();
+    out.insert(out.end(), completions_.begin(), completions_.end());
+    completions_.clear();
+    return count;
+  }
+
+  Backend backend() const override { return Backend::THREADS; }
+};
+
+} // namespace
+
+/* ASYNC READER */
+
+AsyncReader::AsyncReader(const ReaderOptions &options) : options_(options) {
+  if (options.queueDepth == 0 || options.threads == 0) {
+    std::stringstream ss;
+    ss << "Invalid reader options: queue depth " << options.queueDepth
+       << " and " << options.threads << " threads";
+    throw std::invalid_argument(ss.str());
+  }
+  if (options.backend != Backend::THREADS) {
+    try {
+      engine_ = std::make_unique<UringEngine>(
+          static_cast<unsigned>(options.queueDepth));
+    } catch (const std::system_error &) {
+      // e.g. kernels without io_uring, or sandboxes that disable it
+      if (options.backend == Backend::URING) {
+        throw;
+      }
+    }
+  }
+  if (!engine_) {
+    engine_ = std::make_unique<ThreadEngine>(options.threads);
+  }
+}
+
+AsyncReader::~AsyncReader() {
+  // the kernel or the threads may still write into the callers' buffers
+  if (inFlight_ > 0) {
+    try {
+      reap(inFlight_);
+    } catch (...) {
+    }
+  }
+}
+
+Backend AsyncReader::backend() const { return engine_->backend(); }
+
+void AsyncReader::reap(size_t min) {
+  inFlight_ -= engine_->reap(completed_, min);
+}
+
+void AsyncReader::read(int fd, void *dst, size_t bytes, uint64_t offset,
+                       uint64_t tag) {
+  bytes = std::min(bytes, maxRead);
+  if (queued_.size() + inFlight_ >= options_.queueDepth) {
+    submit();
+    reap(1);
+  }
+  queued_.push_back({fd, dst, bytes, offset, tag});
+}
+
+void AsyncReader::submit() {
+  if (queued_.empty()) {
+    return;
+  }
+  engine_->submit(queued_);
+  inFlight_ += queued_.size();
+  queued_.clear();
+}
+
+size_t AsyncReader::wait(std::vector<Completion> &completions, size_t min) {
+  submit();
+  min = std::min(min, inFlight_ + completed_.size());
+  if (completed_.size() < min) {
+    reap(min - completed_.size());
+  }
+  size_t count = completed_.size();
+  completions.insert(completions.end(), completed_.begin(), completed_.end());
+  completed_.clear();
+  return count;
+}
+
+} // namespace io
+} // namespace gs
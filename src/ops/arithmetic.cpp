@@ -1,37 +1,250 @@
+#include <functional>
+#include <sstream>
+
+#include "gradstudent/internal/parallel.h"
 #include "gradstudent/internal/utils.h"
 #include "gradstudent/iter.h"
 #include "gradstudent/ops.h"
+#include "gradstudent/span.h"
 
 namespace gs {
 
-Tensor operator+(const Tensor &left, const Tensor &right) {
-  auto [bleft, bright] = broadcast(left, right);
-  Tensor result(bleft.shape());
-  for (const auto &[res, lt, rt] : TensorIter(result, bleft, bright)) {
-    res = lt + rt;
+namespace {
+
+/* BROADCAST KERNELS */
+
+// How an operand broadcasts to the output shape
+enum class Pattern {
+  FULL,     // contiguous with the output shape
+  SCALAR,   // a single element
+  TRAILING, // contiguous, repeated along leading axes (e.g. bias per channel)
+  LEADING,  // contiguous, each element repeated along trailing axes (per row)
+  OTHER     // anything else
+};
+
+Pattern classify(const Tensor &tensor, const array_t &shape) {
+  if (tensor.size() == 1) {
+    return Pattern::SCALAR;
   }
-  return result;
+  if (!isContiguous(tensor)) {
+    return Pattern::OTHER;
+  }
+  if (tensor.size() == prod(shape)) {
+    return Pattern::FULL;
+  }
+  const array_t &tShape = tensor.shape();
+  size_t k = shape.size() - tShape.size(); // number of implicit leading 1s
+  auto dim = [&](size_t i) { return i < k ? 1 : tShape[i - k]; };
+
+  // unit dimensions followed by matching dimensions
+  size_t first = 0;
+  while (first < shape.size() && dim(first) == 1) {
+    ++first;
+  }
+  bool trailing = true;
+  for (size_t i = first; i < shape.size(); ++i) {
+    trailing = trailing && dim(i) == shape[i];
+  }
+  if (trailing) {
+    return Pattern::TRAILING;
+  }
+
+  // matching dimensions followed by unit dimensions
+  size_t last = shape.size();
+  while (last > 0 && dim(last - 1) == 1) {
+    --last;
+  }
+  for (size_t i = 0; i < last; ++i) {
+    if (dim(i) != shape[i]) {
+      return Pattern::OTHER;
+    }
+  }
+  return Pattern::LEADING;
 }
 
-Tensor operator*(const Tensor &left, const Tensor &right) {
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+// Computes op(full, other) (or op(other, full) if Swap) into out, where full
+// is contiguous with the output shape and other broadcasts as given by the
+// pattern. The broadcast operand is held fixed across the inner loops, which
+// run over contiguous memory.
+template <bool Swap, typename Op>
+void broadcastKernel(double *out, const double *full, const double *other,
+                     Pattern pattern, size_t size, size_t otherSize, Op op) {
+  auto apply = [op](double a, double b) { return Swap ? op(b, a) : op(a, b); };
+  const size_t grain = 1 << 16;
+  switch (pattern) {
+  case Pattern::FULL:
+    parallelFor(size, grain, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        out[i] = apply(full[i], other[i]);
+      }
+    });
+    break;
+  case Pattern::SCALAR: {
+    const double v = other[0];
+    parallelFor(size, grain, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        out[i] = apply(full[i], v);
+      }
+    });
+    break;
+  }
+  case Pattern::TRAILING: {
+    const size_t n = otherSize;
+    parallelFor(size / n, grain / n + 1, [&](size_t begin, size_t end) {
+      for (size_t r = begin; r < end; ++r) {
+        const double *f = full + r * n;
+        double *o = out + r * n;
+        for (size_t j = 0; j < n; ++j) {
+          o[j] = apply(f[j], other[j]);
+        }
+      }
+    });
+    break;
+  }
+  case Pattern::LEADING: {
+    const size_t n = size / otherSize;
+    parallelFor(otherSize, grain / n + 1, [&](size_t begin, size_t end) {
+      for (size_t r = begin; r < end; ++r) {
+        const double v = other[r];
+        const double *f = full + r * n;
+        double *o = out + r * n;
+        for (size_t j = 0; j < n; ++j) {
+          o[j] = apply(f[j], v);
+        }
+      }
+    });
+    break;
+  }
+  case Pattern::OTHER:
+    break;
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+template <typename Op>
+Tensor binaryOp(const Tensor &left, const Tensor &right, Op op) {
+  array_t shape;
+  broadcastShapes(shape, left.shape(), right.shape());
+  size_t size = prod(shape);
+  if (size == 0) {
+    return Tensor(shape);
+  }
+  Pattern lp = classify(left, shape);
+  Pattern rp = classify(right, shape);
+
+  // a scalar broadcast to a single element is also a full operand
+  bool leftFull = lp == Pattern::FULL || (lp == Pattern::SCALAR && size == 1);
+  bool rightFull =
+      rp == Pattern::FULL || (rp == Pattern::SCALAR && size == 1);
+  if ((leftFull && rp != Pattern::OTHER) ||
+      (rightFull && lp != Pattern::OTHER)) {
+    const Tensor l = flatten(left);
+    const Tensor r = flatten(right);
+    const double *lData = makeSpan<1>(l).data();
+    const double *rData = makeSpan<1>(r).data();
+    Tensor result(array_t{size});
+    double *out = makeSpan<1>(result).data();
+    if (leftFull) {
+      broadcastKernel<false>(out, lData, rData,
+                             rightFull ? Pattern::FULL : rp, size, r.size(),
+                             op);
+    } else {
+      broadcastKernel<true>(out, rData, lData, lp, size, l.size(), op);
+    }
+    return result.reshape(shape);
+  }
+
   auto [bleft, bright] = broadcast(left, right);
   Tensor result(bleft.shape());
   for (const auto &[res, lt, rt] : TensorIter(result, bleft, bright)) {
-    res = lt * rt;
+    res = op(lt, rt);
   }
   return result;
 }
 
-Tensor operator-(const Tensor &tensor) {
+// Applies f to each element in a single pass
+template <typename F> Tensor unaryOp(const Tensor &tensor, F f) {
   Tensor result(tensor.shape());
-  for (const auto &[res, val] : TensorIter(result, tensor)) {
-    res = -val;
+  if (!isContiguous(tensor)) {
+    for (const auto &[res, val] : TensorIter(result, tensor)) {
+      res = f(val);
+    }
+    return result;
   }
+
+  const Tensor in = flatten(tensor);
+  const double *inData = makeSpan<1>(in).data();
+  double *out = mutableData(result);
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  parallelFor(result.size(), 1 << 16, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      out[i] = f(inData[i]);
+    }
+  });
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
   return result;
 }
 
+} // namespace
+
+Tensor operator+(const Tensor &left, const Tensor &right) {
+  return binaryOp(left, right, std::plus<>());
+}
+
+Tensor operator*(const Tensor &left, const Tensor &right) {
+  return binaryOp(left, right, std::multiplies<>());
+}
+
+Tensor operator-(const Tensor &tensor) {
+  return unaryOp(tensor, [](double x) { return -x; });
+}
+
 Tensor operator-(const Tensor &left, const Tensor &right) {
-  return left + (-right);
+  return binaryOp(left, right, std::minus<>());
+}
+
+Tensor operator/(const Tensor &left, const Tensor &right) {
+  return binaryOp(left, right, std::divides<>());
+}
+
+Tensor operator+(const Tensor &tensor, double scalar) {
+  return unaryOp(tensor, [scalar](double x) { return x + scalar; });
+}
+
+Tensor operator+(double scalar, const Tensor &tensor) {
+  return unaryOp(tensor, [scalar](double x) { return scalar + x; });
+}
+
+Tensor operator-(const Tensor &tensor, double scalar) {
+  return unaryOp(tensor, [scalar](double x) { return x - scalar; });
+}
+
+Tensor operator-(double scalar, const Tensor &tensor) {
+  return unaryOp(tensor, [scalar](double x) { return scalar - x; });
+}
+
+Tensor operator*(const Tensor &tensor, double scalar) {
+  return unaryOp(tensor, [scalar](double x) { return x * scalar; });
+}
+
+Tensor operator*(double scalar, const Tensor &tensor) {
+  return unaryOp(tensor, [scalar](double x) { return scalar * x; });
+}
+
+Tensor operator/(const Tensor &tensor, double scalar) {
+  return unaryOp(tensor, [scalar](double x) { return x / scalar; });
+}
+
+Tensor operator/(double scalar, const Tensor &tensor) {
+  return unaryOp(tensor, [scalar](double x) { return scalar / x; });
+}
+
+Tensor affine(const Tensor &tensor, double scale, double shift) {
+  return unaryOp(tensor,
+                 [scale, shift](double x) { return scale * x + shift; });
 }
 
 bool operator==(const Tensor &left, const Tensor &right) {
@@ -45,4 +258,58 @@ bool operator==(const Tensor &left, const Tensor &right) {
   return true;
 }
 
-} // namespace gs
\ No newline at end of file
+Tensor addBias(const Tensor &input, const Tensor &bias, Layout layout) {
+  if (input.ndims() != 3 && input.ndims() != 4) {
+    std::stringstream ss;
+    ss << "Expected input of rank 3 or 4, got " << input.ndims();
+    throw std::invalid_argument(ss.str());
+  }
+  size_t channelAxis =
+      layout == Layout::NHWC ? input.ndims() - 1 : input.ndims() - 3;
+  size_t channels = input.shape()[channelAxis];
+  if (bias.shape() != array_t{channels}) {
+    std::stringstream ss;
+    ss << "Expected bias of shape " << array_t{channels} << ", got "
+       << bias.shape();
+    throw std::invalid_argument(ss.str());
+  }
+
+  // rows of channels (NHWC) or one plane per channel (NCHW)
+  size_t inner = prod(input.shape().sliceFrom(channelAxis + 1));
+  size_t rows = input.size() / (channels * inner);
+
+  const Tensor in = flatten(input);
+  const Tensor b = contiguous(bias);
+  Tensor result(array_t{input.size()});
+  double *out = makeSpan<1>(result).data();
+  const double *inData = makeSpan<1>(in).data();
+  const double *bData = makeSpan<1>(b).data();
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  if (layout == Layout::NHWC) {
+    parallelFor(rows, (1 << 16) / channels + 1, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        const double *src = inData + i * channels;
+        double *dst = out + i * channels;
+        for (size_t c = 0; c < channels; ++c) {
+          dst[c] = src[c] + bData[c];
+        }
+      }
+    });
+  } else {
+    parallelFor(rows * channels, (1 << 16) / inner + 1,
+                [&](size_t begin, size_t end) {
+                  for (size_t i = begin; i < end; ++i) {
+                    double v = bData[i % channels];
+                    const double *src = inData + i * inner;
+                    double *dst = out + i * inner;
+                    for (size_t j = 0; j < inner; ++j) {
+                      dst[j] = src[j] + v;
+                    }
+                  }
+                });
+  }
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result.reshape(input.shape());
+}
+
+} // namespace gs
@@ -1,6 +1,8 @@
 #include <functional>
 #include <sstream>
+#include <vector>
 
+#include "gradstudent/internal/conv.h"
 #include "gradstudent/iter.h"
 #include "gradstudent/ops.h"
 
@@ -29,28 +31,20 @@ void slidingWindowTransformNoStride(
       transform);
 }
 
-void slidingWindowTransformFullStride(
-    Tensor &result, const Tensor &input, const array_t &windowShape,
-    const std::function<double(Tensor)> &transform) {
-  slidingWindowTransform(
-      result, input,
-      [&](const Tensor &input, const array_t &resIdx) {
-        return truncate(input, resIdx * windowShape,
-                        resIdx * windowShape + windowShape);
-      },
-      transform);
-}
-
 /* CONVOLUTION OVER ALL DIMENSIONS */
 
+void singleConvInto(Tensor &result, const Tensor &input, const Tensor &kernel,
+                    size_t n) {
+  slidingWindowTransformNoStride(
+      result, input, kernel.shape().sliceTo(n),
+      [&](const Tensor &window) { return sum(window * kernel); });
+}
+
 Tensor singleConv(const Tensor &input, const Tensor &kernel, size_t n) {
   array_t kernel_shape = kernel.shape().sliceTo(n);
   array_t result_shape = input.shape().sliceTo(n) - kernel_shape + 1;
   Tensor result(result_shape);
-  slidingWindowTransformNoStride(
-      result, input, kernel_shape,
-      [&](const Tensor &window) { return sum(window * kernel); });
-
+  singleConvInto(result, input, kernel, n);
   return result;
 }
 
@@ -59,14 +53,49 @@ Tensor multiConv(const Tensor &input, const Tensor &kernel, size_t n) {
   array_t singleResultShape = input.shape().sliceTo(n) - singleKernelShape + 1;
   auto resultShape = array_t{kernel.shape()[0]} | singleResultShape;
 
+  // each filter writes straight into its slice of the result
   Tensor result(resultShape);
+  std::vector<Tensor> outputs = unstack(result, 0);
   for (size_t i = 0; i < kernel.shape()[0]; ++i) {
-    slice(result, {i}) = singleConv(input, slice(kernel, array_t{i}), n);
+    singleConvInto(outputs[i], input, slice(kernel, array_t{i}), n);
   }
   return result;
 }
 
+array_t resolveConvOption(const array_t &option, size_t n, size_t value,
+                          const char *name) {
+  if (option.size() == 0) {
+    return array_t(n, value);
+  }
+  if (option.size() != n) {
+    std::stringstream ss;
+    ss << "Expected " << name << " of size " << n << ", got " << option;
+    throw std::invalid_argument(ss.str());
+  }
+  return option;
+}
+
+ConvOptions resolveConvOptions(const ConvOptions &options, size_t n) {
+  ConvOptions resolved{resolveConvOption(options.stride, n, 1, "stride"),
+                       resolveConvOption(options.dilation, n, 1, "dilation"),
+                       resolveConvOption(options.padding, n, 0, "padding")};
+  for (size_t i = 0; i < n; ++i) {
+    if (resolved.stride[i] == 0 || resolved.dilation[i] == 0) {
+      std::stringstream ss;
+      ss << "Stride and dilation must be positive, got " << resolved.stride
+         << " and " << resolved.dilation;
+      throw std::invalid_argument(ss.str());
+    }
+  }
+  return resolved;
+}
+
 Tensor conv(const Tensor &input, const Tensor &kernel, size_t n) {
+  return conv(input, kernel, ConvOptions{}, n);
+}
+
+Tensor conv(const Tensor &input, const Tensor &kernel,
+            const ConvOptions &options, size_t n) {
   if (n > input.ndims()) {
     std::stringstream ss;
     ss << "Convolution rank " << n << " exceeds input rank " << input.ndims();
@@ -87,61 +116,52 @@ Tensor conv(const Tensor &input, const Tensor &kernel, size_t n) {
   }
 
   n = n > 0 ? n : input.ndims();
-  if (kernel.ndims() == input.ndims()) {
-    return singleConv(input, kernel, n);
-  }
-  return multiConv(input, kernel, n);
-}
-
-/* MAX POOLING */
+  ConvOptions resolved = resolveConvOptions(options, n);
 
-Tensor singleMaxPool(const Tensor &input, const array_t &poolShape) {
-  array_t result_shape;
-  try {
-    result_shape = input.shape() / poolShape;
-  } catch (const std::invalid_argument &e) {
+  bool unit = resolved.stride == array_t(n, 1) &&
+              resolved.dilation == array_t(n, 1) &&
+              resolved.padding == array_t(n, 0);
+  if (unit && winogradApplicable(input, kernel, n)) {
+    return winogradConv(input, kernel);
+  }
+  if (unit && fftConvPreferred(input, kernel, n)) {
+    return fftConv(input, kernel, n);
+  }
+  if (directConvApplicable(input, kernel, n)) {
+    return directConv(input, kernel, n, resolved);
+  }
+  if (!unit) {
     std::stringstream ss;
-    ss << "Pool shape " << poolShape << " does not divide input shape "
-       << input.shape();
+    ss << "Strided, dilated or padded convolution requires matching "
+          "contracted shapes, got input "
+       << input.shape() << " and kernel " << kernel.shape();
     throw std::invalid_argument(ss.str());
   }
-  Tensor result(result_shape);
-
-  slidingWindowTransformFullStride(
-      result, input, poolShape,
-      [](const Tensor &window) { return max(window); });
-
-  return result;
+  if (kernel.ndims() == input.ndims()) {
+    return singleConv(input, kernel, n);
+  }
+  return multiConv(input, kernel, n);
 }
 
-Tensor maxPool(const Tensor &input, const array_t &poolShape) {
-  if (input.ndims() > poolShape.size() + 1) {
+Tensor conv(const Tensor &input, const Tensor &kernel, Layout layout,
+            const ConvOptions &options) {
+  if ((input.ndims() != 3 && input.ndims() != 4) || kernel.ndims() != 4) {
     std::stringstream ss;
-    ss << "Input rank must be at most one greater than pool rank, got "
-       << input.ndims() << " and " << poolShape.size();
+    ss << "Expected input of rank 3 or 4 and kernel of rank 4, got "
+       << input.ndims() << " and " << kernel.ndims();
     throw std::invalid_argument(ss.str());
   }
-  if (poolShape.size() == input.ndims()) {
-    return singleMaxPool(input, poolShape);
-  }
-
-  array_t inputSliceShape = input.shape().sliceFrom(1);
-  array_t resultSliceShape;
-  try {
-    resultSliceShape = inputSliceShape / poolShape;
-  } catch (const std::invalid_argument &e) {
+  size_t channelAxis = layout == Layout::NHWC ? input.ndims() - 1
+                                              : input.ndims() - 3;
+  size_t kernelChannelAxis = layout == Layout::NHWC ? 3 : 1;
+  if (input.shape()[channelAxis] != kernel.shape()[kernelChannelAxis]) {
     std::stringstream ss;
-    ss << "Pool shape " << poolShape << " does not divide input shape "
-       << input.shape();
+    ss << "Incompatible input shape " << input.shape() << " and kernel shape "
+       << kernel.shape();
     throw std::invalid_argument(ss.str());
   }
-  array_t result_shape = array_t{input.shape()[0]} | resultSliceShape;
-  Tensor result(result_shape);
 
-  for (size_t i = 0; i < input.shape()[0]; ++i) {
-    slice(result, {i}) = singleMaxPool(slice(input, {i}), poolShape);
-  }
-  return result;
+  return directConv2d(input, kernel, layout, resolveConvOptions(options, 2));
 }
 
 } // namespace gs
@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "gradstudent/internal/conv.h"
+#include "gradstudent/internal/gemm.h"
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+
+namespace {
+
+// maximum number of elements of each column buffer
+constexpr size_t maxColumns = size_t{1} << 20;
+
+struct Conv2dShape {
+  size_t batch;
+  size_t channels;
+  size_t filters;
+  ptrdiff_t h, w;   // input spatial shape
+  ptrdiff_t kh, kw; // kernel spatial shape
+  size_t p, q;      // output spatial shape
+  ptrdiff_t sh, sw;
+  ptrdiff_t dh, dw;
+  ptrdiff_t ph, pw;
+  size_t windowSize; // kh * kw * channels
+};
+
+Conv2dShape makeConv2dShape(const Tensor &input, const Tensor &kernel,
+                            Layout layout, const ConvOptions &options) {
+  const bool batched = input.ndims() == 4;
+  const array_t inShape = batched ? input.shape().sliceFrom(1) : input.shape();
+  const array_t &kShape = kernel.shape();
+  const bool nhwc = layout == Layout::NHWC;
+
+  Conv2dShape s{};
+  s.batch = batched ? input.shape()[0] : 1;
+  s.channels = nhwc ? inShape[2] : inShape[0];
+  s.filters = kShape[0];
+  s.h = static_cast<ptrdiff_t>(nhwc ? inShape[0] : inShape[1]);
+  s.w = static_cast<ptrdiff_t>(nhwc ? inShape[1] : inShape[2]);
+  s.kh = static_cast<ptrdiff_t>(nhwc ? kShape[1] : kShape[2]);
+  s.kw = static_cast<ptrdiff_t>(nhwc ? kShape[2] : kShape[3]);
+  s.sh = static_cast<ptrdiff_t>(options.stride[0]);
+  s.sw = static_cast<ptrdiff_t>(options.stride[1]);
+  s.dh = static_cast<ptrdiff_t>(options.dilation[0]);
+  s.dw = static_cast<ptrdiff_t>(options.dilation[1]);
+  s.ph = static_cast<ptrdiff_t>(options.padding[0]);
+  s.pw = static_cast<ptrdiff_t>(options.padding[1]);
+  s.p = static_cast<size_t>((s.h + 2 * s.ph - s.dh * (s.kh - 1) - 1) / s.sh +
+                            1);
+  s.q = static_cast<size_t>((s.w + 2 * s.pw - s.dw * (s.kw - 1) - 1) / s.sw +
+                            1);
+  s.windowSize = static_cast<size_t>(s.kh * s.kw) * s.channels;
+  return s;
+}
+
+// the image is read when unrolling and written when folding
+template <bool Fold>
+using ImagePtr = std::conditional_t<Fold, double *, const double *>;
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+// In NHWC layout, row o = (y, x) of the column matrix of an image holds the
+// window of output position o in (ky, kx, channel) order, so that each kernel
+// position contributes a contiguous run of channels. Rows [begin, end) are
+// written (Fold = false) or added back into the image (Fold = true).
+template <bool Fold>
+void unrollNHWC(ImagePtr<Fold> image, double *cols, const Conv2dShape &s,
+                size_t begin, size_t end) {
+  const size_t c = s.channels;
+  for (size_t o = begin; o < end; ++o) {
+    const ptrdiff_t y0 = static_cast<ptrdiff_t>(o / s.q) * s.sh - s.ph;
+    const ptrdiff_t x0 = static_cast<ptrdiff_t>(o % s.q) * s.sw - s.pw;
+    double *row = cols + o * s.windowSize;
+    for (ptrdiff_t ky = 0; ky < s.kh; ++ky) {
+      const ptrdiff_t y = y0 + ky * s.dh;
+      for (ptrdiff_t kx = 0; kx < s.kw; ++kx) {
+        const ptrdiff_t x = x0 + kx * s.dw;
+        double *dst = row + (ky * s.kw + kx) * static_cast<ptrdiff_t>(c);
+        const bool inside = y >= 0 && y < s.h && x >= 0 && x < s.w;
+        const ptrdiff_t pos = (y * s.w + x) * static_cast<ptrdiff_t>(c);
+        if constexpr (Fold) {
+          if (inside) {
+            for (size_t ch = 0; ch < c; ++ch) {
+              image[pos + static_cast<ptrdiff_t>(ch)] += dst[ch];
+            }
+          }
+        } else if (inside) {
+          std::copy(image + pos, image + pos + static_cast<ptrdiff_t>(c), dst);
+        } else {
+          std::fill(dst, dst + c, 0.0);
+        }
+      }
+    }
+  }
+}
+
+// In NCHW layout, row (channel, ky, kx) of the column matrix of an image holds
+// the input element under that kernel position for each output position.
+// Rows of channels [begin, end) are written (Fold = false) or added back into
+// the image (Fold = true).
+template <bool Fold>
+void unrollNCHW(ImagePtr<Fold> image, double *cols, const Conv2dShape &s,
+                size_t begin, size_t end) {
+  const size_t pq = s.p * s.q;
+  const auto q = static_cast<ptrdiff_t>(s.q);
+  for (size_t ch = begin; ch < end; ++ch) {
+    const ptrdiff_t plane = static_cast<ptrdiff_t>(ch) * s.h * s.w;
+    for (ptrdiff_t ky = 0; ky < s.kh; ++ky) {
+      for (ptrdiff_t kx = 0; kx < s.kw; ++kx) {
+        double *row =
+            cols + ((static_cast<ptrdiff_t>(ch) * s.kh + ky) * s.kw + kx) *
+                       static_cast<ptrdiff_t>(pq);
+        for (ptrdiff_t oy = 0; oy < static_cast<ptrdiff_t>(s.p); ++oy) {
+          const ptrdiff_t y = oy * s.sh - s.ph + ky * s.dh;
+          double *dst = row + oy * q;
+          if (y < 0 || y >= s.h) {
+            if (!Fold) {
+              std::fill(dst, dst + q, 0.0);
+            }
+            continue;
+          }
+          const ptrdiff_t line = plane + y * s.w;
+          for (ptrdiff_t ox = 0; ox < q; ++ox) {
+            const ptrdiff_t x = ox * s.sw - s.pw + kx * s.dw;
+            const bool inside = x >= 0 && x < s.w;
+            if constexpr (Fold) {
+              if (inside) {
+                image[line + x] += dst[ox];
+              }
+            } else {
+              dst[ox] = inside ? image[line + x] : 0.0;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+void conv2dBackwardNHWC(const double *g, const double *in, const double *k,
+                        const Conv2dShape &s, double *inGrad, double *kGrad) {
+  const size_t pq = s.p * s.q;
+  const size_t imageSize =
+      static_cast<size_t>(s.h * s.w) * s.channels;
+  const size_t rowWork = s.windowSize * s.filters;
+  // images are processed in chunks, so that each GEMM spans several images
+  const size_t chunk =
+      std::clamp<size_t>(maxColumns / (pq * s.windowSize), 1, s.batch);
+  std::vector<double> cols(chunk * pq * s.windowSize);
+
+  for (size_t b0 = 0; b0 < s.batch; b0 += chunk) {
+    const size_t nb = std::min(chunk, s.batch - b0);
+    const size_t rows = nb * pq;
+    const double *gChunk = g + b0 * pq * s.filters;
+    if (kGrad != nullptr) {
+      parallelFor(rows, (1 << 14) / s.windowSize + 1,
+                  [&](size_t begin, size_t end) {
+                    for (size_t r = begin; r < end;) {
+                      size_t b = r / pq;
+                      size_t stop = std::min(end, (b + 1) * pq);
+                      unrollNHWC<false>(in + (b0 + b) * imageSize,
+                                        cols.data() + b * pq * s.windowSize,
+                                        s, r % pq, r % pq + stop - r);
+                      r = stop;
+                    }
+                  });
+      // dK (f, window) += g^T (f, rows) x cols (rows, window)
+      gemm(true, false, s.filters, s.windowSize, rows, 1, gChunk, s.filters,
+           cols.data(), s.windowSize, b0 == 0 ? 0 : 1, kGrad, s.windowSize);
+    }
+    if (inGrad != nullptr) {
+      // dcols (rows, window) = g (rows, f) x K (f, window)
+      gemm(false, false, rows, s.windowSize, s.filters, 1, gChunk, s.filters,
+           k, s.windowSize, 0, cols.data(), s.windowSize);
+      parallelFor(nb, (1 << 14) / (pq * rowWork) + 1,
+                  [&](size_t begin, size_t end) {
+                    for (size_t b = begin; b < end; ++b) {
+                      unrollNHWC<true>(inGrad + (b0 + b) * imageSize,
+                                       cols.data() + b * pq * s.windowSize, s,
+                                       0, pq);
+                    }
+                  });
+    }
+  }
+}
+
+void conv2dBackwardNCHW(const double *g, const double *in, const double *k,
+                        const Conv2dShape &s, double *inGrad, double *kGrad) {
+  const size_t pq = s.p * s.q;
+  const size_t imageSize =
+      static_cast<size_t>(s.h * s.w) * s.channels;
+  const size_t channelWork = static_cast<size_t>(s.kh * s.kw) * pq;
+  std::vector<double> cols(s.windowSize * pq);
+
+  for (size_t b = 0; b < s.batch; ++b) {
+    const double *gImage = g + b * s.filters * pq;
+    if (kGrad != nullptr) {
+      parallelFor(s.channels, (1 << 14) / channelWork + 1,
+                  [&](size_t begin, size_t end) {
+                    unrollNCHW<false>(in + b * imageSize, cols.data(), s,
+                                      begin, end);
+                  });
+      // dK (f, window) += g (f, pq) x cols^T (pq, window)
+      gemm(false, true, s.filters, s.windowSize, pq, 1, gImage, pq,
+           cols.data(), pq, b == 0 ? 0 : 1, kGrad, s.windowSize);
+    }
+    if (inGrad != nullptr) {
+      // dcols (window, pq) = K^T (window, f) x g (f, pq)
+      gemm(true, false, s.windowSize, pq, s.filters, 1, k, s.windowSize,
+           gImage, pq, 0, cols.data(), pq);
+      parallelFor(s.channels, (1 << 14) / channelWork + 1,
+                  [&](size_t begin, size_t end) {
+                    unrollNCHW<true>(inGrad + b * imageSize, cols.data(),
+                                     s, begin, end);
+                  });
+    }
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+} // namespace
+
+void conv2dBackward(const Tensor &grad, const Tensor &input,
+                    const Tensor &kernel, Layout layout,
+                    const ConvOptions &options, Tensor *inputGrad,
+                    Tensor *kernelGrad) {
+  const Conv2dShape s = makeConv2dShape(input, kernel, layout, options);
+  const Tensor g = flatten(grad);
+  const Tensor in = flatten(input);
+  const Tensor k = flatten(kernel);
+  double *inGrad = nullptr;
+  double *kGrad = nullptr;
+  if (inputGrad != nullptr) {
+    inGrad = mutableData(*inputGrad);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    std::fill(inGrad, inGrad + inputGrad->size(), 0.0);
+  }
+  if (kernelGrad != nullptr) {
+    kGrad = mutableData(*kernelGrad);
+  }
+  if (s.batch == 0 || s.p * s.q == 0 || s.windowSize == 0) {
+    // no products contribute to the kernel gradient
+    if (kGrad != nullptr) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      std::fill(kGrad, kGrad + kernelGrad->size(), 0.0);
+    }
+    return;
+  }
+  if (layout == Layout::NHWC) {
+    conv2dBackwardNHWC(makeSpan<1>(g).data(), makeSpan<1>(in).data(),
+                       makeSpan<1>(k).data(), s, inGrad, kGrad);
+  } else {
+    conv2dBackwardNCHW(makeSpan<1>(g).data(), makeSpan<1>(in).data(),
+                       makeSpan<1>(k).data(), s, inGrad, kGrad);
+  }
+}
+
+} // namespace gs
@@ -1,17 +1,116 @@
-#include "gradstudent/iter.h"
+#include <sstream>
+#include <vector>
+
+#include "gradstudent/internal/parallel.h"
 #include "gradstudent/ops.h"
 #include "gradstudent/tensor.h"
 
 namespace gs {
 
+namespace {
+
+// minimum number of elements copied by each thread
+constexpr size_t parallelGrain = 1 << 16;
+
+// Copies each tensor into the view of the same index. With enough inputs to
+// occupy all threads, inputs are copied in parallel; otherwise the copy
+// engine splits each copy across threads.
+void copyInto(std::vector<Tensor> &views,
+              const std::vector<const Tensor *> &tensors) {
+  auto copy = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      views[i] = *tensors[i];
+    }
+  };
+  if (views.size() < numThreads()) {
+    copy(0, views.size());
+    return;
+  }
+  size_t total = 0;
+  for (const Tensor &view : views) {
+    total += view.size();
+  }
+  parallelFor(views.size(), parallelGrain * views.size() / (total + 1) + 1,
+              copy);
+}
+
+} // namespace
+
 // FLATTEN
 
+Tensor flatten(const Tensor &tensor, bool &copied) {
+  return tensor.reshape({tensor.size()}, copied);
+}
+
 Tensor flatten(const Tensor &tensor) {
-  auto result = Tensor(array_t{tensor.size()});
-  size_t i = 0;
-  for (const auto &[x] : TensorIter(tensor)) {
-    result[i++] = x;
+  bool copied = false;
+  return flatten(tensor, copied);
+}
+
+// CONCAT
+
+Tensor concat(const std::vector<const Tensor *> &tensors, size_t axis) {
+  if (tensors.empty()) {
+    throw std::invalid_argument("Expected at least one tensor to concatenate");
+  }
+  const Tensor &first = *tensors.front();
+  if (axis >= first.ndims()) {
+    std::stringstream ss;
+    ss << "Concatenation axis " << axis << " out of range for tensors of rank "
+       << first.ndims();
+    throw std::invalid_argument(ss.str());
+  }
+  array_t shape = first.shape();
+  shape[axis] = 0;
+  std::vector<size_t> sizes;
+  sizes.reserve(tensors.size());
+  for (const Tensor *tensor : tensors) {
+    bool valid = tensor->ndims() == first.ndims();
+    for (size_t i = 0; valid && i < first.ndims(); ++i) {
+      valid = i == axis || tensor->shape()[i] == first.shape()[i];
+    }
+    if (!valid) {
+      std::stringstream ss;
+      ss << "Cannot concatenate tensors of shapes " << first.shape() << " and "
+         << tensor->shape() << " along axis " << axis;
+      throw std::invalid_argument(ss.str());
+    }
+    sizes.push_back(tensor->shape()[axis]);
+    shape[axis] += sizes.back();
+  }
+
+  Tensor result(shape);
+  std::vector<Tensor> parts = split(result, sizes, axis);
+  copyInto(parts, tensors);
+  return result;
+}
+
+// STACK
+
+Tensor stack(const std::vector<const Tensor *> &tensors, size_t axis) {
+  if (tensors.empty()) {
+    throw std::invalid_argument("Expected at least one tensor to stack");
   }
+  const array_t &shape = tensors.front()->shape();
+  if (axis > shape.size()) {
+    std::stringstream ss;
+    ss << "Stacking axis " << axis << " out of range for tensors of rank "
+       << shape.size();
+    throw std::invalid_argument(ss.str());
+  }
+  for (const Tensor *tensor : tensors) {
+    if (tensor->shape() != shape) {
+      std::stringstream ss;
+      ss << "Cannot stack tensors of shapes " << shape << " and "
+         << tensor->shape();
+      throw std::invalid_argument(ss.str());
+    }
+  }
+
+  Tensor result(shape.sliceTo(axis) | array_t{tensors.size()} |
+                shape.sliceFrom(axis));
+  std::vector<Tensor> parts = unstack(result, axis);
+  copyInto(parts, tensors);
   return result;
 }
 
@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <vector>
+
+#include "gradstudent/internal/conv.h"
+#include "gradstudent/internal/copy.h"
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+
+namespace {
+
+struct DirectConvShape {
+  size_t n;                         // number of convolved dimensions
+  size_t channels;                  // contracted size
+  size_t filters;                   // number of filters
+  size_t batch;                     // number of images
+  size_t outSize;                   // number of output positions per image
+  size_t kRows;                     // number of kernel rows (all but last dim)
+  std::vector<ptrdiff_t> inShape;   // convolved input shape
+  std::vector<ptrdiff_t> inStrides; // input strides in positions
+  std::vector<size_t> kShape;       // convolved kernel shape
+  std::vector<size_t> outShape;     // convolved output shape
+  std::vector<ptrdiff_t> stride;
+  std::vector<ptrdiff_t> dilation;
+  std::vector<ptrdiff_t> padding;
+  ptrdiff_t inBatchStride;  // input elements per image
+  ptrdiff_t posStride;      // input stride between positions
+  ptrdiff_t channelStride;  // input stride between channels
+  size_t outBatchStride;    // output elements per image
+  size_t outPosStride;      // output stride between positions
+  size_t outFilterStride;   // output stride between filters
+};
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+// Computes outputs [begin, end) in flat (image, position) order. Input element
+// (b, y, ch) is at b * inBatchStride + y * posStride + ch * channelStride,
+// where y is a flat position in the (m_1, ..., m_n) grid. The kernel is
+// contiguous with shape (k_1, ..., k_n, c, f), so that the innermost loop runs
+// over filters. Window elements that fall in the padding are skipped.
+void directConvRange(double *out, const double *in, const double *kernel,
+                     const DirectConvShape &s, size_t begin, size_t end) {
+  const size_t n = s.n;
+  const size_t last = n - 1;
+  const size_t c = s.channels;
+  const size_t f = s.filters;
+  const ptrdiff_t kw = static_cast<ptrdiff_t>(s.kShape[last]);
+  const ptrdiff_t width = s.inShape[last];
+  const ptrdiff_t dw = s.dilation[last];
+  std::vector<double> acc(f);
+  std::vector<ptrdiff_t> origin(n);
+
+  for (size_t bo = begin; bo < end; ++bo) {
+    size_t b = bo / s.outSize;
+    size_t o = bo % s.outSize;
+    const double *image = in + static_cast<ptrdiff_t>(b) * s.inBatchStride;
+    size_t rem = o;
+    for (size_t d = n; d-- > 0;) {
+      auto p = static_cast<ptrdiff_t>(rem % s.outShape[d]);
+      rem /= s.outShape[d];
+      origin[d] = p * s.stride[d] - s.padding[d];
+    }
+
+    // range of kernel columns that fall inside the input
+    ptrdiff_t x0 = origin[last];
+    ptrdiff_t jlo = x0 < 0 ? (-x0 + dw - 1) / dw : 0;
+    ptrdiff_t jhi = x0 < width ? std::min(kw, (width - x0 + dw - 1) / dw) : 0;
+
+    std::fill(acc.begin(), acc.end(), 0.0);
+    for (size_t r = 0; r < s.kRows; ++r) {
+      size_t kRem = r;
+      ptrdiff_t row = 0;
+      bool inside = true;
+      for (size_t d = last; d-- > 0;) {
+        auto i = static_cast<ptrdiff_t>(kRem % s.kShape[d]);
+        kRem /= s.kShape[d];
+        ptrdiff_t y = origin[d] + i * s.dilation[d];
+        if (y < 0 || y >= s.inShape[d]) {
+          inside = false;
+          break;
+        }
+        row += y * s.inStrides[d];
+      }
+      if (!inside) {
+        continue;
+      }
+
+      const double *kr = kernel + r * s.kShape[last] * c * f;
+      for (ptrdiff_t j = jlo; j < jhi; ++j) {
+        const double *v = image + (row + x0 + j * dw) * s.posStride;
+        const double *kj = kr + j * static_cast<ptrdiff_t>(c * f);
+        for (size_t ch = 0; ch < c; ++ch) {
+          double x = v[static_cast<ptrdiff_t>(ch) * s.channelStride];
+          const double *kc = kj + ch * f;
+          for (size_t l = 0; l < f; ++l) {
+            acc[l] += x * kc[l];
+          }
+        }
+      }
+    }
+
+    double *res = out + b * s.outBatchStride + o * s.outPosStride;
+    for (size_t l = 0; l < f; ++l) {
+      res[l * s.outFilterStride] = acc[l];
+    }
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+// Fills in the spatial fields of s given the convolved input and kernel shapes
+void setConvGeometry(DirectConvShape &s, const array_t &inShape,
+                     const array_t &kShape, const ConvOptions &options) {
+  const size_t n = inShape.size();
+  s.n = n;
+  s.inShape.resize(n);
+  s.inStrides.resize(n);
+  s.kShape.resize(n);
+  s.outShape.resize(n);
+  s.stride.resize(n);
+  s.dilation.resize(n);
+  s.padding.resize(n);
+  s.kRows = 1;
+  s.outSize = 1;
+  for (size_t d = 0; d < n; ++d) {
+    size_t extent = options.dilation[d] * (kShape[d] - 1) + 1;
+    size_t padded = inShape[d] + 2 * options.padding[d];
+    if (extent > padded) {
+      std::stringstream ss;
+      ss << "Dilated kernel shape exceeds padded input shape along dimension "
+         << d << ": " << extent << " > " << padded;
+      throw std::invalid_argument(ss.str());
+    }
+    s.inShape[d] = static_cast<ptrdiff_t>(inShape[d]);
+    s.kShape[d] = kShape[d];
+    s.outShape[d] = (padded - extent) / options.stride[d] + 1;
+    s.stride[d] = static_cast<ptrdiff_t>(options.stride[d]);
+    s.dilation[d] = static_cast<ptrdiff_t>(options.dilation[d]);
+    s.padding[d] = static_cast<ptrdiff_t>(options.padding[d]);
+    s.outSize *= s.outShape[d];
+    if (d + 1 < n) {
+      s.kRows *= s.kShape[d];
+    }
+  }
+  for (size_t d = n; d-- > 0;) {
+    s.inStrides[d] = d + 1 < n ? s.inStrides[d + 1] * s.inShape[d + 1] : 1;
+  }
+}
+
+// Copies a kernel into (k_1, ..., k_n, c, f) order, given the strides (in the
+// contiguous kernel) of the filter, spatial and channel dimensions
+std::vector<double> rearrangeKernel(const Tensor &kernel, const DirectConvShape &s,
+                                    size_t filterStride,
+                                    const array_t &spatialStrides,
+                                    size_t channelStride) {
+  const Tensor g = flatten(kernel);
+  std::vector<double> result(g.size());
+  array_t inner = array_t(s.kShape) | array_t{s.channels};
+  array_t dstStrides =
+      array_t{1} |
+      (defaultStrides(inner) * array_t(inner.size(), s.filters));
+  array_t srcStrides =
+      array_t{filterStride} | spatialStrides | array_t{channelStride};
+  stridedCopy(result.data(), dstStrides, makeSpan<1>(g).data(), srcStrides,
+              array_t{s.filters} | inner);
+  return result;
+}
+
+void runDirectConv(double *out, const Tensor &input,
+                   const std::vector<double> &kernel,
+                   const DirectConvShape &s) {
+  const Tensor in = flatten(input);
+  const double *inData = makeSpan<1>(in).data();
+  size_t work = std::max<size_t>(kernel.size(), 1);
+  parallelFor(s.batch * s.outSize, (1 << 16) / work + 1,
+              [&](size_t begin, size_t end) {
+                directConvRange(out, inData, kernel.data(), s, begin, end);
+              });
+}
+
+} // namespace
+
+bool directConvApplicable(const Tensor &input, const Tensor &kernel,
+                          size_t n) {
+  size_t k = kernel.ndims() - input.ndims(); // number of filter dimensions
+  return n > 0 &&
+         kernel.shape().sliceFrom(k + n) == input.shape().sliceFrom(n);
+}
+
+Tensor directConv(const Tensor &input, const Tensor &kernel, size_t n,
+                  const ConvOptions &options) {
+  bool multi = kernel.ndims() > input.ndims();
+  size_t k = multi ? 1 : 0;
+  const array_t &inShape = input.shape();
+  const array_t &kShape = kernel.shape();
+
+  DirectConvShape s{};
+  s.channels = prod(inShape.sliceFrom(n));
+  s.filters = multi ? kShape[0] : 1;
+  s.batch = 1;
+  setConvGeometry(s, inShape.sliceTo(n), kShape.slice(k, k + n), options);
+  s.inBatchStride = 0;
+  s.posStride = static_cast<ptrdiff_t>(s.channels);
+  s.channelStride = 1;
+  s.outBatchStride = 0;
+  s.outPosStride = 1;
+  s.outFilterStride = s.outSize;
+
+  // the kernel has shape (f, k_1, ..., k_n, c)
+  array_t kStrides = defaultStrides(array_t{s.filters} | kShape.sliceFrom(k));
+  std::vector<double> kData = rearrangeKernel(
+      kernel, s, kStrides[0], kStrides.slice(1, 1 + n), 1);
+
+  Tensor result(array_t{s.filters, s.outSize});
+  runDirectConv(makeSpan<2>(result).data(), input, kData, s);
+
+  array_t resultShape(s.outShape);
+  return multi ? result.reshape(array_t{s.filters} | resultShape)
+               : result.reshape(resultShape);
+}
+
+Tensor directConv2d(const Tensor &input, const Tensor &kernel, Layout layout,
+                    const ConvOptions &options) {
+  const array_t &kShape = kernel.shape();
+  bool batched = input.ndims() == 4;
+  const array_t inShape = batched ? input.shape().sliceFrom(1) : input.shape();
+  bool nhwc = layout == Layout::NHWC;
+  array_t spatial = nhwc ? inShape.sliceTo(2) : inShape.sliceFrom(1);
+  array_t kSpatial = nhwc ? kShape.slice(1, 3) : kShape.sliceFrom(2);
+  size_t channels = nhwc ? inShape[2] : inShape[0];
+
+  DirectConvShape s{};
+  s.channels = channels;
+  s.filters = kShape[0];
+  s.batch = batched ? input.shape()[0] : 1;
+  setConvGeometry(s, spatial, kSpatial, options);
+  size_t inPositions = prod(spatial);
+  s.inBatchStride = static_cast<ptrdiff_t>(inPositions * channels);
+  s.posStride = nhwc ? static_cast<ptrdiff_t>(channels) : 1;
+  s.channelStride = nhwc ? 1 : static_cast<ptrdiff_t>(inPositions);
+  s.outBatchStride = s.outSize * s.filters;
+  s.outPosStride = nhwc ? s.filters : 1;
+  s.outFilterStride = nhwc ? 1 : s.outSize;
+
+  // the kernel has shape (f, kh, kw, c) for NHWC and (f, c, kh, kw) for NCHW
+  array_t kStrides = defaultStrides(kShape);
+  std::vector<double> kData =
+      nhwc ? rearrangeKernel(kernel, s, kStrides[0], kStrides.slice(1, 3),
+                             kStrides[3])
+           : rearrangeKernel(kernel, s, kStrides[0], kStrides.sliceFrom(2),
+                             kStrides[1]);
+
+  array_t outSpatial(s.outShape);
+  array_t outShape = nhwc ? outSpatial | array_t{s.filters}
+                          : array_t{s.filters} | outSpatial;
+  Tensor result(array_t{s.batch * s.outSize * s.filters});
+  runDirectConv(makeSpan<1>(result).data(), input, kData, s);
+  return batched ? result.reshape(array_t{s.batch} | outShape)
+                 : result.reshape(outShape);
+}
+
+} // namespace gs
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "gradstudent/internal/conv.h"
+#include "gradstudent/internal/fft.h"
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+
+namespace {
+
+using complex = std::complex<double>;
+
+struct FFTConvShape {
+  size_t height;    // input height (1 for 1D convolutions)
+  size_t width;     // input width
+  size_t channels;  // contracted size
+  size_t filters;   // number of filters
+  size_t kh;        // kernel height
+  size_t kw;        // kernel width
+  size_t outHeight; // output height
+  size_t outWidth;  // output width
+};
+
+FFTConvShape fftConvShape(const Tensor &input, const Tensor &kernel,
+                          size_t n) {
+  bool multi = kernel.ndims() > input.ndims();
+  size_t k = multi ? 1 : 0; // number of filter dimensions
+  const array_t &inShape = input.shape();
+  const array_t &kShape = kernel.shape();
+
+  FFTConvShape s{};
+  s.height = n == 2 ? inShape[0] : 1;
+  s.width = inShape[n - 1];
+  s.channels = prod(inShape.sliceFrom(n));
+  s.filters = multi ? kShape[0] : 1;
+  s.kh = n == 2 ? kShape[k] : 1;
+  s.kw = kShape[k + n - 1];
+  s.outHeight = s.height - s.kh + 1;
+  s.outWidth = s.width - s.kw + 1;
+  return s;
+}
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+// Copies channel c of the contiguous (h, w, channels) array src into the
+// top-left corner of the zero-filled (rows, cols) plane dst.
+void gatherPlane(double *dst, size_t rows, size_t cols, const double *src,
+                 size_t h, size_t w, size_t channels, size_t c) {
+  std::fill(dst, dst + rows * cols, 0.0);
+  for (size_t i = 0; i < h; ++i) {
+    for (size_t j = 0; j < w; ++j) {
+      dst[i * cols + j] = src[(i * w + j) * channels + c];
+    }
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+} // namespace
+
+bool fftConvPreferred(const Tensor &input, const Tensor &kernel, size_t n) {
+  if (n < 1 || n > 2 || n > input.ndims()) {
+    return false;
+  }
+  size_t k = kernel.ndims() - input.ndims(); // number of filter dimensions
+  const array_t &inShape = input.shape();
+  const array_t &kShape = kernel.shape();
+  if (kShape.sliceFrom(k + n) != inShape.sliceFrom(n)) {
+    return false;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    if (kShape[k + i] > inShape[i]) {
+      return false;
+    }
+  }
+
+  FFTConvShape s = fftConvShape(input, kernel, n);
+  double c = static_cast<double>(s.channels);
+  double f = static_cast<double>(s.filters);
+  double direct = f * c * static_cast<double>(s.outHeight * s.outWidth) *
+                  static_cast<double>(s.kh * s.kw);
+
+  // a real transform of size p costs roughly 2.5 p log2(p) flops and the
+  // products over the half spectrum roughly 4 p flops per filter and channel
+  double p = static_cast<double>(nextPow2(s.height) *
+                                 std::max<size_t>(nextPow2(s.width), 2));
+  double transforms = (c + f * c + f) * 2.5 * p * std::log2(p);
+  double products = 4 * f * c * p;
+  return transforms + products < direct;
+}
+
+Tensor fftConv(const Tensor &input, const Tensor &kernel, size_t n) {
+  bool multi = kernel.ndims() > input.ndims();
+  FFTConvShape s = fftConvShape(input, kernel, n);
+
+  const RealFFT2D fft(nextPow2(s.height),
+                      std::max<size_t>(nextPow2(s.width), 2));
+  const size_t planeSize = fft.rows() * fft.cols();
+  const size_t spectrumSize = fft.rows() * fft.spectrumCols();
+
+  const Tensor in = flatten(input);
+  const Tensor g = flatten(kernel);
+  const double *inData = makeSpan<1>(in).data();
+  const double *gData = makeSpan<1>(g).data();
+
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+  // transform each input channel once, to be reused by every filter
+  std::vector<complex> inSpectra(s.channels * spectrumSize);
+  parallelFor(s.channels, 1, [&](size_t begin, size_t end) {
+    std::vector<double> plane(planeSize);
+    for (size_t c = begin; c < end; ++c) {
+      gatherPlane(plane.data(), fft.rows(), fft.cols(), inData, s.height,
+                  s.width, s.channels, c);
+      fft.forward(plane.data(), inSpectra.data() + c * spectrumSize);
+    }
+  });
+
+  // correlation with each filter is the product of the input spectrum with the
+  // conjugate of the filter spectrum, summed over channels
+  Tensor result(array_t{s.filters, s.outHeight, s.outWidth});
+  double *out = makeSpan<3>(result).data();
+  const double scale = 1.0 / static_cast<double>(planeSize);
+  parallelFor(s.filters, 1, [&](size_t begin, size_t end) {
+    std::vector<double> plane(planeSize);
+    std::vector<complex> spectrum(spectrumSize);
+    std::vector<complex> acc(spectrumSize);
+    for (size_t l = begin; l < end; ++l) {
+      std::fill(acc.begin(), acc.end(), complex(0, 0));
+      const double *gl = gData + l * s.kh * s.kw * s.channels;
+      for (size_t c = 0; c < s.channels; ++c) {
+        gatherPlane(plane.data(), fft.rows(), fft.cols(), gl, s.kh, s.kw,
+                    s.channels, c);
+        fft.forward(plane.data(), spectrum.data());
+        const complex *x = inSpectra.data() + c * spectrumSize;
+        for (size_t i = 0; i < spectrumSize; ++i) {
+          complex a = x[i];
+          complex b = spectrum[i];
+          acc[i] += complex(a.real() * b.real() + a.imag() * b.imag(),
+                            a.imag() * b.real() - a.real() * b.imag());
+        }
+      }
+      fft.inverse(acc.data(), plane.data());
+
+      double *o = out + l * s.outHeight * s.outWidth;
+      for (size_t i = 0; i < s.outHeight; ++i) {
+        for (size_t j = 0; j < s.outWidth; ++j) {
+          o[i * s.outWidth + j] = plane[i * fft.cols() + j] * scale;
+        }
+      }
+    }
+  });
+
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+  array_t outShape =
+      n == 2 ? array_t{s.outHeight, s.outWidth} : array_t{s.outWidth};
+  return multi ? result.reshape(array_t{s.filters} | outShape)
+               : result.reshape(outShape);
+}
+
+} // namespace gs
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+
+namespace {
+
+/* EPILOGUE FUNCTIONS */
+
+template <Activation A> double activate(double x);
+
+template <> double activate<Activation::NONE>(double x) { return x; }
+
+template <> double activate<Activation::RELU>(double x) {
+  return std::max(0.0, x);
+}
+
+/* CONV BLOCK KERNEL */
+
+struct ConvBlockShape {
+  size_t width;    // input width
+  size_t channels; // input channels
+  size_t kh;       // kernel height
+  size_t kw;       // kernel width
+  size_t filters;  // number of filters
+  size_t ph;       // pool height
+  size_t pw;       // pool width
+  size_t outWidth; // output width (after pooling)
+};
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+// Computes rows [begin, end) of the pooled output. The input is contiguous with
+// shape (h, w, c) and the kernel is contiguous with shape (kh, kw, c, f), so
+// that the innermost loop runs over filters and accumulates in registers.
+template <Activation A, PoolType P>
+void convBlockRows(double *out, const double *in, const double *kernel,
+                   const double *bias, const ConvBlockShape &s, size_t begin,
+                   size_t end) {
+  const size_t f = s.filters;
+  const size_t rowLen = s.kw * s.channels;
+  std::vector<double> acc(f);
+  std::vector<double> pooled(f);
+
+  for (size_t py = begin; py < end; ++py) {
+    for (size_t px = 0; px < s.outWidth; ++px) {
+      std::fill(pooled.begin(), pooled.end(),
+                P == PoolType::AVG ? 0.0
+                                   : -std::numeric_limits<double>::infinity());
+
+      for (size_t dy = 0; dy < s.ph; ++dy) {
+        for (size_t dx = 0; dx < s.pw; ++dx) {
+          size_t y = py * s.ph + dy;
+          size_t x = px * s.pw + dx;
+
+          std::copy(bias, bias + f, acc.begin());
+          for (size_t i = 0; i < s.kh; ++i) {
+            const double *row = in + ((y + i) * s.width + x) * s.channels;
+            const double *k = kernel + i * rowLen * f;
+            for (size_t j = 0; j < rowLen; ++j) {
+              double v = row[j];
+              const double *kj = k + j * f;
+              for (size_t l = 0; l < f; ++l) {
+                acc[l] += v * kj[l];
+              }
+            }
+          }
+
+          for (size_t l = 0; l < f; ++l) {
+            double a = activate<A>(acc[l]);
+            pooled[l] = P == PoolType::AVG ? pooled[l] + a
+                                           : std::max(pooled[l], a);
+          }
+        }
+      }
+
+      double *o = out + (py * s.outWidth + px) * f;
+      double scale = P == PoolType::AVG ? 1.0 / (s.ph * s.pw) : 1.0;
+      for (size_t l = 0; l < f; ++l) {
+        o[l] = pooled[l] * scale;
+      }
+    }
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+template <Activation A, PoolType P>
+void convBlockKernel(double *out, const double *in, const double *kernel,
+                     const double *bias, const ConvBlockShape &s,
+                     size_t outHeight) {
+  size_t work = s.outWidth * s.ph * s.pw * s.kh * s.kw * s.channels * s.filters;
+  parallelFor(outHeight, (1 << 16) / std::max<size_t>(work, 1) + 1,
+              [&](size_t begin, size_t end) {
+                convBlockRows<A, P>(out, in, kernel, bias, s, begin, end);
+              });
+}
+
+template <Activation A>
+void convBlockDispatch(PoolType pool, double *out, const double *in,
+                       const double *kernel, const double *bias,
+                       const ConvBlockShape &s, size_t outHeight) {
+  if (pool == PoolType::AVG) {
+    convBlockKernel<A, PoolType::AVG>(out, in, kernel, bias, s, outHeight);
+  } else {
+    // no pooling is max pooling over 1x1 windows
+    convBlockKernel<A, PoolType::MAX>(out, in, kernel, bias, s, outHeight);
+  }
+}
+
+} // namespace
+
+Tensor convBlock(const Tensor &input, const Tensor &kernel, const Tensor &bias,
+                 const ConvEpilogue &epilogue) {
+  if (input.ndims() != 3 || kernel.ndims() != 4 || bias.ndims() != 1) {
+    std::stringstream ss;
+    ss << "Expected input, kernel and bias of ranks 3, 4 and 1, got "
+       << input.ndims() << ", " << kernel.ndims() << " and " << bias.ndims();
+    throw std::invalid_argument(ss.str());
+  }
+  const array_t &inShape = input.shape();
+  const array_t &kShape = kernel.shape();
+  if (kShape[3] != inShape[2] || bias.shape()[0] != kShape[0] ||
+      kShape[1] > inShape[0] || kShape[2] > inShape[1]) {
+    std::stringstream ss;
+    ss << "Incompatible shapes: input " << inShape << ", kernel " << kShape
+       << " and bias " << bias.shape();
+    throw std::invalid_argument(ss.str());
+  }
+
+  if (epilogue.pool != PoolType::NONE &&
+      (epilogue.poolShape.size() != 2 || epilogue.poolShape[0] == 0 ||
+       epilogue.poolShape[1] == 0)) {
+    std::stringstream ss;
+    ss << "Expected nonzero pool shape of size 2, got " << epilogue.poolShape;
+    throw std::invalid_argument(ss.str());
+  }
+
+  array_t convShape = array_t{inShape[0], inShape[1]} -
+                      array_t{kShape[1], kShape[2]} + 1;
+  array_t poolShape = epilogue.pool == PoolType::NONE ? array_t{1, 1}
+                                                      : epilogue.poolShape;
+  array_t outShape;
+  try {
+    outShape = convShape / poolShape;
+  } catch (const std::invalid_argument &e) {
+    std::stringstream ss;
+    ss << "Pool shape " << poolShape
+       << " does not divide convolution output shape " << convShape;
+    throw std::invalid_argument(ss.str());
+  }
+
+  ConvBlockShape s{};
+  s.width = inShape[1];
+  s.channels = inShape[2];
+  s.kh = kShape[1];
+  s.kw = kShape[2];
+  s.filters = kShape[0];
+  s.ph = poolShape[0];
+  s.pw = poolShape[1];
+  s.outWidth = outShape[1];
+
+  // filters innermost, so that each input element updates all accumulators
+  const Tensor in = contiguous(input);
+  const Tensor k = contiguous(permute(kernel, {1, 2, 3, 0}));
+  const Tensor b = contiguous(bias);
+  Tensor result(outShape | array_t{s.filters});
+
+  double *out = makeSpan<3>(result).data();
+  const double *inData = makeSpan<3>(in).data();
+  const double *kData = makeSpan<4>(k).data();
+  const double *bData = makeSpan<1>(b).data();
+  switch (epilogue.activation) {
+  case Activation::NONE:
+    convBlockDispatch<Activation::NONE>(epilogue.pool, out, inData, kData,
+                                        bData, s, outShape[0]);
+    break;
+  case Activation::RELU:
+    convBlockDispatch<Activation::RELU>(epilogue.pool, out, inData, kData,
+                                        bData, s, outShape[0]);
+    break;
+  }
+
+  return result;
+}
+
+} // namespace gs
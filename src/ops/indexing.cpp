@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+
+namespace {
+
+// minimum number of elements processed by each thread
+constexpr size_t parallelGrain = 1 << 14;
+
+// number of columns of the trailing dimensions handled by each scatter task
+constexpr size_t columnBlock = 256;
+
+// A tensor viewed as (outer, n, inner) around an axis
+struct AxisDims {
+  size_t outer;
+  size_t n;
+  size_t inner;
+};
+
+AxisDims axisDims(const Tensor &tensor, size_t axis, const char *op) {
+  if (axis >= tensor.ndims()) {
+    std::stringstream ss;
+    ss << op << " axis " << axis << " out of range for tensor of rank "
+       << tensor.ndims();
+    throw std::invalid_argument(ss.str());
+  }
+  const array_t &shape = tensor.shape();
+  return {prod(shape.sliceTo(axis)), shape[axis],
+          prod(shape.sliceFrom(axis + 1))};
+}
+
+// Checks that an index tensor of gather or scatter matches the tensor
+// indexed, except along the axis
+void checkIndexShape(const Tensor &tensor, size_t axis, const Tensor &indices) {
+  bool valid = indices.ndims() == tensor.ndims();
+  for (size_t i = 0; valid && i < tensor.ndims(); ++i) {
+    valid = i == axis || indices.shape()[i] == tensor.shape()[i];
+  }
+  if (!valid) {
+    std::stringstream ss;
+    ss << "Indices of shape " << indices.shape()
+       << " do not match tensor of shape " << tensor.shape()
+       << " outside axis " << axis;
+    throw std::invalid_argument(ss.str());
+  }
+}
+
+// Converts integral indices into an axis of size n, in row-major order
+std::vector<size_t> toIndices(const Tensor &indices, size_t n) {
+  const Tensor flat = flatten(indices);
+  const double *data = makeSpan<1>(flat).data();
+  std::vector<size_t> result(flat.size());
+  parallelFor(result.size(), parallelGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      double index = data[i];
+      if (!(index >= 0 && index < static_cast<double>(n))) {
+        std::stringstream ss;
+        ss << "Index " << index << " out of range for axis of size " << n;
+        throw std::invalid_argument(ss.str());
+      }
+      if (index != std::floor(index)) {
+        std::stringstream ss;
+        ss << "Index " << index << " is not an integer";
+        throw std::invalid_argument(ss.str());
+      }
+      result[i] = static_cast<size_t>(index);
+    }
+  });
+  return result;
+}
+
+// Returns the number of ranges into which to split the scattered axis, so
+// that tasks writing disjoint ranges keep all threads busy. Each task scans
+// all indices, keeping those in its range.
+size_t scatterParts(size_t tasks, size_t n) {
+  if (inParallelRegion() || tasks >= numThreads()) {
+    return 1;
+  }
+  return std::min(n, (numThreads() + tasks - 1) / tasks);
+}
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+void addRow(double *dst, const double *src, size_t n) {
+  size_t i = 0;
+#ifdef __SSE2__
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(dst + i,
+                  _mm_add_pd(_mm_loadu_pd(dst + i), _mm_loadu_pd(src + i)));
+  }
+#endif
+  for (; i < n; ++i) {
+    dst[i] += src[i];
+  }
+}
+
+Tensor scatterCommon(const Tensor &tensor, size_t axis, const Tensor &indices,
+                     const Tensor &src, bool add) {
+  const AxisDims dims = axisDims(tensor, axis, "Scatter");
+  const size_t outer = dims.outer;
+  const size_t n = dims.n;
+  const size_t inner = dims.inner;
+  checkIndexShape(tensor, axis, indices);
+  if (src.shape() != indices.shape()) {
+    std::stringstream ss;
+    ss << "Expected source of shape " << indices.shape() << ", got "
+       << src.shape();
+    throw std::invalid_argument(ss.str());
+  }
+  const size_t m = indices.shape()[axis];
+  const std::vector<size_t> idx = toIndices(indices, n);
+  const Tensor s = flatten(src);
+  const double *srcData = makeSpan<1>(s).data();
+  Tensor result = flatten(tensor);
+  double *out = makeSpan<1>(result).data();
+
+  // tasks own disjoint (slab, column block, axis range) regions of the
+  // result, and apply their updates in order of the indices
+  const size_t blocks = (inner + columnBlock - 1) / columnBlock;
+  const size_t parts = scatterParts(outer * blocks, n);
+  const size_t work = m * std::min(inner, columnBlock);
+  parallelFor(outer * blocks * parts, parallelGrain / (work + 1) + 1,
+              [&](size_t begin, size_t end) {
+                for (size_t t = begin; t < end; ++t) {
+                  const size_t o = t / (blocks * parts);
+                  const size_t b = (t / parts) % blocks;
+                  const size_t p = t % parts;
+                  const size_t lo = n * p / parts;
+                  const size_t hi = n * (p + 1) / parts;
+                  const size_t k0 = b * columnBlock;
+                  const size_t k1 = std::min(inner, k0 + columnBlock);
+                  double *slab = out + o * n * inner;
+                  for (size_t j = 0; j < m; ++j) {
+                    const size_t row = (o * m + j) * inner;
+                    for (size_t k = k0; k < k1; ++k) {
+                      const size_t d = idx[row + k];
+                      if (d < lo || d >= hi) {
+                        continue;
+                      }
+                      if (add) {
+                        slab[d * inner + k] += srcData[row + k];
+                      } else {
+                        slab[d * inner + k] = srcData[row + k];
+                      }
+                    }
+                  }
+                }
+              });
+  return result.reshape(tensor.shape());
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+} // namespace
+
+Tensor gather(const Tensor &tensor, size_t axis, const Tensor &indices) {
+  const AxisDims dims = axisDims(tensor, axis, "Gather");
+  const size_t outer = dims.outer;
+  const size_t n = dims.n;
+  const size_t inner = dims.inner;
+  checkIndexShape(tensor, axis, indices);
+  const size_t m = indices.shape()[axis];
+  const std::vector<size_t> idx = toIndices(indices, n);
+  const Tensor in = flatten(tensor);
+  const double *inData = makeSpan<1>(in).data();
+  Tensor result(array_t{indices.size()});
+  double *out = makeSpan<1>(result).data();
+
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  parallelFor(outer * m, parallelGrain / (inner + 1) + 1,
+              [&](size_t begin, size_t end) {
+                for (size_t r = begin; r < end; ++r) {
+                  const double *slab = inData + (r / m) * n * inner;
+                  const size_t *row = idx.data() + r * inner;
+                  double *dst = out + r * inner;
+                  for (size_t k = 0; k < inner; ++k) {
+                    dst[k] = slab[row[k] * inner + k];
+                  }
+                }
+              });
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result.reshape(indices.shape());
+}
+
+Tensor scatter(const Tensor &tensor, size_t axis, const Tensor &indices,
+               const Tensor &src) {
+  return scatterCommon(tensor, axis, indices, src, false);
+}
+
+Tensor scatterAdd(const Tensor &tensor, size_t axis, const Tensor &indices,
+                  const Tensor &src) {
+  return scatterCommon(tensor, axis, indices, src, true);
+}
+
+Tensor indexSelect(const Tensor &tensor, size_t axis, const Tensor &indices) {
+  const AxisDims dims = axisDims(tensor, axis, "Index select");
+  const size_t outer = dims.outer;
+  const size_t n = dims.n;
+  const size_t inner = dims.inner;
+  if (indices.ndims() != 1) {
+    std::stringstream ss;
+    ss << "Expected indices of rank 1, got rank " << indices.ndims();
+    throw std::invalid_argument(ss.str());
+  }
+  const size_t m = indices.size();
+  const std::vector<size_t> idx = toIndices(indices, n);
+  const Tensor in = flatten(tensor);
+  const double *inData = makeSpan<1>(in).data();
+  array_t shape = tensor.shape();
+  shape[axis] = m;
+  Tensor result(array_t{outer * m * inner});
+  double *out = makeSpan<1>(result).data();
+
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  parallelFor(outer * m, parallelGrain / (inner + 1) + 1,
+              [&](size_t begin, size_t end) {
+                for (size_t r = begin; r < end; ++r) {
+                  const size_t o = r / m;
+                  std::memcpy(out + r * inner,
+                              inData + (o * n + idx[r % m]) * inner,
+                              inner * sizeof(double));
+                }
+              });
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result.reshape(shape);
+}
+
+Tensor indexAdd(const Tensor &tensor, size_t axis, const Tensor &indices,
+                const Tensor &src) {
+  const AxisDims dims = axisDims(tensor, axis, "Index add");
+  const size_t outer = dims.outer;
+  const size_t n = dims.n;
+  const size_t inner = dims.inner;
+  if (indices.ndims() != 1) {
+    std::stringstream ss;
+    ss << "Expected indices of rank 1, got rank " << indices.ndims();
+    throw std::invalid_argument(ss.str());
+  }
+  const size_t m = indices.size();
+  array_t shape = tensor.shape();
+  shape[axis] = m;
+  if (src.shape() != shape) {
+    std::stringstream ss;
+    ss << "Expected source of shape " << shape << ", got " << src.shape();
+    throw std::invalid_argument(ss.str());
+  }
+  const std::vector<size_t> idx = toIndices(indices, n);
+  const Tensor s = flatten(src);
+  const double *srcData = makeSpan<1>(s).data();
+  Tensor result = flatten(tensor);
+  double *out = makeSpan<1>(result).data();
+
+  // tasks own disjoint (slab, axis range) regions of the result, and add
+  // rows in order of the indices
+  const size_t parts = scatterParts(outer, n);
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  parallelFor(outer * parts, parallelGrain / (m * inner + 1) + 1,
+              [&](size_t begin, size_t end) {
+                for (size_t t = begin; t < end; ++t) {
+                  const size_t o = t / parts;
+                  const size_t p = t % parts;
+                  const size_t lo = n * p / parts;
+                  const size_t hi = n * (p + 1) / parts;
+                  double *slab = out + o * n * inner;
+                  for (size_t i = 0; i < m; ++i) {
+                    if (idx[i] >= lo && idx[i] < hi) {
+                      addRow(slab + idx[i] * inner,
+                             srcData + (o * m + i) * inner, inner);
+                    }
+                  }
+                }
+              });
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result.reshape(tensor.shape());
+}
+
+} // namespace gs
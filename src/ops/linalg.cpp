@@ -1,11 +1,50 @@
-#include <numeric>
+#include <optional>
 #include <sstream>
+#include <utility>
 
-#include "gradstudent/iter.h"
+#include "gradstudent/internal/gemm.h"
+#include "gradstudent/internal/utils.h"
 #include "gradstudent/ops.h"
+#include "gradstudent/span.h"
 
 namespace gs {
 
+namespace {
+
+// A matrix operand of gemm
+struct Matrix {
+  const double *data;
+  size_t ld;
+  bool trans;
+};
+
+// Views a tensor as a rows x cols matrix. Contiguous tensors and matrices (or
+// vectors) whose elements are evenly spaced along one axis are read in place,
+// possibly transposed. Other tensors are first copied into storage.
+Matrix asMatrix(const Tensor &tensor, size_t rows, size_t cols,
+                std::optional<Tensor> &storage) {
+  if (tensor.ndims() <= 2 && tensor.size() > 0) {
+    const bool matrix = tensor.ndims() == 2;
+    const double *data = matrix ? makeSpan<2>(tensor).data()
+                                : makeSpan<1>(tensor).data();
+    // strides along the rows and columns, where size-1 axes are irrelevant
+    size_t rowStride = rows == 1 ? 1 : tensor.strides()[0];
+    size_t colStride =
+        cols == 1 ? 1 : tensor.strides()[tensor.ndims() - 1];
+    if (colStride == 1 && (rows == 1 || rowStride >= cols)) {
+      return {data, rows == 1 ? cols : rowStride, false};
+    }
+    if (rowStride == 1 && (cols == 1 || colStride >= rows)) {
+      return {data, cols == 1 ? rows : colStride, true};
+    }
+  }
+  const Tensor copy = contiguous(tensor).reshape({tensor.size()});
+  storage.emplace(copy.shape(), copy.strides(), copy, copy.offset(), true);
+  return {makeSpan<1>(std::as_const(*storage)).data(), cols, false};
+}
+
+} // namespace
+
 Tensor dot(const Tensor &left, const Tensor &right) {
   const array_t &left_shape = left.shape();
   const array_t &right_shape = right.shape();
@@ -18,29 +57,18 @@ Tensor dot(const Tensor &left, const Tensor &right) {
 
   array_t result_shape =
       left_shape.sliceTo(left_shape.size() - 1) | right_shape.sliceFrom(1);
-  Tensor result(result_shape);
-  const array_t &left_strides = left.strides();
-  const array_t &right_strides = right.strides();
-
-  for (auto res_it = TensorIter(result); res_it != res_it.end(); ++res_it) {
-    auto res_idx = res_it.index();
-    size_t thisIndex = std::inner_product(res_idx.begin(),
-                                          res_idx.begin() + (left.ndims() - 1),
-                                          left_strides.begin(), 0UL);
-    size_t otherIndex = std::inner_product(
-        res_idx.rbegin(), res_idx.rbegin() + (right.ndims() - 1),
-        right_strides.rbegin(), 0UL);
-
-    auto [res_val] = *res_it;
-    res_val = 0;
-    for (size_t j = 0; j < left.shape()[left.ndims() - 1]; ++j) {
-      res_val += left[thisIndex] * right[otherIndex];
-      thisIndex += left_strides[left.ndims() - 1];
-      otherIndex += right_strides[0];
-    }
-  }
+  const size_t k = right_shape[0];
+  const size_t m = prod(left_shape.sliceTo(left_shape.size() - 1));
+  const size_t n = prod(right_shape.sliceFrom(1));
 
-  return result;
+  std::optional<Tensor> leftStorage;
+  std::optional<Tensor> rightStorage;
+  Matrix a = asMatrix(left, m, k, leftStorage);
+  Matrix b = asMatrix(right, k, n, rightStorage);
+  Tensor result(array_t{m * n});
+  gemm(a.trans, b.trans, m, n, k, 1, a.data, a.ld, b.data, b.ld, 0,
+       makeSpan<1>(result).data(), n);
+  return result.reshape(result_shape);
 }
 
 Tensor norm2(const Tensor &tensor) {
@@ -0,0 +1,39 @@
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/vecmath.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+
+namespace {
+
+// Applies an array kernel to contiguous chunks of the tensor in parallel
+template <typename Kernel>
+Tensor applyKernel(const Tensor &tensor, Kernel kernel) {
+  const Tensor in = flatten(tensor);
+  const double *inData = makeSpan<1>(in).data();
+  Tensor result(array_t{tensor.size()});
+  double *out = makeSpan<1>(result).data();
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  parallelFor(tensor.size(), 1 << 14, [&](size_t begin, size_t end) {
+    kernel(inData + begin, out + begin, end - begin);
+  });
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result.reshape(tensor.shape());
+}
+
+} // namespace
+
+Tensor exp(const Tensor &tensor) { return applyKernel(tensor, vecExp); }
+
+Tensor log(const Tensor &tensor) { return applyKernel(tensor, vecLog); }
+
+Tensor tanh(const Tensor &tensor) { return applyKernel(tensor, vecTanh); }
+
+Tensor sigmoid(const Tensor &tensor) {
+  return applyKernel(tensor, vecSigmoid);
+}
+
+Tensor gelu(const Tensor &tensor) { return applyKernel(tensor, vecGelu); }
+
+} // namespace gs
@@ -0,0 +1,444 @@
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+
+namespace {
+
+struct PoolShape {
+  size_t n;                       // number of pooled dimensions
+  size_t batch;                   // product of the leading dimensions
+  size_t inner;                   // product of the trailing unpooled dimensions
+  size_t inSize;                  // number of input positions per batch
+  size_t outRows;                 // number of output rows per batch
+  std::vector<ptrdiff_t> inShape; // pooled input shape
+  std::vector<size_t> outShape;   // pooled output shape
+  std::vector<ptrdiff_t> window;
+  std::vector<ptrdiff_t> stride;
+  std::vector<ptrdiff_t> padding;
+};
+
+/* ROW KERNELS */
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+// acc[i] = max(acc[i], src[i * stride]) for i in [0, len)
+void maxRow(double *acc, const double *src, size_t len, ptrdiff_t stride) {
+  size_t i = 0;
+  if (stride == 1) {
+#ifdef __SSE2__
+    for (; i + 2 <= len; i += 2) {
+      __m128d a = _mm_loadu_pd(acc + i);
+      __m128d b = _mm_loadu_pd(src + i);
+      _mm_storeu_pd(acc + i, _mm_max_pd(a, b));
+    }
+#endif
+    for (; i < len; ++i) {
+      acc[i] = acc[i] > src[i] ? acc[i] : src[i];
+    }
+    return;
+  }
+  for (; i < len; ++i) {
+    double v = src[static_cast<ptrdiff_t>(i) * stride];
+    acc[i] = acc[i] > v ? acc[i] : v;
+  }
+}
+
+// acc[i] += src[i * stride] for i in [0, len)
+void sumRow(double *acc, const double *src, size_t len, ptrdiff_t stride) {
+  size_t i = 0;
+  if (stride == 1) {
+#ifdef __SSE2__
+    for (; i + 2 <= len; i += 2) {
+      __m128d a = _mm_loadu_pd(acc + i);
+      __m128d b = _mm_loadu_pd(src + i);
+      _mm_storeu_pd(acc + i, _mm_add_pd(a, b));
+    }
+#endif
+    for (; i < len; ++i) {
+      acc[i] += src[i];
+    }
+    return;
+  }
+  for (; i < len; ++i) {
+    acc[i] += src[static_cast<ptrdiff_t>(i) * stride];
+  }
+}
+
+// As maxRow, also recording the (flat input) index of each maximum. Ties are
+// resolved in favour of the first maximum.
+void argmaxRow(double *acc, double *arg, const double *src, size_t len,
+               ptrdiff_t stride, ptrdiff_t srcIndex) {
+  for (size_t i = 0; i < len; ++i) {
+    ptrdiff_t offset = static_cast<ptrdiff_t>(i) * stride;
+    double v = src[offset];
+    if (v > acc[i] || arg[i] < 0) {
+      acc[i] = v;
+      arg[i] = static_cast<double>(srcIndex + offset);
+    }
+  }
+}
+
+/* POOLING KERNEL */
+
+// Computes output rows [begin, end), where a row is the set of outputs
+// differing only in their last pooled index. For each window position outside
+// the last pooled dimension, the corresponding input row is swept once per
+// window column. Each position holds s.inner contiguous elements (e.g.
+// channels in NHWC layout), which are pooled independently.
+template <PoolType P, bool Indices>
+void poolRows(double *out, double *indices, const double *in,
+              const PoolShape &s, size_t begin, size_t end) {
+  const size_t n = s.n;
+  const size_t last = n - 1;
+  const size_t outWidth = s.outShape[last];
+  const size_t inner = s.inner;
+  const auto innerStride = static_cast<ptrdiff_t>(inner);
+  const ptrdiff_t width = s.inShape[last];
+  const ptrdiff_t sw = s.stride[last];
+  const ptrdiff_t pw = s.padding[last];
+
+  // range of outputs whose window contains each window column
+  std::vector<size_t> lo(s.window[last]);
+  std::vector<size_t> hi(s.window[last]);
+  std::vector<double> colCount(outWidth, 0);
+  for (ptrdiff_t j = 0; j < s.window[last]; ++j) {
+    ptrdiff_t first = j < pw ? (pw - j + sw - 1) / sw : 0;
+    // floor division, since columns past the input have no outputs
+    ptrdiff_t lastStart = width - 1 - j + pw;
+    ptrdiff_t past = lastStart < 0 ? 0 : lastStart / sw + 1;
+    lo[j] = static_cast<size_t>(first);
+    hi[j] = std::max(lo[j], std::min(outWidth, static_cast<size_t>(past)));
+    for (size_t ox = lo[j]; ox < hi[j]; ++ox) {
+      colCount[ox] += 1;
+    }
+  }
+
+  size_t windowRows = 1;
+  for (size_t d = 0; d < last; ++d) {
+    windowRows *= static_cast<size_t>(s.window[d]);
+  }
+  std::vector<ptrdiff_t> origin(n);
+
+  for (size_t r = begin; r < end; ++r) {
+    size_t b = r / s.outRows;
+    size_t rem = r % s.outRows;
+    for (size_t d = last; d-- > 0;) {
+      auto p = static_cast<ptrdiff_t>(rem % s.outShape[d]);
+      rem /= s.outShape[d];
+      origin[d] = p * s.stride[d] - s.padding[d];
+    }
+
+    const size_t rowSize = outWidth * inner;
+    double *acc = out + r * rowSize;
+    double *arg = Indices ? indices + r * rowSize : nullptr;
+    std::fill(acc, acc + rowSize,
+              P == PoolType::AVG ? 0.0
+                                 : -std::numeric_limits<double>::infinity());
+    if (Indices) {
+      std::fill(arg, arg + rowSize, -1.0);
+    }
+
+    size_t validRows = 0;
+    for (size_t wr = 0; wr < windowRows; ++wr) {
+      size_t wRem = wr;
+      ptrdiff_t row = 0;
+      ptrdiff_t rowStride = width;
+      bool inside = true;
+      for (size_t d = last; d-- > 0;) {
+        auto i = static_cast<ptrdiff_t>(wRem % s.window[d]);
+        wRem /= s.window[d];
+        ptrdiff_t y = origin[d] + i;
+        if (y < 0 || y >= s.inShape[d]) {
+          inside = false;
+          break;
+        }
+        row += y * rowStride;
+        rowStride *= s.inShape[d];
+      }
+      if (!inside) {
+        continue;
+      }
+      ++validRows;
+
+      ptrdiff_t rowIndex = static_cast<ptrdiff_t>(b * s.inSize) + row;
+      for (ptrdiff_t j = 0; j < s.window[last]; ++j) {
+        if (lo[j] >= hi[j]) {
+          continue;
+        }
+        ptrdiff_t x = static_cast<ptrdiff_t>(lo[j]) * sw + j - pw;
+        ptrdiff_t srcIndex = (rowIndex + x) * innerStride;
+        const double *src = in + srcIndex;
+        double *a = acc + lo[j] * inner;
+        double *ai = Indices ? arg + lo[j] * inner : nullptr;
+        size_t len = hi[j] - lo[j];
+        if (inner == 1 || sw == 1) {
+          // a single strided or contiguous sweep
+          size_t total = len * inner;
+          ptrdiff_t step = inner == 1 ? sw : 1;
+          if (Indices) {
+            argmaxRow(a, ai, src, total, step, srcIndex);
+          } else if (P == PoolType::AVG) {
+            sumRow(a, src, total, step);
+          } else {
+            maxRow(a, src, total, step);
+          }
+          continue;
+        }
+        for (size_t i = 0; i < len; ++i) {
+          ptrdiff_t offset = static_cast<ptrdiff_t>(i) * sw * innerStride;
+          if (Indices) {
+            argmaxRow(a + i * inner, ai + i * inner, src + offset, inner, 1,
+                      srcIndex + offset);
+          } else if (P == PoolType::AVG) {
+            sumRow(a + i * inner, src + offset, inner, 1);
+          } else {
+            maxRow(a + i * inner, src + offset, inner, 1);
+          }
+        }
+      }
+    }
+
+    if (P == PoolType::AVG) {
+      for (size_t ox = 0; ox < outWidth; ++ox) {
+        double count = static_cast<double>(validRows) * colCount[ox];
+        for (size_t ch = 0; ch < inner; ++ch) {
+          acc[ox * inner + ch] /= count;
+        }
+      }
+    }
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+array_t resolvePoolOption(const array_t &option, const array_t &defaultValue,
+                          const char *name) {
+  if (option.size() == 0) {
+    return defaultValue;
+  }
+  if (option.size() != defaultValue.size()) {
+    std::stringstream ss;
+    ss << "Expected " << name << " of size " << defaultValue.size() << ", got "
+       << option;
+    throw std::invalid_argument(ss.str());
+  }
+  return option;
+}
+
+// Pools over the poolShape.size() dimensions preceding the last `trailing`
+// dimensions of the input
+PoolShape makePoolShape(const Tensor &input, const array_t &poolShape,
+                        const PoolOptions &options, size_t trailing,
+                        array_t &outShape) {
+  const size_t n = poolShape.size();
+  if (n == 0 || n + trailing > input.ndims()) {
+    std::stringstream ss;
+    ss << "Pool rank must be positive and at most the input rank, got " << n
+       << " and " << input.ndims();
+    throw std::invalid_argument(ss.str());
+  }
+  array_t stride = resolvePoolOption(options.stride, poolShape, "stride");
+  array_t padding =
+      resolvePoolOption(options.padding, array_t(n, 0), "padding");
+
+  const size_t k = input.ndims() - n - trailing; // number of leading dimensions
+  const array_t &inShape = input.shape();
+  PoolShape s{};
+  s.n = n;
+  s.batch = prod(inShape.sliceTo(k));
+  s.inner = prod(inShape.sliceFrom(k + n));
+  s.inSize = prod(inShape.slice(k, k + n));
+  s.outRows = 1;
+  s.inShape.resize(n);
+  s.outShape.resize(n);
+  s.window.resize(n);
+  s.stride.resize(n);
+  s.padding.resize(n);
+  for (size_t d = 0; d < n; ++d) {
+    size_t m = inShape[k + d];
+    if (poolShape[d] == 0 || stride[d] == 0 || padding[d] >= poolShape[d] ||
+        poolShape[d] > m + 2 * padding[d]) {
+      std::stringstream ss;
+      ss << "Invalid pooling of input shape " << inShape << " with window "
+         << poolShape << ", stride " << stride << " and padding " << padding;
+      throw std::invalid_argument(ss.str());
+    }
+    s.inShape[d] = static_cast<ptrdiff_t>(m);
+    s.outShape[d] = (m + 2 * padding[d] - poolShape[d]) / stride[d] + 1;
+    s.window[d] = static_cast<ptrdiff_t>(poolShape[d]);
+    s.stride[d] = static_cast<ptrdiff_t>(stride[d]);
+    s.padding[d] = static_cast<ptrdiff_t>(padding[d]);
+    if (d + 1 < n) {
+      s.outRows *= s.outShape[d];
+    }
+  }
+
+  outShape = inShape.sliceTo(k) | array_t(s.outShape) | inShape.sliceFrom(k + n);
+  return s;
+}
+
+template <PoolType P, bool Indices>
+void runPool(const Tensor &input, const PoolShape &s, Tensor &result,
+             Tensor *indices) {
+  const Tensor in = flatten(input);
+  double *out = mutableData(result);
+  double *idx = Indices ? mutableData(*indices) : nullptr;
+  const double *inData = makeSpan<1>(in).data();
+  size_t rows = s.batch * s.outRows;
+  size_t windowSize = 1;
+  for (ptrdiff_t w : s.window) {
+    windowSize *= static_cast<size_t>(w);
+  }
+  size_t rowWork = windowSize * s.outShape[s.n - 1] * s.inner;
+  parallelFor(rows, (1 << 16) / rowWork + 1, [&](size_t begin, size_t end) {
+    poolRows<P, Indices>(out, idx, inData, s, begin, end);
+  });
+}
+
+template <PoolType P>
+Tensor pool(const Tensor &input, const array_t &poolShape,
+            const PoolOptions &options, size_t trailing = 0) {
+  array_t outShape;
+  PoolShape s = makePoolShape(input, poolShape, options, trailing, outShape);
+  Tensor result(outShape);
+  runPool<P, false>(input, s, result, nullptr);
+  return result;
+}
+
+std::tuple<Tensor, Tensor> poolWithIndices(const Tensor &input,
+                                           const array_t &poolShape,
+                                           const PoolOptions &options,
+                                           size_t trailing = 0) {
+  array_t outShape;
+  PoolShape s = makePoolShape(input, poolShape, options, trailing, outShape);
+  std::tuple<Tensor, Tensor> result{Tensor(outShape), Tensor(outShape)};
+  runPool<PoolType::MAX, true>(input, s, std::get<0>(result),
+                               &std::get<1>(result));
+  return result;
+}
+
+// Returns the number of dimensions following the spatial dimensions of images
+size_t imageTrailingDims(const Tensor &input, const array_t &poolShape,
+                         Layout layout) {
+  if ((input.ndims() != 3 && input.ndims() != 4) || poolShape.size() != 2) {
+    std::stringstream ss;
+    ss << "Expected input of rank 3 or 4 and pool shape of size 2, got "
+       << input.shape() << " and " << poolShape;
+    throw std::invalid_argument(ss.str());
+  }
+  return layout == Layout::NHWC ? 1 : 0;
+}
+
+} // namespace
+
+Tensor maxPool(const Tensor &input, const array_t &poolShape) {
+  if (input.ndims() > poolShape.size() + 1) {
+    std::stringstream ss;
+    ss << "Input rank must be at most one greater than pool rank, got "
+       << input.ndims() << " and " << poolShape.size();
+    throw std::invalid_argument(ss.str());
+  }
+  try {
+    static_cast<void>(
+        input.shape().sliceFrom(input.ndims() - poolShape.size()) / poolShape);
+  } catch (const std::invalid_argument &e) {
+    std::stringstream ss;
+    ss << "Pool shape " << poolShape << " does not divide input shape "
+       << input.shape();
+    throw std::invalid_argument(ss.str());
+  }
+  return pool<PoolType::MAX>(input, poolShape, PoolOptions{});
+}
+
+Tensor maxPool(const Tensor &input, const array_t &poolShape,
+               const PoolOptions &options) {
+  return pool<PoolType::MAX>(input, poolShape, options);
+}
+
+Tensor maxPool(const Tensor &input, const array_t &poolShape, Layout layout,
+               const PoolOptions &options) {
+  return pool<PoolType::MAX>(input, poolShape, options,
+                             imageTrailingDims(input, poolShape, layout));
+}
+
+std::tuple<Tensor, Tensor> maxPoolWithIndices(const Tensor &input,
+                                              const array_t &poolShape,
+                                              const PoolOptions &options) {
+  return poolWithIndices(input, poolShape, options);
+}
+
+std::tuple<Tensor, Tensor> maxPoolWithIndices(const Tensor &input,
+                                              const array_t &poolShape,
+                                              Layout layout,
+                                              const PoolOptions &options) {
+  return poolWithIndices(input, poolShape, options,
+                         imageTrailingDims(input, poolShape, layout));
+}
+
+Tensor maxPoolBackward(const Tensor &grad, const Tensor &indices,
+                       const array_t &inputShape) {
+  if (grad.shape() != indices.shape()) {
+    std::stringstream ss;
+    ss << "Expected indices of shape " << grad.shape() << ", got "
+       << indices.shape();
+    throw std::invalid_argument(ss.str());
+  }
+  Tensor result = Tensor::fill(array_t{prod(inputShape)}, 0);
+  double *out = makeSpan<1>(result).data();
+  const Tensor g = flatten(grad);
+  const Tensor idx = flatten(indices);
+  const double *gData = makeSpan<1>(g).data();
+  const double *idxData = makeSpan<1>(idx).data();
+  // windows may overlap, so contributions are scattered serially
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  for (size_t i = 0; i < g.size(); ++i) {
+    auto j = static_cast<ptrdiff_t>(idxData[i]);
+    if (j < 0 || static_cast<size_t>(j) >= result.size()) {
+      std::stringstream ss;
+      ss << "Index " << idxData[i] << " out of range for input shape "
+         << inputShape;
+      throw std::invalid_argument(ss.str());
+    }
+    out[j] += gData[i];
+  }
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result.reshape(inputShape);
+}
+
+Tensor avgPool(const Tensor &input, const array_t &poolShape,
+               const PoolOptions &options) {
+  return pool<PoolType::AVG>(input, poolShape, options);
+}
+
+Tensor avgPool(const Tensor &input, const array_t &poolShape, Layout layout,
+               const PoolOptions &options) {
+  return pool<PoolType::AVG>(input, poolShape, options,
+                             imageTrailingDims(input, poolShape, layout));
+}
+
+Tensor globalMaxPool(const Tensor &input, size_t n) {
+  return pool<PoolType::MAX>(input, input.shape().sliceFrom(input.ndims() - n),
+                             PoolOptions{})
+      .reshape(input.shape().sliceTo(input.ndims() - n));
+}
+
+Tensor globalAvgPool(const Tensor &input, size_t n) {
+  return pool<PoolType::AVG>(input, input.shape().sliceFrom(input.ndims() - n),
+                             PoolOptions{})
+      .reshape(input.shape().sliceTo(input.ndims() - n));
+}
+
+} // namespace gs
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/internal/vecmath.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+
+namespace {
+
+// number of elements (or lanes) processed per block
+constexpr size_t blockSize = 256;
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+double blockMax(const double *x, size_t n) {
+  double result = x[0];
+  size_t i = 1;
+#ifdef __SSE2__
+  if (n >= 2) {
+    __m128d acc = _mm_loadu_pd(x);
+    for (i = 2; i + 2 <= n; i += 2) {
+      acc = _mm_max_pd(acc, _mm_loadu_pd(x + i));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    result = std::max(lanes[0], lanes[1]);
+  }
+#endif
+  for (; i < n; ++i) {
+    result = std::max(result, x[i]);
+  }
+  return result;
+}
+
+double blockSum(const double *x, size_t n) {
+  double result = 0;
+  size_t i = 0;
+#ifdef __SSE2__
+  __m128d acc = _mm_setzero_pd();
+  for (; i + 2 <= n; i += 2) {
+    acc = _mm_add_pd(acc, _mm_loadu_pd(x + i));
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, acc);
+  result = lanes[0] + lanes[1];
+#endif
+  for (; i < n; ++i) {
+    result += x[i];
+  }
+  return result;
+}
+
+// Normalizes a contiguous row of length n. A single pass computes the
+// maximum m and the sum s of exp(x - m), rescaling s whenever a block raises
+// the maximum. A second pass writes exp(x - m) / s or x - m - log(s).
+void softmaxRow(const double *in, double *out, size_t n, bool log) {
+  double buffer[blockSize];
+  double m = blockMax(in, std::min(n, blockSize));
+  double s = 0;
+  for (size_t j = 0; j < n; j += blockSize) {
+    size_t len = std::min(blockSize, n - j);
+    double mb = blockMax(in + j, len);
+    if (mb > m) {
+      s *= std::exp(m - mb);
+      m = mb;
+    }
+    for (size_t i = 0; i < len; ++i) {
+      buffer[i] = in[j + i] - m;
+    }
+    vecExp(buffer, buffer, len);
+    s += blockSum(buffer, len);
+  }
+
+  if (log) {
+    double shift = m + std::log(s);
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = in[i] - shift;
+    }
+    return;
+  }
+  double scale = 1 / s;
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = in[i] - m;
+  }
+  vecExp(out, out, n);
+  for (size_t i = 0; i < n; ++i) {
+    out[i] *= scale;
+  }
+}
+
+// Normalizes the lanes [begin, end) of an (n, inner) slab along its first
+// axis. Lanes are contiguous, so each step of the online update is
+// elementwise across them.
+void softmaxLanes(const double *in, double *out, size_t n, size_t inner,
+                  size_t begin, size_t end, bool log) {
+  const size_t w = end - begin;
+  double m[blockSize];
+  double s[blockSize];
+  double a[blockSize];
+  double b[blockSize];
+
+  std::copy(in + begin, in + end, m);
+  std::fill(s, s + w, 1.0);
+  for (size_t j = 1; j < n; ++j) {
+    const double *x = in + j * inner + begin;
+    for (size_t i = 0; i < w; ++i) {
+      double mi = std::max(m[i], x[i]);
+      a[i] = m[i] == mi ? 0 : m[i] - mi;
+      b[i] = x[i] - mi;
+      m[i] = mi;
+    }
+    vecExp(a, a, w);
+    vecExp(b, b, w);
+    for (size_t i = 0; i < w; ++i) {
+      s[i] = s[i] * a[i] + b[i];
+    }
+  }
+
+  if (log) {
+    vecLog(s, s, w);
+    for (size_t i = 0; i < w; ++i) {
+      m[i] += s[i];
+    }
+  } else {
+    for (size_t i = 0; i < w; ++i) {
+      s[i] = 1 / s[i];
+    }
+  }
+  for (size_t j = 0; j < n; ++j) {
+    const double *x = in + j * inner + begin;
+    double *y = out + j * inner + begin;
+    for (size_t i = 0; i < w; ++i) {
+      y[i] = x[i] - m[i];
+    }
+    if (!log) {
+      vecExp(y, y, w);
+      for (size_t i = 0; i < w; ++i) {
+        y[i] *= s[i];
+      }
+    }
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+Tensor softmaxCommon(const Tensor &tensor, size_t axis, bool log) {
+  if (axis >= tensor.ndims()) {
+    std::stringstream ss;
+    ss << "Softmax axis " << axis << " out of range for tensor of rank "
+       << tensor.ndims();
+    throw std::invalid_argument(ss.str());
+  }
+  const array_t &shape = tensor.shape();
+  if (tensor.size() == 0) {
+    return Tensor(shape);
+  }
+  const size_t n = shape[axis];
+  const size_t inner = prod(shape.sliceFrom(axis + 1));
+  const size_t outer = prod(shape.sliceTo(axis));
+
+  const Tensor in = flatten(tensor);
+  const double *inData = makeSpan<1>(in).data();
+  Tensor result(array_t{tensor.size()});
+  double *out = makeSpan<1>(result).data();
+
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  if (inner == 1) {
+    parallelFor(outer, (1 << 14) / n + 1, [&](size_t begin, size_t end) {
+      for (size_t r = begin; r < end; ++r) {
+        softmaxRow(inData + r * n, out + r * n, n, log);
+      }
+    });
+  } else {
+    size_t blocks = (inner + blockSize - 1) / blockSize;
+    size_t work = n * std::min(inner, blockSize);
+    parallelFor(outer * blocks, (1 << 14) / work + 1,
+                [&](size_t begin, size_t end) {
+                  for (size_t t = begin; t < end; ++t) {
+                    size_t slab = (t / blocks) * n * inner;
+                    size_t lo = (t % blocks) * blockSize;
+                    size_t hi = std::min(inner, lo + blockSize);
+                    softmaxLanes(inData + slab, out + slab, n, inner, lo, hi,
+                                 log);
+                  }
+                });
+  }
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result.reshape(shape);
+}
+
+} // namespace
+
+Tensor softmax(const Tensor &tensor, size_t axis) {
+  return softmaxCommon(tensor, axis, false);
+}
+
+Tensor logSoftmax(const Tensor &tensor, size_t axis) {
+  return softmaxCommon(tensor, axis, true);
+}
+
+} // namespace gs
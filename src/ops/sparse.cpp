@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/sparse.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+
+namespace {
+
+// minimum number of multiply-adds performed by each thread
+constexpr size_t parallelGrain = 1 << 14;
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+inline double rowDot(const double *a, const double *x, size_t n) {
+  size_t i = 0;
+  double sum = 0;
+#ifdef __SSE2__
+  __m128d acc = _mm_setzero_pd();
+  for (; i + 2 <= n; i += 2) {
+    acc = _mm_add_pd(acc,
+                     _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(x + i)));
+  }
+  sum = _mm_cvtsd_f64(_mm_add_sd(acc, _mm_unpackhi_pd(acc, acc)));
+#endif
+  for (; i < n; ++i) {
+    sum += a[i] * x[i];
+  }
+  return sum;
+}
+
+// y += alpha * x
+inline void axpy(double *y, double alpha, const double *x, size_t n) {
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128d a = _mm_set1_pd(alpha);
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i),
+                                    _mm_mul_pd(a, _mm_loadu_pd(x + i))));
+  }
+#endif
+  for (; i < n; ++i) {
+    y[i] += alpha * x[i];
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+} // namespace
+
+SparseMatrix::SparseMatrix(size_t rows, size_t cols, size_t blockRows,
+                           size_t blockCols)
+    : rows_(rows), cols_(cols), blockRows_(blockRows), blockCols_(blockCols),
+      rowStarts_{0} {}
+
+SparseMatrix SparseMatrix::fromDense(const Tensor &dense, double threshold) {
+  return fromDense(dense, 1, 1, threshold);
+}
+
+SparseMatrix SparseMatrix::fromDense(const Tensor &dense, size_t blockRows,
+                                     size_t blockCols, double threshold) {
+  if (dense.ndims() != 2 || blockRows == 0 || blockCols == 0) {
+    std::stringstream ss;
+    ss << "Cannot convert tensor of shape " << dense.shape()
+       << " to sparse matrix with blocks of shape " << blockRows << " x "
+       << blockCols;
+    throw std::invalid_argument(ss.str());
+  }
+  const size_t rows = dense.shape()[0];
+  const size_t cols = dense.shape()[1];
+  SparseMatrix result(rows, cols, blockRows, blockCols);
+  const Tensor flat = flatten(dense);
+  const double *data = makeSpan<1>(flat).data();
+  const auto kept = [threshold](double value) {
+    return std::abs(value) > threshold;
+  };
+
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  for (size_t r0 = 0; r0 < rows; r0 += blockRows) {
+    const size_t height = std::min(blockRows, rows - r0);
+    for (size_t c0 = 0; c0 < cols; c0 += blockCols) {
+      const size_t width = std::min(blockCols, cols - c0);
+      bool nonzero = false;
+      for (size_t r = 0; !nonzero && r < height; ++r) {
+        const double *row = data + (r0 + r) * cols + c0;
+        nonzero = std::any_of(row, row + width, kept);
+      }
+      if (!nonzero) {
+        continue;
+      }
+      result.blockColumns_.push_back(c0 / blockCols);
+      const size_t base = result.values_.size();
+      result.values_.resize(base + blockRows * blockCols, 0);
+      for (size_t r = 0; r < height; ++r) {
+        const double *row = data + (r0 + r) * cols + c0;
+        double *dst = &result.values_[base + r * blockCols];
+        for (size_t c = 0; c < width; ++c) {
+          dst[c] = kept(row[c]) ? row[c] : 0;
+        }
+      }
+    }
+    result.rowStarts_.push_back(result.blockColumns_.size());
+  }
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result;
+}
+
+Tensor SparseMatrix::toDense() const {
+  Tensor result = Tensor::fill({rows_ * cols_}, 0);
+  double *out = makeSpan<1>(result).data();
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  for (size_t i = 0; i + 1 < rowStarts_.size(); ++i) {
+    const size_t r0 = i * blockRows_;
+    const size_t height = std::min(blockRows_, rows_ - r0);
+    for (size_t b = rowStarts_[i]; b < rowStarts_[i + 1]; ++b) {
+      const size_t c0 = blockColumns_[b] * blockCols_;
+      const size_t width = std::min(blockCols_, cols_ - c0);
+      const double *block = &values_[b * blockRows_ * blockCols_];
+      for (size_t r = 0; r < height; ++r) {
+        std::copy_n(block + r * blockCols_, width,
+                    out + (r0 + r) * cols_ + c0);
+      }
+    }
+  }
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result.reshape({rows_, cols_});
+}
+
+size_t SparseMatrix::bytes() const {
+  return values_.size() * sizeof(double) +
+         (rowStarts_.size() + blockColumns_.size()) * sizeof(size_t);
+}
+
+Tensor dot(const SparseMatrix &left, const Tensor &right) {
+  if (right.ndims() == 0 || right.shape()[0] != left.cols_) {
+    std::stringstream ss;
+    ss << "Cannot multiply sparse matrix of shape {" << left.rows_ << ", "
+       << left.cols_ << "} with tensor of shape " << right.shape();
+    throw std::invalid_argument(ss.str());
+  }
+  const size_t rows = left.rows_;
+  const size_t cols = left.cols_;
+  const size_t blockRows = left.blockRows_;
+  const size_t blockCols = left.blockCols_;
+  const size_t blockSize = blockRows * blockCols;
+  const size_t n = prod(right.shape().sliceFrom(1));
+  const Tensor in = flatten(right);
+  const double *x = makeSpan<1>(in).data();
+  Tensor result(array_t{rows * n});
+  double *y = makeSpan<1>(result).data();
+  const size_t *rowStarts = left.rowStarts_.data();
+  const size_t *blockColumns = left.blockColumns_.data();
+  const double *values = left.values_.data();
+
+  // each task owns whole block rows of the result, which it zeroes and then
+  // accumulates the products of the stored blocks into
+  const size_t blockRowCount = left.rowStarts_.size() - 1;
+  const size_t work =
+      left.storedElements() * n / std::max<size_t>(blockRowCount, 1);
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  parallelFor(
+      blockRowCount, parallelGrain / (work + 1) + 1,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const size_t r0 = i * blockRows;
+          const size_t height = std::min(blockRows, rows - r0);
+          double *dst = y + r0 * n;
+          std::fill_n(dst, height * n, 0.0);
+          for (size_t b = rowStarts[i]; b < rowStarts[i + 1]; ++b) {
+            const size_t c0 = blockColumns[b] * blockCols;
+            const size_t width = std::min(blockCols, cols - c0);
+            const double *block = values + b * blockSize;
+            if (n == 1) {
+              // matrix-vector: dot products of the block rows with x
+              for (size_t r = 0; r < height; ++r) {
+                dst[r] += rowDot(block + r * blockCols, x + c0, width);
+              }
+              continue;
+            }
+            // matrix-matrix: rows of the result updated by rows of x
+            for (size_t r = 0; r < height; ++r) {
+              for (size_t c = 0; c < width; ++c) {
+                const double value = block[r * blockCols + c];
+                if (value != 0) {
+                  axpy(dst + r * n, value, x + (c0 + c) * n, n);
+                }
+              }
+            }
+          }
+        }
+      });
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result.reshape(array_t{rows} | right.shape().sliceFrom(1));
+}
+
+} // namespace gs
@@ -1,4 +1,5 @@
 #include <sstream>
+#include <vector>
 
 #include "gradstudent/internal/utils.h"
 #include "gradstudent/ops.h"
@@ -120,6 +121,83 @@ const Tensor slice(const Tensor &tensor, const array_t &mIdx) {
                 true);
 }
 
+// SPLIT
+
+std::vector<Tensor> splitCommon(const Tensor &tensor,
+                                const std::vector<size_t> &sizes, size_t axis,
+                                bool ro) {
+  if (axis >= tensor.ndims()) {
+    std::stringstream ss;
+    ss << "Split axis " << axis << " out of range for tensor of rank "
+       << tensor.ndims();
+    throw std::invalid_argument(ss.str());
+  }
+  size_t total = 0;
+  for (size_t size : sizes) {
+    total += size;
+  }
+  if (total != tensor.shape()[axis]) {
+    std::stringstream ss;
+    ss << "Cannot split axis of size " << tensor.shape()[axis]
+       << " into parts of total size " << total;
+    throw std::invalid_argument(ss.str());
+  }
+
+  // views are constructed in place, since copying a tensor copies its data
+  std::vector<Tensor> result;
+  result.reserve(sizes.size());
+  array_t shape = tensor.shape();
+  size_t offset = tensor.offset();
+  for (size_t size : sizes) {
+    shape[axis] = size;
+    result.emplace_back(shape, tensor.strides(), tensor, offset, ro);
+    offset += size * tensor.strides()[axis];
+  }
+  return result;
+}
+
+std::vector<Tensor> split(Tensor &tensor, const std::vector<size_t> &sizes,
+                          size_t axis) {
+  return splitCommon(tensor, sizes, axis, tensor.ro());
+}
+
+std::vector<Tensor> split(const Tensor &tensor,
+                          const std::vector<size_t> &sizes, size_t axis) {
+  return splitCommon(tensor, sizes, axis, true);
+}
+
+// UNSTACK
+
+std::vector<Tensor> unstackCommon(const Tensor &tensor, size_t axis,
+                                  bool ro) {
+  if (axis >= tensor.ndims()) {
+    std::stringstream ss;
+    ss << "Unstack axis " << axis << " out of range for tensor of rank "
+       << tensor.ndims();
+    throw std::invalid_argument(ss.str());
+  }
+  const array_t &shape = tensor.shape();
+  const array_t &strides = tensor.strides();
+  array_t result_shape = shape.sliceTo(axis) | shape.sliceFrom(axis + 1);
+  array_t result_strides = strides.sliceTo(axis) | strides.sliceFrom(axis + 1);
+
+  std::vector<Tensor> result;
+  result.reserve(shape[axis]);
+  for (size_t i = 0; i < shape[axis]; ++i) {
+    result.emplace_back(result_shape, result_strides, tensor,
+                        tensor.offset() + i * strides[axis], ro);
+  }
+  return result;
+}
+
+std::vector<Tensor> unstack(Tensor &tensor, size_t axis) {
+  return unstackCommon(tensor, axis, tensor.ro());
+}
+
+std::vector<Tensor> unstack(const Tensor &tensor, size_t axis) {
+  return unstackCommon(tensor, axis, true);
+}
+
 // BROADCAST
 
 void broadcastStrides(array_t &out, const std::vector<int> &mask,
@@ -197,13 +275,39 @@ const Tensor Tensor::reshape(const array_t &shape,
   return Tensor(shape, strides, *this, offset_, true);
 }
 
+Tensor Tensor::reshape(const array_t &shape, bool &copied) {
+  reshapeCommon(shape, defaultStrides(shape));
+  array_t strides;
+  copied = !reshapeStrides(strides, shape_, strides_, shape);
+  if (!copied) {
+    return reshape(shape, strides);
+  }
+  Tensor compact(*this);
+  return compact.reshape(shape, defaultStrides(shape));
+}
+
+// NOLINTNEXTLINE(readability-const-return-type)
+const Tensor Tensor::reshape(const array_t &shape, bool &copied) const {
+  reshapeCommon(shape, defaultStrides(shape));
+  array_t strides;
+  copied = !reshapeStrides(strides, shape_, strides_, shape);
+  if (!copied) {
+    return reshape(shape, strides);
+  }
+  // the copy is not shared, so it need not be read-only
+  Tensor compact(*this);
+  return compact.reshape(shape, defaultStrides(shape));
+}
+
 Tensor Tensor::reshape(const array_t &shape) {
-  return reshape(shape, defaultStrides(shape));
+  bool copied = false;
+  return reshape(shape, copied);
 }
 
 // NOLINTNEXTLINE(readability-const-return-type)
 const Tensor Tensor::reshape(const array_t &shape) const {
-  return reshape(shape, defaultStrides(shape));
+  bool copied = false;
+  return reshape(shape, copied);
 }
 
 } // namespace gs
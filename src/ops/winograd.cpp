@@ -0,0 +1,313 @@
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "gradstudent/internal/conv.h"
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+
+namespace {
+
+/* TRANSFORM MATRICES */
+
+// Transform matrices for F(m x m, 3 x 3), where tiles of m x m outputs are
+// computed from a x a input tiles with a = m + 2 (Lavin & Gray, 2015).
+
+struct F2x2 {
+  static constexpr size_t m = 2;
+  static constexpr size_t a = 4;
+  static constexpr double BT[a][a] = {
+      {1, 0, -1, 0}, {0, 1, 1, 0}, {0, -1, 1, 0}, {0, 1, 0, -1}};
+  static constexpr double G[a][3] = {
+      {1, 0, 0}, {0.5, 0.5, 0.5}, {0.5, -0.5, 0.5}, {0, 0, 1}};
+  static constexpr double AT[m][a] = {{1, 1, 1, 0}, {0, 1, -1, -1}};
+};
+
+struct F4x4 {
+  static constexpr size_t m = 4;
+  static constexpr size_t a = 6;
+  static constexpr double BT[a][a] = {
+      {4, 0, -5, 0, 1, 0},  {0, -4, -4, 1, 1, 0}, {0, 4, -4, -1, 1, 0},
+      {0, -2, -1, 2, 1, 0}, {0, 2, -1, -2, 1, 0}, {0, 4, 0, -5, 0, 1}};
+  static constexpr double G[a][3] = {
+      {1. / 4, 0, 0},           {-1. / 6, -1. / 6, -1. / 6},
+      {-1. / 6, 1. / 6, -1. / 6}, {1. / 24, 1. / 12, 1. / 6},
+      {1. / 24, -1. / 12, 1. / 6}, {0, 0, 1}};
+  static constexpr double AT[m][a] = {{1, 1, 1, 1, 1, 0},
+                                      {0, 1, -1, 2, -2, 0},
+                                      {0, 1, 1, 4, 4, 0},
+                                      {0, 1, -1, 8, -8, 1}};
+};
+
+// minimum output size (in both dimensions) for which F(4x4, 3x3) is used
+constexpr size_t largeTileThreshold = 8;
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+
+/* FILTER TRANSFORM */
+
+// Transforms filters g of shape (f, 3, 3, c) into u of shape (a, a, f, c),
+// i.e. u[xi][nu][f] = G g[f] G^T.
+template <typename W>
+std::vector<double> transformFilters(const double *g, size_t f, size_t c) {
+  constexpr size_t a = W::a;
+  std::vector<double> u(a * a * f * c);
+  for (size_t l = 0; l < f; ++l) {
+    for (size_t ch = 0; ch < c; ++ch) {
+      double tmp[a][3] = {};
+      for (size_t i = 0; i < a; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+          for (size_t k = 0; k < 3; ++k) {
+            tmp[i][j] += W::G[i][k] * g[((l * 3 + k) * 3 + j) * c + ch];
+          }
+        }
+      }
+      for (size_t i = 0; i < a; ++i) {
+        for (size_t j = 0; j < a; ++j) {
+          double val = 0;
+          for (size_t k = 0; k < 3; ++k) {
+            val += tmp[i][k] * W::G[j][k];
+          }
+          u[((i * a + j) * f + l) * c + ch] = val;
+        }
+      }
+    }
+  }
+  return u;
+}
+
+/* FILTER CACHE */
+
+// Caches transformed filters by kernel contents, so that repeated calls with
+// the same kernel (e.g. once per image) skip the filter transform.
+class FilterCache {
+public:
+  using value_type = std::shared_ptr<const std::vector<double>>;
+
+  template <typename W>
+  value_type get(const double *g, size_t f, size_t c) {
+    size_t size = f * 9 * c;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->tile == W::m && it->filters == f &&
+            it->kernel.size() == size &&
+            std::equal(it->kernel.begin(), it->kernel.end(), g)) {
+          entries_.splice(entries_.begin(), entries_, it);
+          return entries_.front().transformed;
+        }
+      }
+    }
+
+    auto transformed =
+        std::make_shared<const std::vector<double>>(transformFilters<W>(g, f, c));
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_front({W::m, f, std::vector<double>(g, g + size), transformed});
+    if (entries_.size() > capacity) {
+      entries_.pop_back();
+    }
+    return transformed;
+  }
+
+private:
+  static constexpr size_t capacity = 16;
+
+  struct Entry {
+    size_t tile;
+    size_t filters;
+    std::vector<double> kernel;
+    value_type transformed;
+  };
+
+  std::mutex mutex_;
+  std::list<Entry> entries_;
+};
+
+FilterCache &filterCache() {
+  static FilterCache cache;
+  return cache;
+}
+
+/* TILE KERNEL */
+
+struct WinogradShape {
+  size_t height;    // input height
+  size_t width;     // input width
+  size_t channels;  // contracted size
+  size_t filters;   // number of filters
+  size_t outHeight; // output height
+  size_t outWidth;  // output width
+  size_t tilesWide; // number of tiles per row
+};
+
+// Computes the output tiles in rows [begin, end) of the tile grid. The input is
+// contiguous with shape (h, w, c), u has shape (a, a, f, c) and the output has
+// shape (f, h - 2, w - 2).
+template <typename W>
+void winogradRows(double *out, const double *in, const double *u,
+                  const WinogradShape &s, size_t begin, size_t end) {
+  constexpr size_t a = W::a;
+  constexpr size_t m = W::m;
+  const size_t c = s.channels;
+  const size_t f = s.filters;
+  std::vector<double> d(a * a * c);
+  std::vector<double> tmp(a * a * c);
+  std::vector<double> mm(a * a * f);
+
+  for (size_t ty = begin; ty < end; ++ty) {
+    for (size_t tx = 0; tx < s.tilesWide; ++tx) {
+      // gather the input tile, padding with zeros past the edges
+      for (size_t i = 0; i < a; ++i) {
+        size_t y = ty * m + i;
+        for (size_t j = 0; j < a; ++j) {
+          size_t x = tx * m + j;
+          double *dst = d.data() + (i * a + j) * c;
+          if (y < s.height && x < s.width) {
+            std::copy(in + (y * s.width + x) * c,
+                      in + (y * s.width + x + 1) * c, dst);
+          } else {
+            std::fill(dst, dst + c, 0.0);
+          }
+        }
+      }
+
+      // input transform: V = B^T d B (stored back in d)
+      std::fill(tmp.begin(), tmp.end(), 0.0);
+      for (size_t i = 0; i < a; ++i) {
+        for (size_t k = 0; k < a; ++k) {
+          double b = W::BT[i][k];
+          if (b == 0) {
+            continue;
+          }
+          for (size_t j = 0; j < a; ++j) {
+            double *t = tmp.data() + (i * a + j) * c;
+            const double *src = d.data() + (k * a + j) * c;
+            for (size_t ch = 0; ch < c; ++ch) {
+              t[ch] += b * src[ch];
+            }
+          }
+        }
+      }
+      std::fill(d.begin(), d.end(), 0.0);
+      for (size_t j = 0; j < a; ++j) {
+        for (size_t k = 0; k < a; ++k) {
+          double b = W::BT[j][k];
+          if (b == 0) {
+            continue;
+          }
+          for (size_t i = 0; i < a; ++i) {
+            double *v = d.data() + (i * a + j) * c;
+            const double *src = tmp.data() + (i * a + k) * c;
+            for (size_t ch = 0; ch < c; ++ch) {
+              v[ch] += b * src[ch];
+            }
+          }
+        }
+      }
+
+      // elementwise product, summed over channels: M = sum_c U * V
+      for (size_t xi = 0; xi < a * a; ++xi) {
+        const double *v = d.data() + xi * c;
+        for (size_t l = 0; l < f; ++l) {
+          const double *ul = u + (xi * f + l) * c;
+          double acc = 0;
+          for (size_t ch = 0; ch < c; ++ch) {
+            acc += ul[ch] * v[ch];
+          }
+          mm[xi * f + l] = acc;
+        }
+      }
+
+      // output transform: Y = A^T M A
+      for (size_t l = 0; l < f; ++l) {
+        double t[m][a] = {};
+        for (size_t i = 0; i < m; ++i) {
+          for (size_t k = 0; k < a; ++k) {
+            for (size_t j = 0; j < a; ++j) {
+              t[i][j] += W::AT[i][k] * mm[(k * a + j) * f + l];
+            }
+          }
+        }
+        for (size_t i = 0; i < m && ty * m + i < s.outHeight; ++i) {
+          double *row = out + (l * s.outHeight + ty * m + i) * s.outWidth;
+          for (size_t j = 0; j < m && tx * m + j < s.outWidth; ++j) {
+            double val = 0;
+            for (size_t k = 0; k < a; ++k) {
+              val += t[i][k] * W::AT[j][k];
+            }
+            row[tx * m + j] = val;
+          }
+        }
+      }
+    }
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+template <typename W>
+void winogradKernel(double *out, const double *in, const double *g,
+                    WinogradShape s) {
+  auto u = filterCache().get<W>(g, s.filters, s.channels);
+  size_t tilesHigh = (s.outHeight + W::m - 1) / W::m;
+  s.tilesWide = (s.outWidth + W::m - 1) / W::m;
+  size_t rowWork = s.tilesWide * W::a * W::a * s.channels * (s.filters + 2);
+  parallelFor(tilesHigh, (1 << 16) / rowWork + 1,
+              [&](size_t begin, size_t end) {
+                winogradRows<W>(out, in, u->data(), s, begin, end);
+              });
+}
+
+} // namespace
+
+bool winogradApplicable(const Tensor &input, const Tensor &kernel, size_t n) {
+  if (n != 2 || input.ndims() < 2) {
+    return false;
+  }
+  size_t k = kernel.ndims() - input.ndims(); // number of filter dimensions
+  const array_t &kShape = kernel.shape();
+  return kShape[k] == 3 && kShape[k + 1] == 3 && input.shape()[0] >= 3 &&
+         input.shape()[1] >= 3 &&
+         kShape.sliceFrom(k + 2) == input.shape().sliceFrom(2);
+}
+
+Tensor winogradConv(const Tensor &input, const Tensor &kernel) {
+  bool multi = kernel.ndims() > input.ndims();
+  const array_t &inShape = input.shape();
+
+  WinogradShape s{};
+  s.height = inShape[0];
+  s.width = inShape[1];
+  s.channels = prod(inShape.sliceFrom(2));
+  s.filters = multi ? kernel.shape()[0] : 1;
+  s.outHeight = s.height - 2;
+  s.outWidth = s.width - 2;
+
+  const Tensor in = flatten(input);
+  const Tensor g = flatten(kernel);
+  Tensor result(array_t{s.filters, s.outHeight, s.outWidth});
+
+  double *out = makeSpan<3>(result).data();
+  const double *inData = makeSpan<1>(in).data();
+  const double *gData = makeSpan<1>(g).data();
+  if (std::min(s.outHeight, s.outWidth) >= largeTileThreshold) {
+    winogradKernel<F4x4>(out, inData, gData, s);
+  } else {
+    winogradKernel<F2x2>(out, inData, gData, s);
+  }
+
+  if (!multi) {
+    return result.reshape({s.outHeight, s.outWidth});
+  }
+  return result;
+}
+
+} // namespace gs
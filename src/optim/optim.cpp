@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/optim.h"
+#include "gradstudent/span.h"
+
+namespace gs {
+namespace optim {
+
+namespace {
+
+// number of elements per work item of a multi-tensor launch
+constexpr size_t chunkSize = size_t{1} << 14;
+
+const double *constData(const Tensor &tensor) {
+  const Tensor flat = flatten(tensor);
+  return makeSpan<1>(flat).data();
+}
+
+// Calls fn(i, begin, end) on ranges of elements of each tensor i, splitting
+// the elements of all tensors evenly across threads
+template <typename F>
+void launch(const std::vector<Tensor *> &tensors, const F &fn) {
+  struct Chunk {
+    size_t tensor;
+    size_t begin;
+    size_t end;
+  };
+  std::vector<Chunk> chunks;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    size_t n = tensors[i]->size();
+    for (size_t begin = 0; begin < n; begin += chunkSize) {
+      chunks.push_back({i, begin, std::min(n, begin + chunkSize)});
+    }
+  }
+  parallelFor(chunks.size(), 4, [&](size_t begin, size_t end) {
+    for (size_t c = begin; c < end; ++c) {
+      fn(chunks[c].tensor, chunks[c].begin, chunks[c].end);
+    }
+  });
+}
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+// Updates p[0, n) (and the velocity b, unless null) in a single pass
+void sgdKernel(double *p, const double *g, double *b, size_t n,
+               const SGDOptions &o) {
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128d lr = _mm_set1_pd(o.lr);
+  const __m128d mu = _mm_set1_pd(o.momentum);
+  const __m128d wd = _mm_set1_pd(o.weightDecay);
+  for (; i + 2 <= n; i += 2) {
+    __m128d pi = _mm_loadu_pd(p + i);
+    __m128d gi = _mm_add_pd(_mm_loadu_pd(g + i), _mm_mul_pd(wd, pi));
+    __m128d d = gi;
+    if (b != nullptr) {
+      __m128d bi = _mm_add_pd(_mm_mul_pd(mu, _mm_loadu_pd(b + i)), gi);
+      _mm_storeu_pd(b + i, bi);
+      d = o.nesterov ? _mm_add_pd(gi, _mm_mul_pd(mu, bi)) : bi;
+    }
+    _mm_storeu_pd(p + i, _mm_sub_pd(pi, _mm_mul_pd(lr, d)));
+  }
+#endif
+  for (; i < n; ++i) {
+    double gi = g[i] + o.weightDecay * p[i];
+    double d = gi;
+    if (b != nullptr) {
+      double bi = o.momentum * b[i] + gi;
+      b[i] = bi;
+      d = o.nesterov ? gi + o.momentum * bi : bi;
+    }
+    p[i] -= o.lr * d;
+  }
+}
+
+// Constants of an Adam step
+struct AdamStep {
+  double beta1;
+  double beta2;
+  double eps;
+  double decay;     // 1 - lr weightDecay
+  double stepSize;  // lr / c1
+  double invSqrtC2; // 1 / sqrt(c2)
+};
+
+// Updates p[0, n) and the moments m and v in a single pass
+void adamKernel(double *p, const double *g, double *m, double *v, size_t n,
+                const AdamStep &s) {
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128d b1 = _mm_set1_pd(s.beta1);
+  const __m128d c1 = _mm_set1_pd(1 - s.beta1);
+  const __m128d b2 = _mm_set1_pd(s.beta2);
+  const __m128d c2 = _mm_set1_pd(1 - s.beta2);
+  const __m128d eps = _mm_set1_pd(s.eps);
+  const __m128d decay = _mm_set1_pd(s.decay);
+  const __m128d stepSize = _mm_set1_pd(s.stepSize);
+  const __m128d scale = _mm_set1_pd(s.invSqrtC2);
+  for (; i + 2 <= n; i += 2) {
+    __m128d gi = _mm_loadu_pd(g + i);
+    __m128d mi =
+        _mm_add_pd(_mm_mul_pd(b1, _mm_loadu_pd(m + i)), _mm_mul_pd(c1, gi));
+    __m128d vi = _mm_add_pd(_mm_mul_pd(b2, _mm_loadu_pd(v + i)),
+                            _mm_mul_pd(c2, _mm_mul_pd(gi, gi)));
+    _mm_storeu_pd(m + i, mi);
+    _mm_storeu_pd(v + i, vi);
+    __m128d denom = _mm_add_pd(_mm_mul_pd(_mm_sqrt_pd(vi), scale), eps);
+    __m128d pi = _mm_mul_pd(decay, _mm_loadu_pd(p + i));
+    _mm_storeu_pd(p + i,
+                  _mm_sub_pd(pi, _mm_mul_pd(stepSize, _mm_div_pd(mi, denom))));
+  }
+#endif
+  for (; i < n; ++i) {
+    double gi = g[i];
+    double mi = s.beta1 * m[i] + (1 - s.beta1) * gi;
+    double vi = s.beta2 * v[i] + (1 - s.beta2) * (gi * gi);
+    m[i] = mi;
+    v[i] = vi;
+    double denom = std::sqrt(vi) * s.invSqrtC2 + s.eps;
+    p[i] = s.decay * p[i] - s.stepSize * (mi / denom);
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+} // namespace
+
+/* OPTIMIZER */
+
+Optimizer::Optimizer(std::vector<Tensor *> params, std::vector<Tensor *> grads)
+    : params_(std::move(params)), grads_(std::move(grads)) {
+  if (params_.size() != grads_.size()) {
+    std::stringstream ss;
+    ss << "Expected one gradient per parameter, got " << params_.size()
+       << " parameters and " << grads_.size() << " gradients";
+    throw std::invalid_argument(ss.str());
+  }
+  for (size_t i = 0; i < params_.size(); ++i) {
+    const Tensor &param = *params_[i];
+    const Tensor &grad = *grads_[i];
+    if (param.shape() != grad.shape()) {
+      std::stringstream ss;
+      ss << "Parameter " << i << " has shape " << param.shape()
+         << " but its gradient has shape " << grad.shape();
+      throw std::invalid_argument(ss.str());
+    }
+    if (!isContiguous(param) || !isContiguous(grad) || param.ro() ||
+        grad.ro()) {
+      std::stringstream ss;
+      ss << "Parameter " << i
+         << " and its gradient must be contiguous and writable";
+      throw std::invalid_argument(ss.str());
+    }
+  }
+}
+
+void Optimizer::zeroGrad() {
+  std::vector<double *> g(grads_.size());
+  for (size_t i = 0; i < grads_.size(); ++i) {
+    g[i] = mutableData(*grads_[i]);
+  }
+  launch(grads_, [&](size_t i, size_t begin, size_t end) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    std::fill(g[i] + begin, g[i] + end, 0.0);
+  });
+}
+
+/* SGD */
+
+SGD::SGD(std::vector<Tensor *> params, std::vector<Tensor *> grads,
+         const SGDOptions &options)
+    : Optimizer(std::move(params), std::move(grads)), options_(options) {
+  if (options_.momentum != 0) {
+    velocity_.reserve(params_.size());
+    for (const Tensor *param : params_) {
+      velocity_.push_back(Tensor::fill(param->shape(), 0));
+    }
+  }
+}
+
+void SGD::step() {
+  std::vector<double *> p(params_.size());
+  std::vector<const double *> g(params_.size());
+  std::vector<double *> b(params_.size(), nullptr);
+  for (size_t i = 0; i < params_.size(); ++i) {
+    p[i] = mutableData(*params_[i]);
+    g[i] = constData(*grads_[i]);
+    if (!velocity_.empty()) {
+      b[i] = mutableData(velocity_[i]);
+    }
+  }
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  launch(params_, [&](size_t i, size_t begin, size_t end) {
+    sgdKernel(p[i] + begin, g[i] + begin,
+              b[i] == nullptr ? nullptr : b[i] + begin, end - begin, options_);
+  });
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  ++steps_;
+}
+
+/* ADAM */
+
+Adam::Adam(std::vector<Tensor *> params, std::vector<Tensor *> grads,
+           const AdamOptions &options)
+    : Optimizer(std::move(params), std::move(grads)), options_(options) {
+  m_.reserve(params_.size());
+  v_.reserve(params_.size());
+  for (const Tensor *param : params_) {
+    m_.push_back(Tensor::fill(param->shape(), 0));
+    v_.push_back(Tensor::fill(param->shape(), 0));
+  }
+}
+
+void Adam::step() {
+  ++steps_;
+  const auto t = static_cast<double>(steps_);
+  const AdamOptions &o = options_;
+  const AdamStep s{o.beta1,
+                   o.beta2,
+                   o.eps,
+                   1 - o.lr * o.weightDecay,
+                   o.lr / (1 - std::pow(o.beta1, t)),
+                   1 / std::sqrt(1 - std::pow(o.beta2, t))};
+
+  std::vector<double *> p(params_.size());
+  std::vector<const double *> g(params_.size());
+  std::vector<double *> m(params_.size());
+  std::vector<double *> v(params_.size());
+  for (size_t i = 0; i < params_.size(); ++i) {
+    p[i] = mutableData(*params_[i]);
+    g[i] = constData(*grads_[i]);
+    m[i] = mutableData(m_[i]);
+    v[i] = mutableData(v_[i]);
+  }
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  launch(params_, [&](size_t i, size_t begin, size_t end) {
+    adamKernel(p[i] + begin, g[i] + begin, m[i] + begin, v[i] + begin,
+               end - begin, s);
+  });
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+} // namespace optim
+} // namespace gs
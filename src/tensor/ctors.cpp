@@ -1,15 +1,18 @@
+#include <utility>
+
 #include "gradstudent/iter.h"
 #include "gradstudent/tensor.h"
 
+#include "gradstudent/internal/copy.h"
 #include "gradstudent/internal/utils.h"
 
 namespace gs {
 
 // tensor copy constructor
 Tensor::Tensor(const Tensor &other) : Tensor(other.shape_) {
-  for (auto vals : TensorIter(*this, other)) {
-    std::get<0>(vals) = std::get<1>(vals);
-  }
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  stridedCopy(data_.get(), strides_, other.data_.get() + other.offset_,
+              other.strides_, shape_);
 }
 
 // tensor view constructor
@@ -24,6 +27,11 @@ Tensor::Tensor(const array_t &shape, const array_t &strides)
     : offset_(0), size_(prod(shape)), shape_(shape), strides_(strides),
       data_(std::shared_ptr<double[]>(new double[size_])) {}
 
+// external buffer constructor
+Tensor::Tensor(const array_t &shape, std::shared_ptr<double[]> data)
+    : offset_(0), size_(prod(shape)), shape_(shape),
+      strides_(defaultStrides(shape)), data_(std::move(data)) {}
+
 // empty tensor constructor (default strides)
 Tensor::Tensor(const array_t &shape) : Tensor(shape, defaultStrides(shape)) {}
 
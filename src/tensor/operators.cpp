@@ -1,26 +1,28 @@
 #include <sstream>
 
+#include "gradstudent/internal/copy.h"
+#include "gradstudent/internal/utils.h"
 #include "gradstudent/iter.h"
 #include "gradstudent/tensor.h"
 
 namespace gs {
 
 void Tensor::assignSelf(const Tensor &other) {
+  // the buffers may overlap, so copy through a temporary
   auto temp(std::make_unique<double[]>(size_));
-  size_t i = 0;
-  for (const auto &[val] : TensorIter(other)) {
-    temp[i++] = val;
-  }
-  i = 0;
-  for (const auto &[val] : TensorIter(*this)) {
-    val = temp[i++];
-  }
+  array_t tempStrides = defaultStrides(shape_);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  stridedCopy(temp.get(), tempStrides, other.data_.get() + other.offset_,
+              other.strides_, shape_);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  stridedCopy(data_.get() + offset_, strides_, temp.get(), tempStrides,
+              shape_);
 }
 
 void Tensor::assignOther(const Tensor &other) {
-  for (const auto &[res, val] : TensorIter(*this, other)) {
-    res = val;
-  }
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  stridedCopy(data_.get() + offset_, strides_,
+              other.data_.get() + other.offset_, other.strides_, shape_);
 }
 
 // NOLINTNEXTLINE(bugprone-unhandled-self-assignment)
@@ -1,5 +1,5 @@
+#include "gradstudent/internal/copy.h"
 #include "gradstudent/internal/utils.h"
-#include "gradstudent/iter.h"
 #include "gradstudent/tensor.h"
 
 namespace gs {
@@ -8,17 +8,15 @@ void Tensor::ensureWritable() {
   // implements copy-on-write
   // should be called prior to any write operation
   if (ro_) {
+    array_t strides = defaultStrides(shape_);
     // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
     double *temp = new double[size_];
-    size_t i = 0;
-    for (const auto &[val] : TensorIter(*this)) {
-      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-      temp[i++] = val;
-    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    stridedCopy(temp, strides, data_.get() + offset_, strides_, shape_);
     data_.reset(temp);
     ro_ = false;
     offset_ = 0;
-    strides_ = defaultStrides(shape_);
+    strides_ = strides;
   }
 }
 
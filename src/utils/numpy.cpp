@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "gradstudent/internal/numpy.h"
 #include "gradstudent/tensor.h"
 #include "gradstudent/utils.h"
 
@@ -11,12 +12,6 @@ namespace gs {
 
 const std::string numpy_header_magic = "\x93NUMPY";
 
-struct numpy_header {
-  std::string descr;
-  bool fortran_order{};
-  array_t shape;
-};
-
 bool parse_substring(std::pair<std::string, size_t> &result,
                      const std::string &str) {
   size_t value_start = str.find('\'');
@@ -0,0 +1,126 @@
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/autograd.h"
+#include "gradstudent/iter.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+using namespace gs::ad;
+
+namespace {
+
+constexpr size_t numLayers = 6;
+
+// layer i computes tanh(x w_i) + x, where w_i is the i-th parameter
+std::vector<Function> makeLayers() {
+  std::vector<Function> layers;
+  for (size_t i = 0; i < numLayers; ++i) {
+    layers.emplace_back([i](const std::vector<Var> &args) {
+      return tanh(dot(args[0], args[1 + i])) + args[0];
+    });
+  }
+  return layers;
+}
+
+struct Result {
+  std::vector<Tensor> grads; // gradients of the input and parameters
+  RecomputeStats stats;
+  size_t tapeSize;
+};
+
+Result train(size_t segments) {
+  Tensor x = pseudoRandom({3, 4}, 0.1);
+  std::vector<Tensor> weights;
+  Result result{{Tensor::fill(x.shape(), 0)}, {}, 0};
+  for (size_t i = 0; i < numLayers; ++i) {
+    weights.push_back(pseudoRandom({4, 4}, 0.2 * static_cast<double>(i)));
+    result.grads.push_back(Tensor::fill({4, 4}, 0));
+  }
+
+  Tape tape;
+  Var input = tape.variable(x, result.grads[0]);
+  std::vector<Var> params;
+  for (size_t i = 0; i < numLayers; ++i) {
+    params.push_back(tape.variable(weights[i], result.grads[i + 1]));
+  }
+  Var output = checkpointSequential(makeLayers(), input, params, segments);
+  result.tapeSize = tape.size();
+  tape.backward(sum(output * output));
+  result.stats = tape.recomputeStats();
+  return result;
+}
+
+} // namespace
+
+TEST(CheckpointTest, Sequential) {
+  Result full = train(0);
+  EXPECT_EQ(full.stats.segments, 0);
+  EXPECT_EQ(full.stats.nodes, 0);
+
+  const std::vector<size_t> counts{1, 2, 3, numLayers, 10};
+  for (size_t segments : counts) {
+    Result result = train(segments);
+    ASSERT_EQ(result.grads.size(), full.grads.size());
+    for (size_t i = 0; i < full.grads.size(); ++i) {
+      for (const auto &[idx, val] : ITensorIter(result.grads[i])) {
+        EXPECT_DOUBLE_EQ(val, full.grads[i][idx])
+            << "segments: " << segments << ", i: " << i << ", idx: " << idx;
+      }
+    }
+
+    // each segment is recomputed once, so the nodes of every layer are
+    // recorded again
+    size_t recorded = std::min(segments, numLayers);
+    EXPECT_EQ(result.stats.segments, recorded);
+    EXPECT_EQ(result.stats.nodes, full.tapeSize - 1 - numLayers);
+    EXPECT_GE(result.stats.seconds, 0);
+    EXPECT_EQ(result.tapeSize, 1 + numLayers + recorded);
+  }
+}
+
+TEST(CheckpointTest, Nested) {
+  Tensor x = pseudoRandom({5}, 0.3);
+  auto inner = [](const std::vector<Var> &args) { return exp(args[0]); };
+  auto outer = [&](const std::vector<Var> &args) {
+    return checkpoint(inner, {args[0] * args[1]}) * args[0];
+  };
+
+  Tape tape;
+  Var v = tape.variable(x);
+  Var w = tape.constant(Tensor::fill({5}, 2));
+  tape.backward(sum(checkpoint(outer, {v, w})));
+  // the inner segment is recomputed while differentiating the outer one
+  EXPECT_EQ(tape.recomputeStats().segments, 2);
+
+  // d/dx x exp(2 x) = (1 + 2 x) exp(2 x)
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_NEAR(v.grad()[i], (1 + 2 * x[i]) * std::exp(2 * x[i]), 1e-12);
+  }
+
+  tape.reset();
+  EXPECT_EQ(tape.recomputeStats().segments, 0);
+}
+
+TEST(CheckpointTest, Constants) {
+  Tape tape;
+  Var c = tape.constant(Tensor::fill({3}, 1));
+  Var result = checkpoint(
+      [](const std::vector<Var> &args) { return args[0] * 2.0; }, {c});
+  EXPECT_FALSE(result.requiresGrad());
+  EXPECT_EQ(result.value(), Tensor::fill({3}, 2));
+}
+
+TEST(CheckpointTest, Invalid) {
+  Tape tape;
+  Tape other;
+  auto f = [](const std::vector<Var> &args) { return args[0]; };
+  EXPECT_THROW(checkpoint(f, {}), std::invalid_argument);
+  EXPECT_THROW(checkpoint(f, {tape.variable(Tensor::fill({2}, 1)),
+                              other.variable(Tensor::fill({2}, 1))}),
+               std::invalid_argument);
+}
@@ -0,0 +1,309 @@
+#include <functional>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/autograd.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+using namespace gs::ad;
+
+namespace {
+
+// checks the gradient of sum(f(x) * w) against central differences, where w
+// is a fixed pseudo-random weighting
+void checkGrad(const std::function<Var(const Var &)> &f, Tensor x,
+               double tol = 1e-6) {
+  Tape tape;
+  Tensor weight = pseudoRandom(f(tape.constant(x)).value().shape(), 3.3);
+  Tensor grad = Tensor::fill(x.shape(), 0);
+  tape.backward(sum(f(tape.variable(x, grad)) * tape.constant(weight)));
+
+  const double h = 1e-6;
+  for (size_t i = 0; i < x.size(); ++i) {
+    double v = x[i];
+    x[i] = v + h;
+    double up = gs::sum(f(tape.constant(x)).value() * weight);
+    x[i] = v - h;
+    double down = gs::sum(f(tape.constant(x)).value() * weight);
+    x[i] = v;
+    EXPECT_NEAR(grad[i], (up - down) / (2 * h), tol) << "i: " << i;
+  }
+}
+
+} // namespace
+
+TEST(ArenaTest, Allocate) {
+  Arena arena(64);
+  auto *a = static_cast<char *>(arena.allocate(10, 1));
+  auto *b = static_cast<double *>(arena.allocate(sizeof(double), 8));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 8, 0);
+  EXPECT_GE(reinterpret_cast<char *>(b), a + 10);
+  EXPECT_EQ(arena.used(), 10 + sizeof(double));
+
+  // oversized requests get their own block
+  arena.allocate(1000, 8);
+  EXPECT_GE(arena.capacity(), 1064);
+
+  size_t capacity = arena.capacity();
+  arena.reset();
+  EXPECT_EQ(arena.used(), 0);
+  EXPECT_EQ(arena.allocate(10, 1), a);
+  EXPECT_EQ(arena.capacity(), capacity);
+}
+
+TEST(TapeTest, Elementwise) {
+  Tensor x = pseudoRandom({3, 4}, 0.1);
+  checkGrad([](const Var &v) { return v * v + 2.0 * v; }, x);
+  checkGrad([](const Var &v) { return -v - 1.0; }, x);
+  checkGrad([](const Var &v) { return 1.0 / (v + 2.0); }, x);
+  checkGrad([](const Var &v) { return (3.0 - v) / 2.0; }, x);
+  checkGrad([](const Var &v) { return affine(v, 3, 1); }, x);
+  checkGrad([](const Var &v) { return exp(v); }, x);
+  checkGrad([](const Var &v) { return log(v + 2.0); }, x);
+  checkGrad([](const Var &v) { return tanh(v); }, x);
+  checkGrad([](const Var &v) { return sigmoid(v); }, x);
+  checkGrad([](const Var &v) { return relu(v); }, x);
+  checkGrad([](const Var &v) { return gelu(3.0 * v); }, x);
+}
+
+TEST(TapeTest, Broadcast) {
+  Tensor x = pseudoRandom({3, 4}, 0.2);
+  Tensor row = pseudoRandom({4}, 0.3) + 2;
+  Tensor column = pseudoRandom({3, 1}, 0.4) + 2;
+  checkGrad([&](const Var &v) { return v + v.tape().constant(row); }, x);
+  checkGrad([&](const Var &v) { return v.tape().constant(x) * v; }, row);
+  checkGrad([&](const Var &v) { return v.tape().constant(x) / v; }, column);
+  checkGrad([&](const Var &v) { return v.tape().constant(row) - v; }, column);
+}
+
+TEST(TapeTest, Structural) {
+  Tensor x = pseudoRandom({2, 3, 4}, 0.5);
+  Tensor w = pseudoRandom({4, 5}, 0.6);
+  checkGrad([&](const Var &v) { return dot(v, v.tape().constant(w)); }, x);
+  checkGrad([&](const Var &v) { return dot(v.tape().constant(x), v); }, w);
+  checkGrad([](const Var &v) { return reshape(v, {6, 4}); }, x);
+  checkGrad([](const Var &v) { return flatten(v) * 2.0; }, x);
+  checkGrad([](const Var &v) { return sum(v * v); }, x);
+  checkGrad([](const Var &v) { return softmax(v, 1); }, x);
+  checkGrad([](const Var &v) { return logSoftmax(v, 2); }, x);
+}
+
+TEST(TapeTest, EmptyDot) {
+  // contracting an empty axis gives zeros, which don't depend on the inputs
+  Tape tape;
+  Var x = tape.variable(Tensor::fill({3, 0}, 0));
+  Var y = tape.variable(Tensor::fill({0, 4}, 0));
+  Var z = dot(x, y);
+  EXPECT_EQ(z.value(), Tensor::fill({3, 4}, 0));
+  tape.backward(sum(z));
+  EXPECT_EQ(x.grad().shape(), array_t({3, 0}));
+  EXPECT_EQ(y.grad().shape(), array_t({0, 4}));
+}
+
+TEST(TapeTest, Indexing) {
+  Tensor x = pseudoRandom({4, 3}, 0.7);
+  Tensor rows = Tensor::fill({5}, 1);
+  rows[0] = 3;
+  rows[3] = 0;
+  Tensor columns = Tensor::fill({4}, 2);
+  columns[1] = 0;
+  Tensor picks = Tensor::fill({4, 2}, 2);
+  picks[1] = 0;
+  picks[6] = 1;
+  checkGrad([&](const Var &v) { return indexSelect(v, 0, rows); }, x);
+  checkGrad([&](const Var &v) { return indexSelect(v, 1, columns); }, x);
+  checkGrad([&](const Var &v) { return gather(v, 1, picks); }, x);
+}
+
+TEST(TapeTest, Conv) {
+  Tensor nhwc = pseudoRandom({2, 7, 6, 3}, 0.1);
+  Tensor nhwcKernel = pseudoRandom({4, 3, 2, 3}, 0.2);
+  Tensor nchw = pseudoRandom({3, 7, 6}, 0.3);
+  Tensor nchwKernel = pseudoRandom({2, 3, 3, 2}, 0.4);
+  for (const ConvOptions &options :
+       {ConvOptions{}, ConvOptions{{2, 1}, {1, 2}, {1, 2}}}) {
+    checkGrad(
+        [&](const Var &v) {
+          return conv(v, v.tape().constant(nhwcKernel), Layout::NHWC, options);
+        },
+        nhwc);
+    checkGrad(
+        [&](const Var &v) {
+          return conv(v.tape().constant(nhwc), v, Layout::NHWC, options);
+        },
+        nhwcKernel);
+    checkGrad(
+        [&](const Var &v) {
+          return conv(v, v.tape().constant(nchwKernel), Layout::NCHW, options);
+        },
+        nchw);
+    checkGrad(
+        [&](const Var &v) {
+          return conv(v.tape().constant(nchw), v, Layout::NCHW, options);
+        },
+        nchwKernel);
+  }
+}
+
+TEST(TapeTest, Pool) {
+  Tensor x = pseudoRandom({2, 7, 6}, 0.5);
+  PoolOptions options{{2, 2}, {1, 1}};
+  checkGrad([](const Var &v) { return maxPool(v, {2, 3}, PoolOptions{}); }, x);
+  checkGrad([&](const Var &v) { return maxPool(v, {3, 3}, options); }, x);
+  checkGrad(
+      [&](const Var &v) { return maxPool(v, {3, 2}, Layout::NHWC, options); },
+      x);
+  checkGrad(
+      [&](const Var &v) { return maxPool(v, {3, 3}, Layout::NCHW, options); },
+      x);
+}
+
+TEST(TapeTest, AddBias) {
+  Tensor x = pseudoRandom({2, 3, 4, 5}, 0.6);
+  Tensor nhwcBias = pseudoRandom({5}, 0.7);
+  Tensor nchwBias = pseudoRandom({3}, 0.8);
+  checkGrad(
+      [&](const Var &v) {
+        return addBias(v, v.tape().constant(nhwcBias), Layout::NHWC);
+      },
+      x);
+  checkGrad(
+      [&](const Var &v) {
+        return addBias(v.tape().constant(x), v, Layout::NHWC);
+      },
+      nhwcBias);
+  checkGrad(
+      [&](const Var &v) {
+        return addBias(v.tape().constant(x), v, Layout::NCHW);
+      },
+      nchwBias);
+}
+
+TEST(TapeTest, ConvNet) {
+  // a LeNet-style block: conv, bias, relu, pooling and a dense layer
+  Tensor images = pseudoRandom({2, 8, 8, 1}, 0.9);
+  Tensor kernel = pseudoRandom({3, 3, 3, 1}, 1.0);
+  Tensor bias = pseudoRandom({3}, 1.1);
+  Tensor weight = pseudoRandom({27, 4}, 1.2);
+  auto net = [&](const Var &x, const Var &k) {
+    Tape &tape = x.tape();
+    Var h = relu(addBias(conv(x, k, Layout::NHWC), tape.constant(bias),
+                         Layout::NHWC));
+    Var p = maxPool(h, {2, 2}, Layout::NHWC);
+    return dot(reshape(p, {2, 27}), tape.constant(weight));
+  };
+  checkGrad([&](const Var &v) { return net(v.tape().constant(images), v); },
+            kernel);
+  checkGrad([&](const Var &v) { return net(v, v.tape().constant(kernel)); },
+            images);
+}
+
+TEST(TapeTest, Accumulate) {
+  // x is used twice, so its gradient has two contributions
+  Tensor x = pseudoRandom({5}, 0.7);
+  Tape tape;
+  Var v = tape.variable(x);
+  tape.backward(sum(exp(v) + v * v));
+  Tensor expected = exp(x) + 2 * x;
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_NEAR(v.grad()[i], expected[i], 1e-15);
+  }
+
+  // gradient buffers accumulate across backward passes
+  Tensor grad = Tensor::fill({5}, 0);
+  for (size_t step = 0; step < 2; ++step) {
+    tape.reset();
+    Var w = tape.variable(x, grad);
+    tape.backward(sum(exp(w) + w * w));
+  }
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_NEAR(grad[i], 2 * expected[i], 1e-14);
+  }
+}
+
+TEST(TapeTest, Release) {
+  Tensor x = pseudoRandom({4}, 0.8);
+  Tape tape;
+  Var v = tape.variable(x);
+  Var h = tanh(v);
+  Var loss = sum(h * h);
+  EXPECT_DOUBLE_EQ(double(loss.value()), gs::sum(tanh(x) * tanh(x)));
+  tape.backward(loss);
+  EXPECT_TRUE(h.released());
+  EXPECT_TRUE(loss.released());
+  EXPECT_FALSE(v.released());
+  EXPECT_THROW(h.value(), std::invalid_argument);
+  EXPECT_EQ(v.grad().shape(), x.shape());
+}
+
+TEST(TapeTest, Reuse) {
+  Tensor x = pseudoRandom({8}, 0.9);
+  Tape tape;
+  size_t capacity = 0;
+  for (size_t step = 0; step < 3; ++step) {
+    tape.reset();
+    Var v = tape.variable(x);
+    tape.backward(sum(sigmoid(v) * v));
+    EXPECT_EQ(tape.size(), 4);
+    if (step > 0) {
+      EXPECT_EQ(tape.arena().capacity(), capacity);
+    }
+    capacity = tape.arena().capacity();
+  }
+}
+
+TEST(TapeTest, GradHook) {
+  Tensor x = pseudoRandom({4}, 0.3);
+  Tensor y = pseudoRandom({4}, 0.4);
+  std::vector<Tensor> grads(3, Tensor::fill({4}, 0));
+  std::vector<size_t> order;
+  std::vector<Tensor> reported;
+  Tape tape;
+  tape.setGradHook([&](Tensor &grad) {
+    order.push_back(static_cast<size_t>(&grad - grads.data()));
+    reported.push_back(grad);
+  });
+
+  // w1 is first used by tanh, w2 by the product and w3 not at all
+  Var w1 = tape.variable(x, grads[0]);
+  Var w2 = tape.variable(y, grads[1]);
+  tape.variable(x, grads[2]);
+  Var h = tanh(w1) * w2;
+  tape.backward(sum(h * w1));
+  EXPECT_EQ(order, std::vector<size_t>({1, 0, 2}));
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(reported[i], grads[order[i]]);
+  }
+  EXPECT_FALSE(grads[0] == Tensor::fill({4}, 0));
+
+  // the hook is kept by reset
+  tape.reset();
+  order.clear();
+  tape.backward(sum(tape.variable(x, grads[0])));
+  EXPECT_EQ(order, std::vector<size_t>({0}));
+}
+
+TEST(TapeTest, Invalid) {
+  Tape tape;
+  Tape other;
+  Var v = tape.variable(Tensor::fill({3}, 1));
+  EXPECT_THROW(tape.backward(v * 2.0), std::invalid_argument);
+  EXPECT_THROW(tape.backward(sum(tape.constant(Tensor(1.0)))),
+               std::invalid_argument);
+  EXPECT_THROW(v + other.constant(Tensor::fill({3}, 1)), std::invalid_argument);
+  EXPECT_THROW(other.backward(sum(v)), std::invalid_argument);
+  Tensor grad = Tensor::fill({2}, 0);
+  EXPECT_THROW(tape.variable(Tensor::fill({3}, 1), grad),
+               std::invalid_argument);
+  const Tensor buffer = Tensor::fill({2, 3}, 0);
+  Tensor readOnly = slice(buffer, {0});
+  EXPECT_THROW(tape.variable(Tensor::fill({3}, 1), readOnly),
+               std::invalid_argument);
+  Tensor strided = permute(Tensor::fill({3, 2}, 0), {1, 0});
+  EXPECT_THROW(tape.variable(Tensor::fill({2, 3}, 1), strided),
+               std::invalid_argument);
+}
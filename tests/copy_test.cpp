@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "gradstudent/internal/copy.h"
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/internal/utils.h"
+#include "gradstudent/iter.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+
+using namespace gs;
+
+namespace {
+
+// copies through the strided copy engine and compares against TensorIter
+void checkCopy(const Tensor &src) {
+  Tensor dst(src);
+  ASSERT_EQ(dst.shape(), src.shape());
+  EXPECT_EQ(dst.strides(), defaultStrides(src.shape()));
+  for (const auto &[x, y] : TensorIter(dst, src)) {
+    EXPECT_EQ(x, y);
+  }
+}
+
+} // namespace
+
+TEST(StridedCopyTest, Contiguous) {
+  checkCopy(Tensor::range(24).reshape({2, 3, 4}));
+}
+
+TEST(StridedCopyTest, Transpose) {
+  for (size_t rows = 1; rows < 70; rows += 17) {
+    for (size_t cols = 1; cols < 70; cols += 13) {
+      const Tensor matrix =
+          Tensor::range(static_cast<int>(rows * cols)).reshape({rows, cols});
+      checkCopy(permute(matrix, {1, 0}));
+    }
+  }
+}
+
+TEST(StridedCopyTest, Permute3D) {
+  const Tensor tensor = Tensor::range(6 * 24 * 24).reshape({6, 24, 24});
+  checkCopy(permute(tensor, {1, 2, 0}));
+  checkCopy(permute(tensor, {2, 0, 1}));
+  checkCopy(permute(tensor, {0, 2, 1}));
+}
+
+TEST(StridedCopyTest, Broadcast) {
+  const Tensor row = Tensor::range(5);
+  checkCopy(broadcast(row, {4, 5}));
+  checkCopy(broadcast(row.reshape({5, 1}), {5, 3}));
+}
+
+TEST(StridedCopyTest, Truncated) {
+  const Tensor matrix = Tensor::range(100).reshape({10, 10});
+  checkCopy(truncate(matrix, {2, 3}, {7, 9}));
+}
+
+TEST(StridedCopyTest, Parallel) {
+  setNumThreads(4);
+  const Tensor matrix = Tensor::range(512 * 300).reshape({512, 300});
+  checkCopy(matrix);
+  checkCopy(permute(matrix, {1, 0}));
+  setNumThreads(0);
+}
+
+TEST(StridedCopyTest, ToStrided) {
+  Tensor src = Tensor::range(12).reshape({3, 4});
+  Tensor dst = Tensor::fill({4, 3}, 0);
+  permute(dst, {1, 0}) = src;
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      EXPECT_EQ((dst[{j, i}]), (src[{i, j}]));
+    }
+  }
+}
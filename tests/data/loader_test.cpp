@@ -0,0 +1,104 @@
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/data.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+
+using namespace gs;
+using namespace gs::data;
+
+namespace {
+
+// fills example j of a batch with its epoch and position
+void fillPositions(Batch &batch) {
+  Tensor images = batch[0];
+  Tensor labels = batch[1];
+  for (size_t j = 0; j < batch.size(); ++j) {
+    double value = 100.0 * static_cast<double>(batch.epoch()) +
+                   static_cast<double>(batch.begin() + j);
+    slice(images, {j}) = Tensor::fill({2, 2}, value);
+    labels[j] = -value;
+  }
+}
+
+} // namespace
+
+TEST(LoaderTest, Order) {
+  DataLoader loader(10, {{2, 2}, {}}, fillPositions, {3, 3, 2});
+  EXPECT_EQ(loader.batches(), 4);
+  std::set<const Batch *> slots;
+  for (size_t epoch = 0; epoch < 3; ++epoch) {
+    for (size_t b = 0; b < loader.batches(); ++b) {
+      const Batch &batch = loader.next();
+      slots.insert(&batch);
+      EXPECT_EQ(batch.epoch(), epoch);
+      EXPECT_EQ(batch.index(), b);
+      EXPECT_EQ(batch.begin(), 3 * b);
+      EXPECT_EQ(batch.size(), b == 3 ? 1 : 3);
+      EXPECT_EQ(batch[0].shape(), array_t({batch.size(), 2, 2}));
+      for (size_t j = 0; j < batch.size(); ++j) {
+        double value = 100.0 * static_cast<double>(epoch) +
+                       static_cast<double>(3 * b + j);
+        EXPECT_EQ((batch[0][{j, 1, 1}]), value);
+        EXPECT_EQ(batch[1][j], -value);
+      }
+    }
+  }
+  // batches are recycled
+  EXPECT_EQ(slots.size(), 3);
+}
+
+TEST(LoaderTest, Prefetch) {
+  std::atomic<size_t> calls{0};
+  DataLoader loader(
+      100, {{1}},
+      [&](Batch &batch) {
+        ++calls;
+        batch[0] = Tensor::fill(batch[0].shape(), 1);
+      },
+      {10, 2, 3});
+
+  // producers fill prefetch + 1 batches and then wait for the consumer
+  auto waitFor = [&](size_t n) {
+    for (size_t i = 0; i < 1000 && calls < n; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  };
+  waitFor(4);
+  EXPECT_EQ(calls, 4);
+  loader.next();
+  waitFor(4);
+  EXPECT_EQ(calls, 4);
+  loader.next();
+  waitFor(5);
+  EXPECT_EQ(calls, 5);
+}
+
+TEST(LoaderTest, Error) {
+  DataLoader loader(
+      6, {{}},
+      [](Batch &batch) {
+        if (batch.index() == 1) {
+          throw std::runtime_error("cannot read batch");
+        }
+      },
+      {2, 1, 1});
+  EXPECT_EQ(loader.next().index(), 0);
+  EXPECT_THROW(loader.next(), std::runtime_error);
+  EXPECT_EQ(loader.next().index(), 2);
+}
+
+TEST(LoaderTest, Invalid) {
+  auto fill = [](Batch &) {};
+  EXPECT_THROW(DataLoader(0, {{}}, fill), std::invalid_argument);
+  EXPECT_THROW(DataLoader(1, {{}}, fill, {0, 1, 1}), std::invalid_argument);
+  EXPECT_THROW(DataLoader(1, {{}}, fill, {1, 0, 1}), std::invalid_argument);
+  EXPECT_THROW(DataLoader(1, {{}}, fill, {1, 1, 0}), std::invalid_argument);
+}
@@ -0,0 +1,104 @@
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/data.h"
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+using namespace gs::data;
+
+namespace {
+
+// checks that each epoch visits every example once, in the sampler's order
+void checkEpochs(Sampler &sampler, const Tensor &images, const Tensor &labels,
+                 size_t batchSize, size_t epochs) {
+  const size_t examples = labels.size();
+  for (size_t epoch = 0; epoch < epochs; ++epoch) {
+    std::set<size_t> seen;
+    for (size_t b = 0; b < sampler.batches(); ++b) {
+      const Batch &batch = sampler.next();
+      EXPECT_EQ(batch.epoch(), epoch);
+      EXPECT_EQ(batch.index(), b);
+      EXPECT_EQ(batch.begin(), b * batchSize);
+      EXPECT_EQ(batch.size(), std::min(batchSize, examples - b * batchSize));
+      EXPECT_EQ(batch.fields(), 2);
+      const Tensor batchImages = batch[0];
+      const Tensor batchLabels = batch[1];
+      EXPECT_EQ(batchImages.shape()[0], batch.size());
+      for (size_t j = 0; j < batch.size(); ++j) {
+        size_t example = sampler.order()[batch.begin() + j];
+        seen.insert(example);
+        EXPECT_EQ(slice(batchImages, {j}), slice(images, {example}));
+        EXPECT_EQ(batchLabels[j], labels[example]);
+      }
+    }
+    EXPECT_EQ(seen.size(), examples);
+  }
+}
+
+} // namespace
+
+TEST(SamplerTest, Sequential) {
+  Tensor images = pseudoRandom({10, 3, 2}, 0.1);
+  Tensor labels = pseudoRandom({10}, 0.2);
+  Sampler sampler({&images, &labels}, {4, false, 0});
+  EXPECT_EQ(sampler.batches(), 3);
+  checkEpochs(sampler, images, labels, 4, 2);
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(sampler.order()[i], i);
+  }
+}
+
+TEST(SamplerTest, Shuffle) {
+  // the images are a strided view, which the sampler copies
+  Tensor base = pseudoRandom({3, 2, 25}, 0.3);
+  Tensor images = permute(base, {2, 1, 0});
+  Tensor labels = pseudoRandom({25}, 0.4);
+  Sampler sampler({&images, &labels}, {7, true, 42});
+  EXPECT_EQ(sampler.batches(), 4);
+  checkEpochs(sampler, images, labels, 7, 3);
+
+  // orders depend only on the seed and the epoch
+  Sampler same({&images, &labels}, {7, true, 42});
+  Sampler other({&images, &labels}, {7, true, 43});
+  std::vector<std::vector<size_t>> orders;
+  for (size_t epoch = 0; epoch < 2; ++epoch) {
+    for (size_t b = 0; b < same.batches(); ++b) {
+      same.next();
+      other.next();
+    }
+    EXPECT_FALSE(same.order() == other.order());
+    orders.push_back(same.order());
+  }
+  EXPECT_FALSE(orders[0] == orders[1]);
+  Sampler again({&images, &labels}, {5, true, 42});
+  again.next();
+  EXPECT_EQ(again.order(), orders[0]);
+}
+
+TEST(SamplerTest, Parallel) {
+  Tensor images = pseudoRandom({300, 28, 28}, 0.5);
+  Tensor labels = pseudoRandom({300}, 0.6);
+  setNumThreads(4);
+  Sampler sampler({&images, &labels}, {256, true, 7});
+  checkEpochs(sampler, images, labels, 256, 2);
+  setNumThreads(0);
+}
+
+TEST(SamplerTest, Invalid) {
+  Tensor images({4, 2});
+  Tensor labels({3});
+  Tensor scalar(1.0);
+  Tensor empty({0, 2});
+  EXPECT_THROW(Sampler({}), std::invalid_argument);
+  EXPECT_THROW(Sampler({&images, &labels}), std::invalid_argument);
+  EXPECT_THROW(Sampler({&images, &scalar}), std::invalid_argument);
+  EXPECT_THROW(Sampler({&empty}), std::invalid_argument);
+  EXPECT_THROW(Sampler({&images}, {0, true, 0}), std::invalid_argument);
+}
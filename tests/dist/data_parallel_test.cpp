@@ -0,0 +1,143 @@
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/autograd.h"
+#include "gradstudent/dist.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+using namespace gs::dist;
+
+namespace {
+
+// mean squared error of a LeNet-style block: conv, bias, relu, pooling and a
+// dense layer
+ad::Var convNetLoss(ad::Tape &tape, const std::vector<ad::Var> &params,
+                    const Tensor &inputs, const Tensor &targets) {
+  const size_t n = inputs.shape()[0];
+  ad::Var x = tape.constant(inputs);
+  ad::Var h = relu(addBias(conv(x, params[0], Layout::NHWC), params[1],
+                           Layout::NHWC));
+  ad::Var p = maxPool(h, {2, 2}, Layout::NHWC);
+  ad::Var y = dot(reshape(p, {n, 27}), params[2]) + params[3];
+  ad::Var d = y - tape.constant(targets);
+  return sum(d * d) / static_cast<double>(n);
+}
+
+struct Model {
+  std::vector<Tensor> params{
+      pseudoRandom({3, 3, 3, 1}, 1.0), pseudoRandom({3}, 1.1),
+      pseudoRandom({27, 4}, 1.2), pseudoRandom({4}, 1.3)};
+  std::vector<Tensor> grads;
+
+  Model() {
+    for (const Tensor &param : params) {
+      grads.push_back(Tensor::fill(param.shape(), 0));
+    }
+  }
+
+  std::vector<Tensor *> paramPtrs() {
+    std::vector<Tensor *> result;
+    for (Tensor &param : params) {
+      result.push_back(&param);
+    }
+    return result;
+  }
+
+  std::vector<Tensor *> gradPtrs() {
+    std::vector<Tensor *> result;
+    for (Tensor &grad : grads) {
+      result.push_back(&grad);
+    }
+    return result;
+  }
+
+  // computes the gradient of the whole minibatch on a single tape
+  double reference(const Tensor &inputs, const Tensor &targets) {
+    ad::Tape tape;
+    std::vector<ad::Var> vars;
+    for (size_t i = 0; i < params.size(); ++i) {
+      grads[i] = Tensor::fill(params[i].shape(), 0);
+      vars.push_back(tape.variable(params[i], grads[i]));
+    }
+    ad::Var loss = convNetLoss(tape, vars, inputs, targets);
+    double result = loss.value()[0];
+    tape.backward(loss);
+    return result;
+  }
+};
+
+void checkReplicas(size_t batch, size_t replicas) {
+  const Tensor inputs = pseudoRandom({batch, 8, 8, 1}, 0.9);
+  const Tensor targets = pseudoRandom({batch, 4}, 0.2);
+  Model expected;
+  double expectedLoss = expected.reference(inputs, targets);
+
+  Model model;
+  DataParallel trainer(model.paramPtrs(), model.gradPtrs(), convNetLoss,
+                       replicas);
+  EXPECT_EQ(trainer.replicas(), replicas);
+  // gradients are overwritten by each step
+  for (size_t step = 0; step < 2; ++step) {
+    EXPECT_NEAR(trainer.step(inputs, targets), expectedLoss, 1e-12);
+    for (size_t i = 0; i < model.grads.size(); ++i) {
+      for (size_t j = 0; j < model.grads[i].size(); ++j) {
+        EXPECT_NEAR(model.grads[i][j], expected.grads[i][j], 1e-12)
+            << "replicas: " << replicas << ", i: " << i << ", j: " << j;
+      }
+    }
+  }
+}
+
+} // namespace
+
+TEST(DataParallelTest, Gradients) {
+  checkReplicas(10, 1);
+  checkReplicas(10, 3);
+  checkReplicas(10, 4);
+}
+
+TEST(DataParallelTest, SmallBatch) { checkReplicas(2, 4); }
+
+TEST(DataParallelTest, LossError) {
+  Model model;
+  DataParallel trainer(
+      model.paramPtrs(), model.gradPtrs(),
+      [&](ad::Tape &tape, const std::vector<ad::Var> &params,
+          const Tensor &inputs, const Tensor &targets) {
+        if (inputs.shape()[0] == 3) {
+          throw std::runtime_error("loss failed");
+        }
+        return convNetLoss(tape, params, inputs, targets);
+      },
+      3);
+  const Tensor inputs = pseudoRandom({8, 8, 8, 1}, 0.9);
+  const Tensor targets = pseudoRandom({8, 4}, 0.2);
+  EXPECT_THROW(trainer.step(inputs, targets), std::runtime_error);
+  // the trainer remains usable
+  EXPECT_NO_THROW(trainer.step(truncate(inputs, {0}, {6}),
+                               truncate(targets, {0}, {6})));
+}
+
+TEST(DataParallelTest, Invalid) {
+  Model model;
+  std::vector<Tensor *> params = model.paramPtrs();
+  std::vector<Tensor *> grads = model.gradPtrs();
+  EXPECT_THROW(DataParallel(params, {grads[0]}, convNetLoss),
+               std::invalid_argument);
+  std::swap(grads[0], grads[1]);
+  EXPECT_THROW(DataParallel(params, grads, convNetLoss),
+               std::invalid_argument);
+
+  DataParallel trainer(model.paramPtrs(), model.gradPtrs(), convNetLoss, 2);
+  EXPECT_THROW(trainer.step(Tensor::fill({0, 8, 8, 1}, 0),
+                            Tensor::fill({0, 4}, 0)),
+               std::invalid_argument);
+  EXPECT_THROW(trainer.step(pseudoRandom({4, 8, 8, 1}, 0.1),
+                            pseudoRandom({3, 4}, 0.2)),
+               std::invalid_argument);
+}
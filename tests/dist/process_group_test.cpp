@@ -0,0 +1,143 @@
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "gradstudent/dist.h"
+#include "gradstudent/tensor.h"
+
+using namespace gs;
+using namespace gs::dist;
+
+namespace {
+
+// Runs fn(rank) in size processes, returning whether it succeeded in each
+std::vector<bool> runRanks(size_t size,
+                           const std::function<bool(size_t)> &fn) {
+  std::vector<pid_t> children;
+  for (size_t rank = 1; rank < size; ++rank) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      bool ok = false;
+      try {
+        ok = fn(rank);
+      } catch (...) {
+      }
+      _exit(ok ? 0 : 1);
+    }
+    children.push_back(pid);
+  }
+  std::vector<bool> result{fn(0)};
+  for (pid_t pid : children) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    result.push_back(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+  return result;
+}
+
+std::string uniqueName() {
+  static size_t counter = 0;
+  return "test-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+}
+
+double value(size_t rank, size_t step, size_t i) {
+  return std::sin(static_cast<double>(i) + 0.3 * static_cast<double>(rank) +
+                  0.7 * static_cast<double>(step));
+}
+
+} // namespace
+
+TEST(ProcessGroupTest, AllReduce) {
+  const size_t size = 3;
+  const std::string name = uniqueName();
+  std::vector<bool> ok = runRanks(size, [&](size_t rank) {
+    ProcessGroup group(name, rank, size, 4096);
+    // tensors of odd sizes, so that shards straddle them (copying the
+    // tensors into a vector would move them out of the segment)
+    Tensor small = group.allocate({7});
+    Tensor large = group.allocate({50, 41});
+    std::vector<Tensor *> tensors{&small, &large};
+    bool result = true;
+    for (size_t step = 0; step < 2; ++step) {
+      size_t offset = 0;
+      for (Tensor *tensor : tensors) {
+        for (size_t i = 0; i < tensor->size(); ++i) {
+          (*tensor)[i] = value(rank, step, offset + i);
+        }
+        offset += tensor->size();
+      }
+      group.allReduce(1.0 / size);
+      offset = 0;
+      for (const Tensor *tensor : tensors) {
+        for (size_t i = 0; i < tensor->size(); ++i) {
+          double mean = 0;
+          for (size_t r = 0; r < size; ++r) {
+            mean += value(r, step, offset + i);
+          }
+          mean /= size;
+          result = result && std::abs((*tensor)[i] - mean) < 1e-14;
+        }
+        offset += tensor->size();
+      }
+    }
+    return result;
+  });
+  EXPECT_EQ(ok, std::vector<bool>(size, true));
+}
+
+TEST(ProcessGroupTest, Mismatch) {
+  const std::string name = uniqueName();
+  std::vector<bool> ok = runRanks(2, [&](size_t rank) {
+    ProcessGroup group(name, rank, 2, 64);
+    group.allocate({rank + 1});
+    try {
+      group.allReduce();
+    } catch (const std::invalid_argument &) {
+      return true;
+    }
+    return false;
+  });
+  EXPECT_EQ(ok, std::vector<bool>(2, true));
+}
+
+TEST(ProcessGroupTest, PeerExit) {
+  const std::string name = uniqueName();
+  std::vector<bool> ok = runRanks(3, [&](size_t rank) {
+    ProcessGroup group(name, rank, 3, 64);
+    if (rank == 1) {
+      // leaves without taking part
+      return true;
+    }
+    try {
+      group.barrier();
+    } catch (const std::runtime_error &) {
+      return true;
+    }
+    return false;
+  });
+  EXPECT_EQ(ok, std::vector<bool>(3, true));
+}
+
+TEST(ProcessGroupTest, Single) {
+  ProcessGroup group(uniqueName(), 0, 1, 16);
+  Tensor t = group.allocate({2, 3});
+  EXPECT_EQ(t, Tensor::fill({2, 3}, 0));
+  t[4] = 2;
+  group.allReduce(0.5);
+  EXPECT_EQ(t[4], 1);
+  // allocations start on cache lines
+  EXPECT_THROW(group.allocate({9}), std::invalid_argument);
+  EXPECT_NO_THROW(group.allocate({8}));
+}
+
+TEST(ProcessGroupTest, Invalid) {
+  EXPECT_THROW(ProcessGroup(uniqueName(), 2, 2, 10), std::invalid_argument);
+  EXPECT_THROW(ProcessGroup(std::string(200, 'x'), 0, 1, 10),
+               std::invalid_argument);
+}
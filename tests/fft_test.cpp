@@ -0,0 +1,115 @@
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/internal/fft.h"
+
+using namespace gs;
+
+namespace {
+
+using complex = std::complex<double>;
+
+std::vector<double> sequence(size_t n) {
+  std::vector<double> result(n);
+  for (size_t i = 0; i < n; ++i) {
+    result[i] = std::sin(0.7 * static_cast<double>(i) + 0.1);
+  }
+  return result;
+}
+
+// naive DFT of a real sequence
+std::vector<complex> dft(const std::vector<double> &x) {
+  size_t n = x.size();
+  std::vector<complex> result(n);
+  for (size_t k = 0; k < n; ++k) {
+    for (size_t j = 0; j < n; ++j) {
+      double angle = -2 * M_PI * static_cast<double>(j * k) /
+                     static_cast<double>(n);
+      result[k] += x[j] * complex(std::cos(angle), std::sin(angle));
+    }
+  }
+  return result;
+}
+
+} // namespace
+
+TEST(FFTTest, NextPow2) {
+  EXPECT_EQ(nextPow2(1), 1);
+  EXPECT_EQ(nextPow2(5), 8);
+  EXPECT_EQ(nextPow2(16), 16);
+}
+
+TEST(FFTTest, InvalidSize) { EXPECT_THROW(FFT(12), std::invalid_argument); }
+
+TEST(FFTTest, Complex) {
+  std::vector<double> x = sequence(16);
+  std::vector<complex> expected = dft(x);
+  std::vector<complex> data(x.begin(), x.end());
+  FFT(16).transform(data.data(), false);
+  for (size_t k = 0; k < 16; ++k) {
+    EXPECT_NEAR(data[k].real(), expected[k].real(), 1e-12);
+    EXPECT_NEAR(data[k].imag(), expected[k].imag(), 1e-12);
+  }
+
+  FFT(16).transform(data.data(), true);
+  for (size_t k = 0; k < 16; ++k) {
+    EXPECT_NEAR(data[k].real(), 16 * x[k], 1e-12);
+    EXPECT_NEAR(data[k].imag(), 0, 1e-12);
+  }
+}
+
+TEST(FFTTest, Real) {
+  for (size_t n : {2, 4, 8, 32}) {
+    std::vector<double> x = sequence(n);
+    std::vector<complex> expected = dft(x);
+    std::vector<complex> spectrum(n / 2 + 1);
+    RealFFT fft(n);
+    fft.forward(x.data(), spectrum.data());
+    for (size_t k = 0; k <= n / 2; ++k) {
+      EXPECT_NEAR(spectrum[k].real(), expected[k].real(), 1e-12) << n;
+      EXPECT_NEAR(spectrum[k].imag(), expected[k].imag(), 1e-12) << n;
+    }
+
+    std::vector<double> y(n);
+    fft.inverse(spectrum.data(), y.data());
+    for (size_t k = 0; k < n; ++k) {
+      EXPECT_NEAR(y[k], static_cast<double>(n) * x[k], 1e-12) << n;
+    }
+  }
+}
+
+TEST(FFTTest, Real2D) {
+  size_t rows = 4;
+  size_t cols = 8;
+  std::vector<double> x = sequence(rows * cols);
+  RealFFT2D fft(rows, cols);
+  std::vector<complex> spectrum(rows * fft.spectrumCols());
+  fft.forward(x.data(), spectrum.data());
+
+  for (size_t u = 0; u < rows; ++u) {
+    for (size_t v = 0; v < fft.spectrumCols(); ++v) {
+      complex expected = 0;
+      for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+          double angle = -2 * M_PI *
+                         (static_cast<double>(i * u) / rows +
+                          static_cast<double>(j * v) / cols);
+          expected +=
+              x[i * cols + j] * complex(std::cos(angle), std::sin(angle));
+        }
+      }
+      complex actual = spectrum[u * fft.spectrumCols() + v];
+      EXPECT_NEAR(actual.real(), expected.real(), 1e-12);
+      EXPECT_NEAR(actual.imag(), expected.imag(), 1e-12);
+    }
+  }
+
+  std::vector<double> y(rows * cols);
+  fft.inverse(spectrum.data(), y.data());
+  for (size_t i = 0; i < rows * cols; ++i) {
+    EXPECT_NEAR(y[i], static_cast<double>(rows * cols) * x[i], 1e-12);
+  }
+}
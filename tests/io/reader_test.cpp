@@ -0,0 +1,193 @@
+#include <cstdint>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/io.h"
+#include "gradstudent/iter.h"
+#include "gradstudent/tensor.h"
+#include "gradstudent/utils.h"
+#include "test_utils.h"
+
+using namespace gs;
+using namespace gs::io;
+
+namespace {
+
+std::string tempPath(const std::string &name) {
+  return testing::TempDir() + "gradstudent_io_" + name;
+}
+
+// writes an NPY file (version 1.0) of doubles, padding the header as numpy
+void writeNumpy(const std::string &path, const Tensor &tensor) {
+  std::string shape = "(";
+  for (size_t i = 0; i < tensor.ndims(); ++i) {
+    shape += std::to_string(tensor.shape()[i]) + ",";
+  }
+  shape += ")";
+  std::string header =
+      "{'descr': '<f8', 'fortran_order': False, 'shape': " + shape + ", }";
+  header.resize(((10 + header.size() + 1 + 63) / 64) * 64 - 10, ' ');
+  header.back() = '\n';
+  std::ofstream file(path, std::ios::binary);
+  file << "\x93NUMPY" << '\x01' << '\x00';
+  file.put(static_cast<char>(header.size() & 0xff));
+  file.put(static_cast<char>(header.size() >> 8));
+  file << header;
+  for (const auto &[val] : TensorIter(tensor)) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    file.write(reinterpret_cast<const char *>(&val), sizeof(val));
+  }
+}
+
+void writeFile(const std::string &path, const std::string &contents) {
+  std::ofstream file(path, std::ios::binary);
+  file << contents;
+}
+
+std::string pixelBytes(size_t count) {
+  std::string result;
+  for (size_t i = 0; i < count; ++i) {
+    result += static_cast<char>((i * 37) % 256);
+  }
+  return result;
+}
+
+void checkReads(Backend backend, size_t queueDepth) {
+  const std::string path = tempPath("raw");
+  std::string contents = pixelBytes(10000);
+  writeFile(path, contents);
+  int fd = open(path.c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+
+  // more reads than the queue depth, with one running past the end
+  AsyncReader reader({queueDepth, 2, backend});
+  EXPECT_EQ(reader.backend(), backend);
+  std::vector<std::string> buffers(11, std::string(1000, '\0'));
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    reader.read(fd, buffers[i].data(), 1000, 1000 * (10 - i), 100 + i);
+  }
+  std::vector<Completion> completions;
+  while (reader.pending() > 0) {
+    reader.wait(completions);
+  }
+  close(fd);
+
+  ASSERT_EQ(completions.size(), buffers.size());
+  std::set<uint64_t> tags;
+  for (const Completion &completion : completions) {
+    tags.insert(completion.tag);
+    size_t i = completion.tag - 100;
+    EXPECT_EQ(completion.error, 0);
+    EXPECT_EQ(completion.bytes, i == 0 ? 0 : 1000);
+    if (i > 0) {
+      EXPECT_EQ(buffers[i], contents.substr(1000 * (10 - i), 1000));
+    }
+  }
+  EXPECT_EQ(tags.size(), buffers.size());
+}
+
+} // namespace
+
+TEST(ReaderTest, Threads) {
+  checkReads(Backend::THREADS, 64);
+  checkReads(Backend::THREADS, 3);
+}
+
+TEST(ReaderTest, Uring) {
+  try {
+    AsyncReader probe({4, 1, Backend::URING});
+  } catch (const std::system_error &) {
+    GTEST_SKIP() << "io_uring is unavailable";
+  }
+  checkReads(Backend::URING, 64);
+  checkReads(Backend::URING, 3);
+}
+
+TEST(ReaderTest, Error) {
+  AsyncReader reader({4, 1, Backend::AUTO});
+  EXPECT_NE(reader.backend(), Backend::AUTO);
+  char buffer[16];
+  reader.read(-1, buffer, sizeof(buffer), 0, 7);
+  std::vector<Completion> completions;
+  EXPECT_EQ(reader.wait(completions), 1);
+  EXPECT_EQ(completions[0].tag, 7);
+  EXPECT_EQ(completions[0].error, EBADF);
+  EXPECT_EQ(reader.pending(), 0);
+  EXPECT_EQ(reader.wait(completions), 0);
+
+  EXPECT_THROW(AsyncReader({0, 1, Backend::AUTO}), std::invalid_argument);
+  EXPECT_THROW(AsyncReader({1, 0, Backend::AUTO}), std::invalid_argument);
+}
+
+TEST(ReaderTest, Numpy) {
+  // the last file spans several reads
+  std::vector<Tensor> expected;
+  expected.reserve(4);
+  expected.emplace_back(pseudoRandom({2, 3}, 0.1));
+  expected.emplace_back(pseudoRandom({}, 0.2));
+  expected.emplace_back(pseudoRandom({5}, 0.3));
+  expected.emplace_back(pseudoRandom({300, 700}, 0.4));
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    paths.push_back(tempPath("numpy" + std::to_string(i) + ".npy"));
+    writeNumpy(paths.back(), expected[i]);
+  }
+
+  for (Backend backend : {Backend::AUTO, Backend::THREADS}) {
+    std::vector<Tensor> tensors = readNumpy(paths, {2, 2, backend});
+    ASSERT_EQ(tensors.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(tensors[i].shape(), expected[i].shape());
+      EXPECT_EQ(tensors[i], expected[i]);
+      EXPECT_EQ(tensors[i], read_numpy(paths[i]));
+    }
+  }
+}
+
+TEST(ReaderTest, Images) {
+  std::string small = pixelBytes(12);
+  std::string large = pixelBytes(2000 * 1500);
+  std::vector<std::string> paths = {tempPath("small.pgm"),
+                                    tempPath("large.pgm")};
+  writeFile(paths[0], "P5\n# comment\n4 3\n255\n" + small);
+  writeFile(paths[1], "P5 2000 1500 255 " + large);
+
+  std::vector<Tensor> images = readImages(paths);
+  ASSERT_EQ(images.size(), 2);
+  EXPECT_EQ(images[0].shape(), array_t({3, 4}));
+  EXPECT_EQ(images[1].shape(), array_t({1500, 2000}));
+  EXPECT_EQ((images[0][{2, 1}]), static_cast<unsigned char>(small[9]));
+  for (size_t i = 0; i < 1500; i += 7) {
+    for (size_t j = 0; j < 2000; j += 13) {
+      EXPECT_EQ((images[1][{i, j}]),
+                static_cast<unsigned char>(large[2000 * i + j]));
+    }
+  }
+}
+
+TEST(ReaderTest, Invalid) {
+  std::string truncated = tempPath("truncated.pgm");
+  writeFile(truncated, "P5\n4 3\n255\n" + pixelBytes(11));
+  std::string ascii = tempPath("ascii.pgm");
+  writeFile(ascii, "P2\n1 1\n255\n0\n");
+  std::string deep = tempPath("deep.pgm");
+  writeFile(deep, "P5\n1 1\n65535\n" + pixelBytes(2));
+  std::string numpy = tempPath("truncated.npy");
+  writeNumpy(numpy, pseudoRandom({4}, 0.5));
+  ::truncate(numpy.c_str(), 100);
+
+  EXPECT_THROW(readImages({truncated}), std::runtime_error);
+  EXPECT_THROW(readImages({ascii}), std::runtime_error);
+  EXPECT_THROW(readImages({deep}), std::runtime_error);
+  EXPECT_THROW(readImages({tempPath("missing.pgm")}), std::runtime_error);
+  EXPECT_THROW(readNumpy({numpy}), std::runtime_error);
+  EXPECT_THROW(readNumpy({ascii}), std::runtime_error);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include "gradstudent/ops.h"
 #include "gradstudent/tensor.h"
 
 using namespace gs;
@@ -52,6 +53,58 @@ TEST(SumTest, Broadcast) {
   }
 }
 
+TEST(SumTest, BroadcastTrailing) {
+  Tensor matrix = Tensor::range(24).reshape({2, 3, 4});
+  Tensor bias = Tensor::range(4);
+  Tensor left = matrix + bias;
+  Tensor right = bias + matrix;
+  ASSERT_EQ(left.shape(), (array_t{2, 3, 4}));
+  ASSERT_EQ(right.shape(), (array_t{2, 3, 4}));
+  for (size_t i = 0; i < 24; ++i) {
+    EXPECT_EQ(left[i], i + i % 4) << "i == " << i;
+    EXPECT_EQ(right[i], i + i % 4) << "i == " << i;
+  }
+}
+
+TEST(SumTest, BroadcastLeading) {
+  Tensor matrix = Tensor::range(12).reshape({3, 4});
+  Tensor column = Tensor::range(3).reshape({3, 1});
+  Tensor sum = matrix + column;
+  ASSERT_EQ(sum.shape(), (array_t{3, 4}));
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      EXPECT_EQ((sum[{i, j}]), 4 * i + j + i) << "i, j == " << i << ", " << j;
+    }
+  }
+}
+
+TEST(SumTest, BroadcastEmpty) {
+  Tensor sum = Tensor::fill({2, 0}, 1) + Tensor::fill({2, 1}, 2);
+  EXPECT_EQ(sum.shape(), (array_t{2, 0}));
+  Tensor prod = Tensor::fill({0, 3}, 1) * Tensor::fill({3}, 2);
+  EXPECT_EQ(prod.shape(), (array_t{0, 3}));
+}
+
+TEST(SumTest, BroadcastScalar) {
+  Tensor matrix = Tensor::range(6).reshape({2, 3});
+  Tensor sum = Tensor(1.5) + matrix;
+  ASSERT_EQ(sum.shape(), (array_t{2, 3}));
+  for (size_t i = 0; i < 6; ++i) {
+    EXPECT_EQ(sum[i], i + 1.5) << "i == " << i;
+  }
+}
+
+TEST(SumTest, BroadcastStrided) {
+  Tensor matrix = Tensor::range(6).reshape({3, 2}, {1, 3});
+  Tensor bias = Tensor::range(2);
+  Tensor sum = matrix + bias;
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 2; ++j) {
+      EXPECT_EQ((sum[{i, j}]), i + 3 * j + j) << "i, j == " << i << ", " << j;
+    }
+  }
+}
+
 TEST(ScalarProdTest, Scalar) {
   Tensor scalar(24);
   Tensor multiple = 5 * scalar;
@@ -135,6 +188,23 @@ TEST(DiffTest, Broadcast) {
   }
 }
 
+TEST(DiffTest, BroadcastOrder) {
+  Tensor matrix = Tensor::range(12).reshape({3, 4});
+  Tensor row = Tensor::range(4);
+  Tensor column = Tensor::range(3).reshape({3, 1});
+  Tensor a = matrix - row;
+  Tensor b = row - matrix;
+  Tensor c = column - matrix;
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      double x = matrix[{i, j}];
+      EXPECT_EQ((a[{i, j}]), x - j);
+      EXPECT_EQ((b[{i, j}]), j - x);
+      EXPECT_EQ((c[{i, j}]), i - x);
+    }
+  }
+}
+
 TEST(ProdTest, Matrix) {
   Tensor matrix1 = Tensor::range(1, 5).reshape({2, 2});
   Tensor matrix2 = Tensor::range(1, 5).reshape({2, 2});
@@ -181,3 +251,39 @@ TEST(IsEqualTest, UnequalScalar) {
   Tensor scalar2(31);
   EXPECT_FALSE(scalar1 == scalar2);
 }
+
+TEST(ScalarOpTest, Contiguous) {
+  Tensor matrix = Tensor::range(6).reshape({2, 3});
+  Tensor sum = matrix + 0.5;
+  Tensor diff = 0.5 - matrix;
+  Tensor prod = 3 * matrix;
+  ASSERT_EQ(sum.shape(), (array_t{2, 3}));
+  for (size_t i = 0; i < 6; ++i) {
+    EXPECT_EQ(sum[i], i + 0.5);
+    EXPECT_EQ((0.5 + matrix)[i], i + 0.5);
+    EXPECT_EQ((matrix - 0.5)[i], i - 0.5);
+    EXPECT_EQ(diff[i], 0.5 - i);
+    EXPECT_EQ(prod[i], 3. * i);
+    EXPECT_EQ((matrix * 3)[i], 3. * i);
+  }
+}
+
+TEST(ScalarOpTest, Strided) {
+  Tensor matrix = Tensor::range(6).reshape({3, 2}, {1, 3});
+  Tensor diff = matrix - 1;
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 2; ++j) {
+      EXPECT_EQ((diff[{i, j}]), i + 3. * j - 1);
+    }
+  }
+}
+
+TEST(AffineTest, Affine) {
+  Tensor matrix = Tensor::range(6).reshape({2, 3});
+  Tensor result = affine(matrix, 2. / 255., -1.);
+  Tensor expected = 2 * ((1. / 255.) * matrix - 0.5);
+  ASSERT_EQ(result.shape(), expected.shape());
+  for (size_t i = 0; i < 6; ++i) {
+    EXPECT_NEAR(result[i], expected[i], 1e-15);
+  }
+}
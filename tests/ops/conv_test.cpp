@@ -1,6 +1,8 @@
+#include "gradstudent/internal/conv.h"
 #include "gradstudent/iter.h"
 #include "gradstudent/ops.h"
 #include "gradstudent/tensor.h"
+#include "test_utils.h"
 
 #include <gtest/gtest.h>
 
@@ -125,6 +127,116 @@ TEST(Conv2dTest, 2DOnesSquareFilters) {
   }
 }
 
+TEST(Conv2dTest, EmptyBackward) {
+  const ConvOptions options{{1, 1}, {1, 1}, {0, 0}};
+  // an empty batch contributes nothing to the kernel gradient
+  for (Layout layout : {Layout::NHWC, Layout::NCHW}) {
+    const bool nhwc = layout == Layout::NHWC;
+    const array_t inShape = nhwc ? array_t{0, 5, 5, 2} : array_t{0, 2, 5, 5};
+    const array_t outShape = nhwc ? array_t{0, 4, 4, 3} : array_t{0, 3, 4, 4};
+    Tensor input = Tensor::fill(inShape, 1);
+    Tensor kernel = Tensor::fill({3, 2, 2, 2}, 1);
+    Tensor grad = Tensor::fill(outShape, 1);
+    Tensor inputGrad(input.shape());
+    Tensor kernelGrad(kernel.shape());
+    conv2dBackward(grad, input, kernel, layout, options, &inputGrad,
+                   &kernelGrad);
+    EXPECT_EQ(kernelGrad, Tensor::fill(kernel.shape(), 0));
+  }
+
+  // as do images without channels
+  Tensor input = Tensor::fill({2, 5, 5, 0}, 1);
+  Tensor kernel = Tensor::fill({3, 2, 2, 0}, 1);
+  Tensor inputGrad(input.shape());
+  Tensor kernelGrad(kernel.shape());
+  conv2dBackward(Tensor::fill({2, 4, 4, 3}, 1), input, kernel, Layout::NHWC,
+                 options, &inputGrad, &kernelGrad);
+  EXPECT_EQ(kernelGrad.shape(), kernel.shape());
+}
+
+namespace {
+
+// reference 2D convolution of a (h, w, c) input with a (f, kh, kw, c) kernel,
+// with padding applied explicitly
+Tensor referenceConv(const Tensor &input, const Tensor &kernel,
+                     const ConvOptions &options) {
+  const array_t &inShape = input.shape();
+  const array_t &kShape = kernel.shape();
+  array_t resultShape{kShape[0], 0, 0};
+  for (size_t d = 0; d < 2; ++d) {
+    size_t padded = inShape[d] + 2 * options.padding[d];
+    size_t extent = options.dilation[d] * (kShape[d + 1] - 1) + 1;
+    resultShape[d + 1] = (padded - extent) / options.stride[d] + 1;
+  }
+
+  Tensor result(resultShape);
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    val = 0;
+    for (size_t i = 0; i < kShape[1]; ++i) {
+      for (size_t j = 0; j < kShape[2]; ++j) {
+        size_t y = idx[1] * options.stride[0] + i * options.dilation[0];
+        size_t x = idx[2] * options.stride[1] + j * options.dilation[1];
+        if (y < options.padding[0] || y >= inShape[0] + options.padding[0] ||
+            x < options.padding[1] || x >= inShape[1] + options.padding[1]) {
+          continue;
+        }
+        for (size_t c = 0; c < inShape[2]; ++c) {
+          val += input[{y - options.padding[0], x - options.padding[1], c}] *
+                 kernel[{idx[0], i, j, c}];
+        }
+      }
+    }
+  }
+  return result;
+}
+
+void checkConvOptions(const ConvOptions &options) {
+  Tensor input = pseudoRandom({9, 11, 2}, 0.1);
+  Tensor kernel = pseudoRandom({3, 3, 4, 2}, 0.2);
+  Tensor expected = referenceConv(input, kernel, options);
+  Tensor result = conv(input, kernel, options, 2);
+  ASSERT_EQ(result.shape(), expected.shape());
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    EXPECT_NEAR(val, expected[idx], 1e-12) << "idx: " << idx;
+  }
+}
+
+} // namespace
+
+TEST(ConvOptionsTest, Defaults) {
+  Tensor input = pseudoRandom({6, 7}, 0.3);
+  Tensor kernel = pseudoRandom({2, 3}, 0.4);
+  EXPECT_EQ(conv(input, kernel, ConvOptions{}), conv(input, kernel));
+}
+
+TEST(ConvOptionsTest, Stride) { checkConvOptions({{2, 3}, {1, 1}, {0, 0}}); }
+
+TEST(ConvOptionsTest, Dilation) { checkConvOptions({{1, 1}, {2, 3}, {0, 0}}); }
+
+TEST(ConvOptionsTest, Padding) { checkConvOptions({{1, 1}, {1, 1}, {1, 2}}); }
+
+TEST(ConvOptionsTest, Combined) { checkConvOptions({{2, 2}, {2, 1}, {3, 1}}); }
+
+TEST(ConvOptionsTest, OneDimensional) {
+  Tensor input = Tensor::range(6);
+  Tensor kernel = Tensor::fill(array_t{2}, 1);
+  Tensor result = conv(input, kernel, {{2}, {}, {1}});
+  ASSERT_EQ(result.shape(), array_t{4});
+  EXPECT_EQ(result[0], 0);
+  EXPECT_EQ(result[1], 3);
+  EXPECT_EQ(result[2], 7);
+  EXPECT_EQ(result[3], 5);
+}
+
+TEST(ConvOptionsTest, Invalid) {
+  Tensor input = pseudoRandom({6, 7}, 0.5);
+  Tensor kernel = pseudoRandom({3, 3}, 0.6);
+  EXPECT_THROW(conv(input, kernel, {{2}, {}, {}}), std::invalid_argument);
+  EXPECT_THROW(conv(input, kernel, {{0, 1}, {}, {}}), std::invalid_argument);
+  EXPECT_THROW(conv(input, kernel, {{}, {3, 3}, {}}), std::invalid_argument);
+  EXPECT_NO_THROW(conv(input, kernel, {{}, {3, 3}, {1, 0}}));
+}
+
 TEST(MaxPoolTest, 1DRange) {
   size_t input_size = 10;
   Tensor input = Tensor::range(input_size);
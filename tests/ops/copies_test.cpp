@@ -1,5 +1,8 @@
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include "gradstudent/internal/parallel.h"
 #include "gradstudent/ops.h"
 #include "gradstudent/tensor.h"
 
@@ -13,3 +16,92 @@ TEST(FlattenTest, Flatten) {
     EXPECT_EQ(flat[i], i + 1);
   }
 }
+
+TEST(FlattenTest, ContiguousIsView) {
+  Tensor matrix = Tensor::range(1, 7).reshape({2, 3});
+  bool copied = true;
+  Tensor flat = flatten(matrix, copied);
+  EXPECT_FALSE(copied);
+  EXPECT_EQ(flat.shape(), array_t{6});
+  EXPECT_EQ(flat, Tensor::range(1, 7));
+
+  // the view is read-only
+  flat[0] = 10;
+  EXPECT_EQ(matrix[0], 1);
+}
+
+TEST(FlattenTest, PermutedIsCopy) {
+  Tensor matrix = Tensor::range(6).reshape({2, 3});
+  bool copied = false;
+  Tensor flat = flatten(permute(matrix, {1, 0}), copied);
+  EXPECT_TRUE(copied);
+  ASSERT_EQ(flat.shape(), array_t{6});
+  double expected[] = {0, 3, 1, 4, 2, 5};
+  for (size_t i = 0; i < 6; ++i) {
+    EXPECT_EQ(flat[i], expected[i]);
+  }
+}
+
+TEST(ConcatTest, Axes) {
+  Tensor a = Tensor::range(6).reshape({2, 3});
+  Tensor b = Tensor::range(6, 10).reshape({2, 2});
+  Tensor rows = concat({&a, &a}, 0);
+  EXPECT_EQ(rows.shape(), array_t({4, 3}));
+  EXPECT_EQ(slice(rows, {3}), slice(a, {1}));
+  Tensor columns = concat({&a, &b}, 1);
+  EXPECT_EQ(columns.shape(), array_t({2, 5}));
+  double expected[] = {0, 1, 2, 6, 7, 3, 4, 5, 8, 9};
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(columns[i], expected[i]);
+  }
+
+  // strided inputs
+  Tensor c = permute(a, {1, 0});
+  Tensor d = permute(b, {1, 0});
+  EXPECT_EQ(concat({&c, &d}, 0), permute(columns, {1, 0}));
+}
+
+TEST(ConcatTest, Parallel) {
+  // more inputs than threads, and a few large ones
+  std::vector<Tensor> small;
+  small.reserve(20);
+  std::vector<const Tensor *> smallPtrs;
+  for (int i = 0; i < 20; ++i) {
+    small.emplace_back(
+        Tensor::range(100 * i, 100 * i + 5000).reshape({50, 100}));
+    smallPtrs.push_back(&small.back());
+  }
+  Tensor large = Tensor::range(200000).reshape({2000, 100});
+  setNumThreads(4);
+  Tensor joined = concat(smallPtrs, 0);
+  Tensor stacked = stack({&large, &large}, 1);
+  setNumThreads(0);
+  for (size_t i = 0; i < 20; ++i) {
+    EXPECT_EQ(truncate(joined, {50 * i}, {50 * (i + 1)}), small[i]);
+  }
+  EXPECT_EQ(stacked.shape(), array_t({2000, 2, 100}));
+  EXPECT_EQ(slice(stacked, {1999, 1}), slice(large, {1999}));
+}
+
+TEST(StackTest, Axes) {
+  Tensor a = Tensor::range(6).reshape({2, 3});
+  Tensor b = Tensor::range(6, 12).reshape({2, 3});
+  Tensor first = stack({&a, &b});
+  EXPECT_EQ(first.shape(), array_t({2, 2, 3}));
+  EXPECT_EQ(slice(first, {1}), b);
+  Tensor last = stack({&a, &b}, 2);
+  EXPECT_EQ(last.shape(), array_t({2, 3, 2}));
+  EXPECT_EQ((last[{1, 2, 0}]), 5);
+  EXPECT_EQ((last[{1, 2, 1}]), 11);
+}
+
+TEST(StackTest, Invalid) {
+  Tensor a({2, 3});
+  Tensor b({3, 2});
+  EXPECT_THROW(concat({}, 0), std::invalid_argument);
+  EXPECT_THROW(concat({&a, &b}, 0), std::invalid_argument);
+  EXPECT_THROW(concat({&a, &a}, 2), std::invalid_argument);
+  EXPECT_THROW(stack({}), std::invalid_argument);
+  EXPECT_THROW(stack({&a, &b}), std::invalid_argument);
+  EXPECT_THROW(stack({&a, &a}, 3), std::invalid_argument);
+}
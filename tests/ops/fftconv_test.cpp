@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include "gradstudent/internal/conv.h"
+#include "gradstudent/iter.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+
+namespace {
+
+void checkMultiFilter(const Tensor &result, const Tensor &input,
+                      const Tensor &kernel) {
+  for (size_t l = 0; l < kernel.shape()[0]; ++l) {
+    Tensor k(slice(kernel, {l}));
+    Tensor r(slice(result, {l}));
+    for (const auto &[idx, val] : ITensorIter(r)) {
+      EXPECT_NEAR(val, directConv(input, k, idx[0], idx[1]), 1e-10)
+          << "filter: " << l << ", idx: " << idx;
+    }
+  }
+}
+
+} // namespace
+
+TEST(FFTConvTest, MultiFilter) {
+  Tensor input = pseudoRandom({23, 37, 3}, 0.1);
+  Tensor kernel = pseudoRandom({4, 9, 11, 3}, 0.2);
+
+  Tensor result = fftConv(input, kernel, 2);
+  ASSERT_EQ(result.shape(), (array_t{4, 15, 27}));
+  checkMultiFilter(result, input, kernel);
+}
+
+TEST(FFTConvTest, SingleKernel) {
+  Tensor input = pseudoRandom({16, 20}, 0.3);
+  Tensor kernel = pseudoRandom({7, 5}, 0.4);
+
+  Tensor result = fftConv(input, kernel, 2);
+  Tensor expected = conv(input, kernel);
+  ASSERT_EQ(result.shape(), (array_t{10, 16}));
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    EXPECT_NEAR(val, expected[idx], 1e-10) << "idx: " << idx;
+  }
+}
+
+TEST(FFTConvTest, OneDimensional) {
+  Tensor input = pseudoRandom({50, 2}, 0.5);
+  Tensor kernel = pseudoRandom({3, 13, 2}, 0.6);
+
+  Tensor result = fftConv(input, kernel, 1);
+  ASSERT_EQ(result.shape(), (array_t{3, 38}));
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    double expected = 0;
+    for (size_t j = 0; j < 13; ++j) {
+      for (size_t c = 0; c < 2; ++c) {
+        expected += input[{idx[1] + j, c}] * kernel[{idx[0], j, c}];
+      }
+    }
+    EXPECT_NEAR(val, expected, 1e-10) << "idx: " << idx;
+  }
+}
+
+TEST(FFTConvTest, CostModel) {
+  Tensor input = pseudoRandom({64, 64}, 0.7);
+  EXPECT_FALSE(fftConvPreferred(input, pseudoRandom({2, 2}, 0.8), 2));
+  EXPECT_TRUE(fftConvPreferred(input, pseudoRandom({31, 31}, 0.8), 2));
+  EXPECT_FALSE(fftConvPreferred(input, pseudoRandom({31, 31, 2}, 0.8), 2));
+}
+
+TEST(FFTConvTest, Dispatch) {
+  Tensor input = pseudoRandom({48, 48, 2}, 0.9);
+  Tensor kernel = pseudoRandom({2, 25, 25, 2}, 1.0);
+  ASSERT_TRUE(fftConvPreferred(input, kernel, 2));
+  EXPECT_EQ(conv(input, kernel, 2), fftConv(input, kernel, 2));
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include "gradstudent/iter.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+
+namespace {
+
+// computes the conv block out of unfused operations
+Tensor reference(const Tensor &input, const Tensor &kernel, const Tensor &bias,
+                 bool pool) {
+  const auto &x1 = conv(input, kernel, 2);
+  const auto &x2 = permute(x1, {1, 2, 0}) + bias;
+  const auto &x3 = relu(x2);
+  if (!pool) {
+    return x3;
+  }
+  const auto &x4 = maxPool(permute(x3, {2, 0, 1}), {2, 2});
+  return permute(x4, {1, 2, 0});
+}
+
+} // namespace
+
+TEST(ConvBlockTest, MatchesUnfused) {
+  Tensor input = pseudoRandom({12, 10, 3}, 0.1);
+  Tensor kernel = pseudoRandom({4, 3, 3, 3}, 0.2);
+  Tensor bias = pseudoRandom({4}, 0.3);
+
+  Tensor expected = reference(input, kernel, bias, true);
+  Tensor result = convBlock(input, kernel, bias,
+                            {Activation::RELU, PoolType::MAX, {2, 2}});
+  ASSERT_EQ(result.shape(), expected.shape());
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    EXPECT_NEAR(val, expected[idx], 1e-12);
+  }
+}
+
+TEST(ConvBlockTest, NoPool) {
+  Tensor input = pseudoRandom({7, 6, 2}, 0.4);
+  Tensor kernel = pseudoRandom({5, 2, 3, 2}, 0.5);
+  Tensor bias = pseudoRandom({5}, 0.6);
+
+  Tensor expected = reference(input, kernel, bias, false);
+  Tensor result = convBlock(input, kernel, bias, {Activation::RELU, PoolType::NONE, {}});
+  ASSERT_EQ(result.shape(), expected.shape());
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    EXPECT_NEAR(val, expected[idx], 1e-12);
+  }
+}
+
+TEST(ConvBlockTest, AvgPool) {
+  Tensor input = Tensor::fill({5, 5, 1}, 1);
+  Tensor kernel = Tensor::fill({2, 2, 2, 1}, 1);
+  Tensor bias = Tensor::range(2);
+  Tensor result = convBlock(input, kernel, bias,
+                            {Activation::NONE, PoolType::AVG, {2, 2}});
+  ASSERT_EQ(result.shape(), (array_t{2, 2, 2}));
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    EXPECT_EQ(val, 4 + idx[2]);
+  }
+}
+
+TEST(ConvBlockTest, PoolMustDivide) {
+  Tensor input = Tensor::fill({6, 6, 1}, 1);
+  Tensor kernel = Tensor::fill({1, 2, 2, 1}, 1);
+  Tensor bias = Tensor::fill({1}, 0);
+  EXPECT_THROW(convBlock(input, kernel, bias,
+                         {Activation::RELU, PoolType::MAX, {2, 2}}),
+               std::invalid_argument);
+  EXPECT_THROW(convBlock(input, kernel, bias,
+                         {Activation::RELU, PoolType::MAX, {0, 5}}),
+               std::invalid_argument);
+  EXPECT_THROW(convBlock(input, kernel, bias,
+                         {Activation::NONE, PoolType::AVG, {5, 0}}),
+               std::invalid_argument);
+}
@@ -0,0 +1,75 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/internal/gemm.h"
+#include "gradstudent/internal/parallel.h"
+#include "test_utils.h"
+
+using namespace gs;
+
+namespace {
+
+// compares gemm against a naive product, with leading dimensions padded by
+// three elements
+void checkGemm(bool transA, bool transB, size_t m, size_t n, size_t k,
+               double alpha, double beta) {
+  const size_t lda = (transA ? m : k) + 3;
+  const size_t ldb = (transB ? k : n) + 3;
+  const size_t ldc = n + 3;
+  std::vector<double> a = pseudoRandomVector((transA ? k : m) * lda, 0.1);
+  std::vector<double> b = pseudoRandomVector((transB ? n : k) * ldb, 0.2);
+  std::vector<double> c = pseudoRandomVector(m * ldc, 0.3);
+
+  std::vector<double> expected(c);
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      double acc = 0;
+      for (size_t p = 0; p < k; ++p) {
+        acc += (transA ? a[p * lda + i] : a[i * lda + p]) *
+               (transB ? b[j * ldb + p] : b[p * ldb + j]);
+      }
+      expected[i * ldc + j] = alpha * acc + beta * c[i * ldc + j];
+    }
+  }
+
+  gemm(transA, transB, m, n, k, alpha, a.data(), lda, b.data(), ldb, beta,
+       c.data(), ldc);
+  for (size_t i = 0; i < m * ldc; ++i) {
+    EXPECT_NEAR(c[i], expected[i], 1e-12) << "i: " << i;
+  }
+}
+
+} // namespace
+
+TEST(GemmTest, Small) {
+  for (bool transA : {false, true}) {
+    for (bool transB : {false, true}) {
+      checkGemm(transA, transB, 5, 7, 3, 1, 0);
+      checkGemm(transA, transB, 1, 1, 9, 2, 0.5);
+    }
+  }
+}
+
+TEST(GemmTest, Blocked) {
+  // sizes spanning several row, column and depth panels with ragged edges
+  checkGemm(false, false, 201, 263, 517, 1, 0);
+  checkGemm(true, false, 103, 130, 300, -0.5, 1);
+  checkGemm(false, true, 99, 129, 257, 1, 2);
+  checkGemm(true, true, 97, 5, 260, 1, 0);
+}
+
+TEST(GemmTest, Degenerate) {
+  std::vector<double> c{1, 2, 3, 4};
+  gemm(false, false, 2, 2, 0, 1, nullptr, 1, nullptr, 2, 0.5, c.data(), 2);
+  EXPECT_EQ(c, (std::vector<double>{0.5, 1, 1.5, 2}));
+  gemm(false, false, 2, 2, 0, 1, nullptr, 1, nullptr, 2, 0, c.data(), 2);
+  EXPECT_EQ(c, (std::vector<double>{0, 0, 0, 0}));
+}
+
+TEST(GemmTest, Parallel) {
+  setNumThreads(4);
+  checkGemm(false, false, 300, 150, 64, 1, 0);
+  checkGemm(true, true, 40, 700, 64, 1, 0);
+  setNumThreads(0);
+}
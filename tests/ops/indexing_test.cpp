@@ -0,0 +1,159 @@
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/iter.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+
+namespace {
+
+// indices into an axis of size n, with repeats
+Tensor pseudoIndices(const array_t &shape, size_t n, size_t seed) {
+  Tensor result(shape);
+  size_t x = seed;
+  for (const auto &[val] : TensorIter(result)) {
+    val = static_cast<double>(x % n);
+    x = x * 7 + 3;
+  }
+  return result;
+}
+
+Tensor referenceGather(const Tensor &tensor, size_t axis,
+                       const Tensor &indices) {
+  Tensor result(indices.shape());
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    array_t j = idx;
+    j[axis] = static_cast<size_t>(indices[idx]);
+    val = tensor[j];
+  }
+  return result;
+}
+
+// applies the updates in row-major order of the indices
+Tensor referenceScatter(const Tensor &tensor, size_t axis,
+                        const Tensor &indices, const Tensor &src, bool add) {
+  Tensor result(tensor);
+  for (const auto &[idx, val] : ITensorIter(src)) {
+    array_t j = idx;
+    j[axis] = static_cast<size_t>(indices[idx]);
+    result[j] = add ? result[j] + val : val;
+  }
+  return result;
+}
+
+Tensor referenceIndexAdd(const Tensor &tensor, size_t axis,
+                         const Tensor &indices, const Tensor &src) {
+  Tensor result(tensor);
+  for (const auto &[idx, val] : ITensorIter(src)) {
+    array_t j = idx;
+    j[axis] = static_cast<size_t>(indices[idx[axis]]);
+    result[j] = result[j] + val;
+  }
+  return result;
+}
+
+void checkIndexing(const Tensor &tensor, size_t axis, size_t m) {
+  const size_t n = tensor.shape()[axis];
+  array_t shape = tensor.shape();
+  shape[axis] = m;
+  Tensor indices = pseudoIndices(shape, n, 1);
+  Tensor src = pseudoRandom(shape, 0.9);
+  EXPECT_EQ(gather(tensor, axis, indices),
+            referenceGather(tensor, axis, indices));
+  EXPECT_EQ(scatter(tensor, axis, indices, src),
+            referenceScatter(tensor, axis, indices, src, false));
+  EXPECT_EQ(scatterAdd(tensor, axis, indices, src),
+            referenceScatter(tensor, axis, indices, src, true));
+
+  Tensor rows = pseudoIndices({m}, n, 2);
+  Tensor selected = indexSelect(tensor, axis, rows);
+  EXPECT_EQ(selected.shape(), shape);
+  for (const auto &[idx, val] : ITensorIter(selected)) {
+    array_t j = idx;
+    j[axis] = static_cast<size_t>(rows[idx[axis]]);
+    EXPECT_EQ(val, tensor[j]);
+  }
+  EXPECT_EQ(indexAdd(tensor, axis, rows, src),
+            referenceIndexAdd(tensor, axis, rows, src));
+}
+
+} // namespace
+
+TEST(IndexingTest, Axes) {
+  Tensor tensor = pseudoRandom({4, 5, 6}, 0.1);
+  checkIndexing(tensor, 0, 7);
+  checkIndexing(tensor, 1, 3);
+  checkIndexing(tensor, 2, 6);
+  checkIndexing(pseudoRandom({9}, 0.2), 0, 20);
+  // strided input
+  Tensor base = pseudoRandom({6, 5, 4}, 0.3);
+  checkIndexing(permute(base, {2, 1, 0}), 1, 4);
+}
+
+TEST(IndexingTest, Parallel) {
+  // embedding-like tables, with rows spanning several column blocks, and a
+  // single long axis split into ranges
+  Tensor table = pseudoRandom({50, 300}, 0.4);
+  Tensor flat = pseudoRandom({1000}, 0.5);
+  setNumThreads(4);
+  checkIndexing(table, 0, 400);
+  checkIndexing(table, 1, 200);
+  checkIndexing(flat, 0, 30000);
+  setNumThreads(0);
+}
+
+TEST(IndexingTest, Embedding) {
+  Tensor table = pseudoRandom({10, 4}, 0.6);
+  Tensor ids(array_t{3});
+  ids[0] = 7;
+  ids[1] = 2;
+  ids[2] = 7;
+  Tensor embedded = indexSelect(table, 0, ids);
+  EXPECT_EQ(slice(embedded, {2}), slice(table, {7}));
+  Tensor grad = indexAdd(Tensor::fill({10, 4}, 0), 0, ids,
+                         Tensor::fill({3, 4}, 1));
+  EXPECT_EQ((grad[{7, 3}]), 2);
+  EXPECT_EQ((grad[{2, 0}]), 1);
+  EXPECT_EQ((grad[{0, 0}]), 0);
+
+  // picking the log-probability of each label
+  Tensor labels({3, 1});
+  labels[0] = 3;
+  labels[1] = 0;
+  labels[2] = 1;
+  Tensor picked = gather(embedded, 1, labels);
+  EXPECT_EQ(picked.shape(), array_t({3, 1}));
+  EXPECT_EQ((picked[{0, 0}]), (table[{7, 3}]));
+  EXPECT_EQ((picked[{1, 0}]), (table[{2, 0}]));
+}
+
+TEST(IndexingTest, Invalid) {
+  Tensor tensor = pseudoRandom({3, 4}, 0.7);
+  Tensor indices = pseudoIndices({2, 4}, 3, 1);
+  Tensor src({2, 4});
+  EXPECT_THROW(gather(tensor, 2, indices), std::invalid_argument);
+  EXPECT_THROW(gather(tensor, 1, indices), std::invalid_argument);
+  EXPECT_THROW(gather(tensor, 0, Tensor({2})), std::invalid_argument);
+  EXPECT_THROW(scatter(tensor, 0, indices, Tensor({2, 3})),
+               std::invalid_argument);
+  EXPECT_THROW(indexSelect(tensor, 0, indices), std::invalid_argument);
+  EXPECT_THROW(indexAdd(tensor, 0, Tensor::fill({2}, 0), Tensor({3, 4})),
+               std::invalid_argument);
+
+  Tensor outOfRange = Tensor::fill({2, 4}, 3);
+  EXPECT_THROW(gather(tensor, 0, outOfRange), std::invalid_argument);
+  EXPECT_THROW(scatterAdd(tensor, 0, outOfRange, src), std::invalid_argument);
+  EXPECT_THROW(indexSelect(tensor, 1, Tensor::fill({1}, -1)),
+               std::invalid_argument);
+
+  Tensor fractional = Tensor::fill({2, 4}, 1.7);
+  EXPECT_THROW(gather(tensor, 0, fractional), std::invalid_argument);
+  EXPECT_THROW(scatter(tensor, 0, fractional, src), std::invalid_argument);
+  EXPECT_THROW(indexSelect(tensor, 1, Tensor::fill({1}, 0.5)),
+               std::invalid_argument);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include "gradstudent/iter.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+
+TEST(LayoutTest, ConvNHWC) {
+  Tensor input = pseudoRandom({9, 8, 3}, 0.1);
+  Tensor kernel = pseudoRandom({4, 3, 2, 3}, 0.2);
+  ConvOptions options{{2, 1}, {1, 2}, {1, 1}};
+
+  // conv over the spatial dimensions produces filters first
+  Tensor expected = permute(conv(input, kernel, options, 2), {1, 2, 0});
+  expectNear(conv(input, kernel, Layout::NHWC, options), expected);
+}
+
+TEST(LayoutTest, ConvNCHW) {
+  Tensor input = pseudoRandom({9, 8, 3}, 0.3);
+  Tensor kernel = pseudoRandom({4, 3, 2, 3}, 0.4);
+  ConvOptions options{{1, 2}, {}, {2, 0}};
+
+  Tensor expected = conv(input, kernel, options, 2);
+  Tensor result = conv(permute(input, {2, 0, 1}), permute(kernel, {0, 3, 1, 2}),
+                       Layout::NCHW, options);
+  expectNear(result, expected);
+}
+
+TEST(LayoutTest, ConvBatched) {
+  Tensor input = pseudoRandom({2, 7, 6, 2}, 0.5);
+  Tensor kernel = pseudoRandom({3, 2, 2, 2}, 0.6);
+
+  Tensor result = conv(input, kernel, Layout::NHWC);
+  ASSERT_EQ(result.shape(), (array_t{2, 6, 5, 3}));
+  for (size_t i = 0; i < 2; ++i) {
+    expectNear(slice(result, {i}),
+               conv(slice(input, {i}), kernel, Layout::NHWC));
+  }
+}
+
+TEST(LayoutTest, ConvInvalid) {
+  Tensor input = pseudoRandom({5, 5, 2}, 0.7);
+  EXPECT_THROW(conv(input, pseudoRandom({3, 2, 2, 3}, 0.8), Layout::NHWC),
+               std::invalid_argument);
+  EXPECT_THROW(conv(input, pseudoRandom({3, 2, 2}, 0.8), Layout::NHWC),
+               std::invalid_argument);
+}
+
+TEST(LayoutTest, Pool) {
+  Tensor input = pseudoRandom({3, 9, 10}, 0.9);
+  PoolOptions options{{2, 3}, {1, 1}};
+  Tensor maxExpected = maxPool(input, {3, 3}, options);
+  Tensor avgExpected = avgPool(input, {3, 3}, options);
+
+  expectNear(maxPool(input, {3, 3}, Layout::NCHW, options), maxExpected);
+  expectNear(avgPool(input, {3, 3}, Layout::NCHW, options), avgExpected);
+
+  Tensor nhwc = permute(input, {1, 2, 0});
+  expectNear(maxPool(nhwc, {3, 3}, Layout::NHWC, options),
+             permute(maxExpected, {1, 2, 0}));
+  expectNear(avgPool(nhwc, {3, 3}, Layout::NHWC, options),
+             permute(avgExpected, {1, 2, 0}));
+  expectNear(maxPool(nhwc, {2, 2}, Layout::NHWC),
+             permute(maxPool(input, {2, 2}, PoolOptions{}), {1, 2, 0}));
+
+  auto [pooled, indices] =
+      maxPoolWithIndices(nhwc, {3, 3}, Layout::NHWC, options);
+  expectNear(pooled, permute(maxExpected, {1, 2, 0}));
+  Tensor flat = flatten(nhwc);
+  for (const auto &[idx, val] : ITensorIter(pooled)) {
+    EXPECT_EQ(flat[static_cast<size_t>(indices[idx])], val) << "idx: " << idx;
+  }
+}
+
+TEST(LayoutTest, AddBias) {
+  Tensor bias = pseudoRandom({3}, 1.0);
+  Tensor nchw = pseudoRandom({2, 3, 4, 5}, 1.1);
+  Tensor result = addBias(nchw, bias, Layout::NCHW);
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    EXPECT_EQ(val, nchw[idx] + bias[idx[1]]) << "idx: " << idx;
+  }
+
+  Tensor nhwc = pseudoRandom({4, 5, 3}, 1.2);
+  EXPECT_EQ(addBias(nhwc, bias, Layout::NHWC), nhwc + bias);
+
+  EXPECT_THROW(addBias(nhwc, bias, Layout::NCHW), std::invalid_argument);
+}
@@ -1,10 +1,32 @@
+#include "gradstudent/internal/utils.h"
 #include "gradstudent/ops.h"
 #include "gradstudent/tensor.h"
+#include "test_utils.h"
 
 #include <gtest/gtest.h>
 
 using namespace gs;
 
+namespace {
+
+// naive product of matrices of shape (m, k) and (k, n)
+Tensor referenceDot(const Tensor &left, const Tensor &right) {
+  const size_t m = left.shape()[0];
+  const size_t k = left.shape()[1];
+  const size_t n = right.shape()[1];
+  Tensor result = Tensor::fill({m, n}, 0);
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      for (size_t p = 0; p < k; ++p) {
+        result[{i, j}] += left[{i, p}] * right[{p, j}];
+      }
+    }
+  }
+  return result;
+}
+
+} // namespace
+
 TEST(DotTest, MatrixVector) {
   Tensor matrix = Tensor::range(1, 5).reshape({2, 2});
   Tensor vector1 = Tensor::range(5, 7).reshape({2, 1});
@@ -39,6 +61,41 @@ TEST(DotTest, TensorMatrix) {
   EXPECT_EQ(result.shape(), (array_t{4, 5, 2, 2}));
 }
 
+TEST(DotTest, Deep) {
+  // the contracted dimension spans several GEMM panels
+  Tensor left = pseudoRandom({20, 600}, 0.1);
+  Tensor right = pseudoRandom({600, 10}, 0.2);
+  expectNear(dot(left, right), referenceDot(left, right));
+}
+
+TEST(DotTest, Views) {
+  const Tensor left = pseudoRandom({7, 5}, 0.3);
+  const Tensor right = pseudoRandom({7, 6}, 0.4);
+  const Tensor lt = permute(left, {1, 0});
+  const Tensor rt = permute(right, {1, 0});
+  expectNear(dot(lt, right), referenceDot(contiguous(lt), right));
+  expectNear(dot(rt, left), referenceDot(contiguous(rt), left));
+
+  // column and strided vectors
+  const Tensor column = slice(permute(right, {1, 0}), {2});
+  Tensor result = dot(lt, column);
+  ASSERT_EQ(result.shape(), array_t{5});
+  for (size_t i = 0; i < 5; ++i) {
+    double expected = 0;
+    for (size_t p = 0; p < 7; ++p) {
+      expected += left[{p, i}] * right[{p, 2}];
+    }
+    EXPECT_NEAR(result[i], expected, 1e-12);
+  }
+  EXPECT_NEAR(double(dot(column, column)), double(norm2(contiguous(column))),
+              1e-12);
+
+  // a non-contiguous operand of higher rank is copied
+  const Tensor tensor = permute(pseudoRandom({5, 2, 3}, 0.5), {1, 0, 2});
+  Tensor expected = dot(contiguous(tensor), right.reshape({3, 14}));
+  EXPECT_EQ(dot(tensor, right.reshape({3, 14})), expected);
+}
+
 TEST(NormTest, Matrix) {
   Tensor tensor = Tensor::range(1, 5).reshape({2, 2});
   EXPECT_EQ(norm2(tensor), 30);
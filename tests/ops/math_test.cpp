@@ -0,0 +1,73 @@
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/iter.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+
+namespace {
+
+// accuracy is tested in vecmath_test.cpp, so compare loosely against libm
+template <typename F, typename G>
+void checkElementwise(F op, G reference, const Tensor &input) {
+  Tensor result = op(input);
+  ASSERT_EQ(result.shape(), input.shape());
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    double expected = reference(input[idx]);
+    double tolerance = 1e-14 * std::fabs(expected) + 1e-16;
+    EXPECT_NEAR(val, expected, tolerance) << "idx: " << idx;
+  }
+}
+
+} // namespace
+
+TEST(MathTest, Contiguous) {
+  // large enough to be split across threads
+  Tensor input = 3 * pseudoRandom({300, 301}, 0.1);
+  checkElementwise([](auto &t) { return exp(t); },
+                   [](double x) { return std::exp(x); }, input);
+  checkElementwise([](auto &t) { return tanh(t); },
+                   [](double x) { return std::tanh(x); }, input);
+  checkElementwise([](auto &t) { return sigmoid(t); },
+                   [](double x) { return 1 / (1 + std::exp(-x)); }, input);
+  Tensor positive = exp(input);
+  checkElementwise([](auto &t) { return log(t); },
+                   [](double x) { return std::log(x); }, positive);
+}
+
+TEST(MathTest, Strided) {
+  Tensor input = pseudoRandom({4, 6}, 0.2);
+  const Tensor transposed = permute(input, {1, 0});
+  checkElementwise([](auto &t) { return exp(t); },
+                   [](double x) { return std::exp(x); }, transposed);
+  checkElementwise([](auto &t) { return tanh(t); },
+                   [](double x) { return std::tanh(x); }, transposed);
+}
+
+TEST(MathTest, Gelu) {
+  Tensor input = 4 * pseudoRandom({5, 7}, 0.3);
+  checkElementwise(
+      [](auto &t) { return gelu(t); },
+      [](double x) {
+        double z = std::sqrt(2 / M_PI) * (x + 0.044715 * x * x * x);
+        return 0.5 * x * (1 + std::tanh(z));
+      },
+      input);
+}
+
+TEST(MathTest, Divide) {
+  Tensor left = pseudoRandom({3, 4}, 0.4);
+  Tensor right = pseudoRandom({4}, 0.5) + 2;
+  Tensor quotient = left / right;
+  ASSERT_EQ(quotient.shape(), (array_t{3, 4}));
+  for (const auto &[idx, val] : ITensorIter(quotient)) {
+    EXPECT_EQ(val, left[idx] / right[{idx[1]}]) << "idx: " << idx;
+    EXPECT_EQ((left / 4.)[idx], left[idx] / 4.) << "idx: " << idx;
+    EXPECT_EQ((4. / right)[{idx[1]}], 4. / right[{idx[1]}]) << "idx: " << idx;
+  }
+  EXPECT_THROW(left / pseudoRandom({3}, 0.6), std::invalid_argument);
+}
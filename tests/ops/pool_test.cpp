@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/iter.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+
+namespace {
+
+// reference 2D pooling of a (c, h, w) input
+Tensor referencePool(const Tensor &input, const array_t &window,
+                     const array_t &stride, const array_t &padding, bool avg) {
+  const array_t &inShape = input.shape();
+  array_t resultShape{inShape[0], 0, 0};
+  for (size_t d = 0; d < 2; ++d) {
+    resultShape[d + 1] =
+        (inShape[d + 1] + 2 * padding[d] - window[d]) / stride[d] + 1;
+  }
+
+  Tensor result(resultShape);
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    double acc = avg ? 0 : -std::numeric_limits<double>::infinity();
+    size_t count = 0;
+    for (size_t i = 0; i < window[0]; ++i) {
+      for (size_t j = 0; j < window[1]; ++j) {
+        size_t y = idx[1] * stride[0] + i;
+        size_t x = idx[2] * stride[1] + j;
+        if (y < padding[0] || y >= inShape[1] + padding[0] ||
+            x < padding[1] || x >= inShape[2] + padding[1]) {
+          continue;
+        }
+        double v = input[{idx[0], y - padding[0], x - padding[1]}];
+        acc = avg ? acc + v : std::max(acc, v);
+        ++count;
+      }
+    }
+    val = avg ? acc / static_cast<double>(count) : acc;
+  }
+  return result;
+}
+
+void checkPool(const array_t &window, const array_t &stride,
+               const array_t &padding) {
+  Tensor input = pseudoRandom({3, 11, 13}, 0.1);
+  PoolOptions options{stride, padding};
+
+  Tensor maxResult = maxPool(input, window, options);
+  Tensor maxExpected = referencePool(input, window, stride, padding, false);
+  ASSERT_EQ(maxResult.shape(), maxExpected.shape());
+  EXPECT_EQ(maxResult, maxExpected);
+
+  Tensor avgResult = avgPool(input, window, options);
+  Tensor avgExpected = referencePool(input, window, stride, padding, true);
+  ASSERT_EQ(avgResult.shape(), avgExpected.shape());
+  for (const auto &[idx, val] : ITensorIter(avgResult)) {
+    EXPECT_NEAR(val, avgExpected[idx], 1e-12) << "idx: " << idx;
+  }
+}
+
+} // namespace
+
+TEST(PoolTest, Disjoint) { checkPool({2, 3}, {2, 3}, {0, 0}); }
+
+TEST(PoolTest, Overlapping) { checkPool({3, 3}, {1, 2}, {0, 0}); }
+
+TEST(PoolTest, Padded) { checkPool({3, 4}, {2, 3}, {1, 2}); }
+
+TEST(PoolTest, PaddingOnlyWindow) {
+  // the window of the only output ends in the padding past the input
+  Tensor input({2, 1});
+  input[0] = 0;
+  input[1] = 100;
+  PoolOptions options{{2}, {1}};
+  EXPECT_EQ(maxPool(input, {3}, options), input);
+  EXPECT_EQ(avgPool(input, {3}, options), input);
+  checkPool({3, 3}, {2, 4}, {1, 1});
+}
+
+TEST(PoolTest, LegacyMaxPool) {
+  Tensor input = pseudoRandom({4, 6}, 0.2);
+  EXPECT_EQ(maxPool(input, {2, 3}), maxPool(input, {2, 3}, PoolOptions{}));
+  EXPECT_THROW(maxPool(input, {3, 3}), std::invalid_argument);
+}
+
+TEST(PoolTest, Indices) {
+  Tensor input = pseudoRandom({2, 7, 8}, 0.3);
+  auto [result, indices] = maxPoolWithIndices(input, {3, 3}, {{2, 2}, {1, 1}});
+  EXPECT_EQ(result, maxPool(input, {3, 3}, {{2, 2}, {1, 1}}));
+  ASSERT_EQ(indices.shape(), result.shape());
+
+  Tensor flat = flatten(input);
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    auto i = static_cast<size_t>(indices[idx]);
+    EXPECT_EQ(flat[i], val) << "idx: " << idx;
+  }
+}
+
+TEST(PoolTest, Backward) {
+  // overlapping windows route several gradients to the same maximum
+  Tensor input = pseudoRandom({2, 6, 7}, 0.6);
+  auto [result, indices] = maxPoolWithIndices(input, {3, 3}, {{1, 2}, {1, 0}});
+  Tensor grad = pseudoRandom(result.shape(), 0.7);
+  Tensor inputGrad = maxPoolBackward(grad, indices, input.shape());
+  ASSERT_EQ(inputGrad.shape(), input.shape());
+
+  Tensor expected = Tensor::fill({input.size()}, 0);
+  for (const auto &[idx, g] : ITensorIter(grad)) {
+    expected[static_cast<size_t>(indices[idx])] += g;
+  }
+  Tensor flat = flatten(inputGrad);
+  for (size_t i = 0; i < input.size(); ++i) {
+    EXPECT_DOUBLE_EQ(flat[i], expected[i]) << "i: " << i;
+  }
+
+  EXPECT_THROW(maxPoolBackward(grad, input, input.shape()),
+               std::invalid_argument);
+  EXPECT_THROW(maxPoolBackward(grad, indices, {2, 3}), std::invalid_argument);
+}
+
+TEST(PoolTest, Global) {
+  Tensor input = pseudoRandom({3, 5, 4}, 0.4);
+  Tensor maxResult = globalMaxPool(input, 2);
+  Tensor avgResult = globalAvgPool(input, 2);
+  ASSERT_EQ(maxResult.shape(), array_t{3});
+  ASSERT_EQ(avgResult.shape(), array_t{3});
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(maxResult[i], max(slice(input, {i})));
+    EXPECT_NEAR(avgResult[i], double(sum(slice(input, {i}))) / 20, 1e-12);
+  }
+}
+
+TEST(PoolTest, Invalid) {
+  Tensor input = pseudoRandom({5, 5}, 0.5);
+  EXPECT_THROW(avgPool(input, {2, 2}, {{1}, {}}), std::invalid_argument);
+  EXPECT_THROW(avgPool(input, {2, 2}, {{}, {2, 0}}), std::invalid_argument);
+  EXPECT_THROW(avgPool(input, {6, 2}), std::invalid_argument);
+  EXPECT_THROW(avgPool(input, {2, 2, 2}), std::invalid_argument);
+}
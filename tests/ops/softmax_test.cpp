@@ -0,0 +1,98 @@
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/iter.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+
+namespace {
+
+// naive three-pass log-softmax of a (outer, n, inner) view of the input
+Tensor referenceLogSoftmax(const Tensor &input, size_t axis) {
+  Tensor result(input.shape());
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    array_t j = idx;
+    double m = input[idx];
+    for (j[axis] = 0; j[axis] < input.shape()[axis]; ++j[axis]) {
+      m = std::max(m, input[j]);
+    }
+    double s = 0;
+    for (j[axis] = 0; j[axis] < input.shape()[axis]; ++j[axis]) {
+      s += std::exp(input[j] - m);
+    }
+    val = input[idx] - m - std::log(s);
+  }
+  return result;
+}
+
+void checkSoftmax(const Tensor &input, size_t axis) {
+  Tensor expected = referenceLogSoftmax(input, axis);
+  Tensor logResult = logSoftmax(input, axis);
+  Tensor result = softmax(input, axis);
+  ASSERT_EQ(result.shape(), input.shape());
+  ASSERT_EQ(logResult.shape(), input.shape());
+  for (const auto &[idx, val] : ITensorIter(expected)) {
+    EXPECT_NEAR(logResult[idx], val, 1e-12) << "idx: " << idx;
+    EXPECT_NEAR(result[idx], std::exp(val), 1e-14) << "idx: " << idx;
+  }
+}
+
+} // namespace
+
+TEST(SoftmaxTest, LastAxis) {
+  checkSoftmax(pseudoRandom({3, 5}, 0.1), 1);
+  // rows spanning several blocks with an increasing maximum
+  Tensor input = pseudoRandom({2, 600}, 0.2);
+  for (size_t i = 0; i < 600; ++i) {
+    input[{1, i}] += 0.01 * static_cast<double>(i);
+  }
+  checkSoftmax(input, 1);
+}
+
+TEST(SoftmaxTest, InnerAxis) {
+  checkSoftmax(pseudoRandom({3, 4, 5}, 0.3), 0);
+  checkSoftmax(pseudoRandom({3, 4, 5}, 0.4), 1);
+  checkSoftmax(pseudoRandom({2, 3, 300}, 0.5), 1);
+}
+
+TEST(SoftmaxTest, Strided) {
+  Tensor input = pseudoRandom({4, 6}, 0.6);
+  const Tensor transposed = permute(input, {1, 0});
+  checkSoftmax(transposed, 1);
+}
+
+TEST(SoftmaxTest, Stable) {
+  Tensor input(array_t{2, 3});
+  for (size_t i = 0; i < 3; ++i) {
+    input[{0, i}] = 1000 + static_cast<double>(i);
+    input[{1, i}] = -1000 - static_cast<double>(i);
+  }
+  Tensor expected = softmax(Tensor::range(3), 0);
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_NEAR((softmax(input, 1)[{0, i}]), expected[i], 1e-15);
+    EXPECT_NEAR((softmax(input, 1)[{1, i}]), expected[2 - i], 1e-15);
+  }
+  // the log-softmax of an underflowing probability stays finite
+  input[{0, 0}] = -1000;
+  EXPECT_NEAR((logSoftmax(input, 1)[{0, 0}]), -2002 - std::log1p(std::exp(-1)),
+              1e-9);
+}
+
+TEST(SoftmaxTest, Empty) {
+  // empty reduction axis, and empty outer and inner extents
+  for (const array_t &shape :
+       {array_t{3, 0}, array_t{0, 4}, array_t{2, 3, 0}}) {
+    for (size_t axis = 0; axis < shape.size(); ++axis) {
+      EXPECT_EQ(softmax(Tensor(shape), axis).shape(), shape);
+      EXPECT_EQ(logSoftmax(Tensor(shape), axis).shape(), shape);
+    }
+  }
+}
+
+TEST(SoftmaxTest, Invalid) {
+  EXPECT_THROW(softmax(pseudoRandom({2, 3}, 0.7), 2), std::invalid_argument);
+}
@@ -0,0 +1,117 @@
+#include <cmath>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/iter.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/sparse.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+
+namespace {
+
+// zeroes elements of magnitude at most the threshold
+Tensor prune(const Tensor &tensor, double threshold) {
+  Tensor result(tensor);
+  for (const auto &[val] : TensorIter(result)) {
+    val = std::abs(val) > threshold ? val : 0.0;
+  }
+  return result;
+}
+
+void checkProducts(const SparseMatrix &sparse, const Tensor &dense) {
+  const size_t cols = dense.shape()[1];
+  Tensor vector = pseudoRandom({cols}, 0.8);
+  expectNear(dot(sparse, vector), dot(dense, vector));
+  Tensor matrix = pseudoRandom({cols, 5}, 0.9);
+  expectNear(dot(sparse, matrix), dot(dense, matrix));
+  Tensor batch = pseudoRandom({cols, 3, 2}, 1.1);
+  expectNear(dot(sparse, batch), dot(dense, batch));
+  // strided input
+  Tensor base = pseudoRandom({4, cols}, 1.2);
+  Tensor transposed = permute(base, {1, 0});
+  expectNear(dot(sparse, transposed), dot(dense, transposed));
+}
+
+} // namespace
+
+TEST(SparseTest, Csr) {
+  Tensor weights = pseudoRandom({13, 17}, 0.1);
+  SparseMatrix sparse = SparseMatrix::fromDense(weights, 0.8);
+  Tensor pruned = prune(weights, 0.8);
+  EXPECT_EQ(sparse.toDense(), pruned);
+  EXPECT_EQ(sparse.rows(), 13);
+  EXPECT_EQ(sparse.cols(), 17);
+  EXPECT_EQ(sparse.blocks(), sparse.storedElements());
+  EXPECT_LT(sparse.storedElements(), weights.size() / 2);
+  checkProducts(sparse, pruned);
+
+  // exact zeros are dropped by default
+  Tensor identity = Tensor::fill({4, 4}, 0);
+  for (size_t i = 0; i < 4; ++i) {
+    identity[{i, i}] = 2;
+  }
+  SparseMatrix diagonal = SparseMatrix::fromDense(identity);
+  EXPECT_EQ(diagonal.storedElements(), 4);
+  EXPECT_EQ(diagonal.toDense(), identity);
+}
+
+TEST(SparseTest, Bsr) {
+  // blocks on the last block row and column extend past the matrix
+  Tensor weights = pseudoRandom({14, 19}, 0.2);
+  for (size_t bs = 1; bs <= 4; bs *= 2) {
+    SparseMatrix sparse = SparseMatrix::fromDense(weights, bs, bs + 1, 0.9);
+    Tensor pruned = prune(weights, 0.9);
+    EXPECT_EQ(sparse.toDense(), pruned);
+    EXPECT_EQ(sparse.storedElements(), sparse.blocks() * bs * (bs + 1));
+    checkProducts(sparse, pruned);
+  }
+
+  // a matrix pruned in blocks stores only the remaining blocks
+  Tensor blocked = pseudoRandom({8, 8}, 0.3);
+  for (const auto &[idx, val] : ITensorIter(blocked)) {
+    if ((idx[0] / 4 + idx[1] / 4) % 2 == 1) {
+      val = 0;
+    }
+  }
+  SparseMatrix sparse = SparseMatrix::fromDense(blocked, 4, 4);
+  EXPECT_EQ(sparse.blocks(), 2);
+  EXPECT_EQ(sparse.storedElements(), 32);
+  EXPECT_LT(sparse.bytes(), blocked.size() * sizeof(double));
+  checkProducts(sparse, blocked);
+
+  Tensor empty = Tensor::fill({6, 3}, 0);
+  SparseMatrix zero = SparseMatrix::fromDense(empty, 2, 2);
+  EXPECT_EQ(zero.blocks(), 0);
+  EXPECT_EQ(dot(zero, pseudoRandom({3, 2}, 0.4)), Tensor::fill({6, 2}, 0));
+}
+
+TEST(SparseTest, Parallel) {
+  Tensor weights = prune(pseudoRandom({300, 256}, 0.5), 0.95);
+  SparseMatrix csr = SparseMatrix::fromDense(weights);
+  SparseMatrix bsr = SparseMatrix::fromDense(weights, 4, 4);
+  Tensor vector = pseudoRandom({256}, 0.6);
+  Tensor batch = pseudoRandom({256, 64}, 0.7);
+  setNumThreads(4);
+  expectNear(dot(csr, vector), dot(weights, vector));
+  expectNear(dot(bsr, vector), dot(weights, vector));
+  expectNear(dot(csr, batch), dot(weights, batch));
+  expectNear(dot(bsr, batch), dot(weights, batch));
+  setNumThreads(0);
+}
+
+TEST(SparseTest, Invalid) {
+  EXPECT_THROW(SparseMatrix::fromDense(Tensor({2, 3, 4})),
+               std::invalid_argument);
+  EXPECT_THROW(SparseMatrix::fromDense(Tensor({4})), std::invalid_argument);
+  EXPECT_THROW(SparseMatrix::fromDense(Tensor({4, 4}), 0, 2),
+               std::invalid_argument);
+  SparseMatrix sparse = SparseMatrix::fromDense(pseudoRandom({3, 4}, 0.1));
+  EXPECT_THROW(dot(sparse, Tensor({3})), std::invalid_argument);
+  EXPECT_THROW(dot(sparse, Tensor({3, 4})), std::invalid_argument);
+  EXPECT_THROW(dot(sparse, Tensor(1.0)), std::invalid_argument);
+}
@@ -1,3 +1,5 @@
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "gradstudent/ops.h"
@@ -174,3 +176,112 @@ TEST(TruncateTest, MatrixElems) {
   slice(expected, {1}) = Tensor::range(10, 12);
   EXPECT_EQ(truncated, expected);
 }
+
+TEST(ReshapeTest, MergeContiguous) {
+  Tensor tensor = Tensor::range(24).reshape({2, 3, 4});
+  // slicing the last axis keeps the first two mergeable
+  Tensor truncated = truncate(tensor, {0, 0, 1}, {2, 3, 3});
+  bool copied = true;
+  Tensor reshaped = truncated.reshape({6, 2}, copied);
+  EXPECT_FALSE(copied);
+  EXPECT_EQ(reshaped.strides(), array_t({4, 1}));
+  for (size_t i = 0; i < 6; ++i) {
+    for (size_t j = 0; j < 2; ++j) {
+      EXPECT_EQ((reshaped[{i, j}]), 4 * i + j + 1);
+    }
+  }
+
+  // writes go through to the original tensor
+  reshaped[{5, 1}] = -1;
+  EXPECT_EQ((tensor[{1, 2, 2}]), -1);
+}
+
+TEST(ReshapeTest, SplitStrided) {
+  Tensor matrix = Tensor::range(12).reshape({3, 4});
+  Tensor perm = permute(matrix, {1, 0});
+  bool copied = true;
+  Tensor reshaped = perm.reshape({2, 2, 3}, copied);
+  EXPECT_FALSE(copied);
+  EXPECT_EQ(reshaped.strides(), array_t({2, 1, 4}));
+  EXPECT_EQ((reshaped[{1, 0, 2}]), (perm[{2, 2}]));
+}
+
+TEST(ReshapeTest, UnitDims) {
+  Tensor matrix = Tensor::range(6).reshape({2, 3});
+  Tensor perm = permute(matrix, {1, 0});
+  bool copied = true;
+  Tensor reshaped = perm.reshape({1, 3, 1, 2, 1}, copied);
+  EXPECT_FALSE(copied);
+  EXPECT_EQ((reshaped[{0, 2, 0, 1, 0}]), 5);
+}
+
+TEST(ReshapeTest, Scalar) {
+  Tensor tensor = Tensor::fill({1, 1}, 3);
+  bool copied = true;
+  Tensor scalar = tensor.reshape(array_t(), copied);
+  EXPECT_FALSE(copied);
+  EXPECT_EQ(scalar.ndims(), 0);
+  EXPECT_EQ(static_cast<double>(scalar), 3);
+}
+
+TEST(ReshapeTest, NonContiguousCopies) {
+  Tensor matrix = Tensor::range(6).reshape({2, 3});
+  Tensor perm = permute(matrix, {1, 0});
+  bool copied = false;
+  Tensor reshaped = perm.reshape({6}, copied);
+  EXPECT_TRUE(copied);
+  EXPECT_EQ(reshaped.strides(), array_t({1}));
+  double expected[] = {0, 3, 1, 4, 2, 5};
+  for (size_t i = 0; i < 6; ++i) {
+    EXPECT_EQ(reshaped[i], expected[i]);
+  }
+  reshaped[0] = 10;
+  EXPECT_EQ(matrix[0], 0);
+}
+
+TEST(ReshapeTest, WrongSize) {
+  Tensor matrix = Tensor::range(6).reshape({2, 3});
+  EXPECT_THROW(matrix.reshape({4}), std::invalid_argument);
+}
+
+TEST(SplitTest, Parts) {
+  Tensor matrix = Tensor::range(12).reshape({3, 4});
+  std::vector<Tensor> parts = split(matrix, {1, 0, 3}, 1);
+  ASSERT_EQ(parts.size(), 3);
+  EXPECT_EQ(parts[0].shape(), array_t({3, 1}));
+  EXPECT_EQ(parts[1].shape(), array_t({3, 0}));
+  EXPECT_EQ(parts[2].shape(), array_t({3, 3}));
+  EXPECT_EQ((parts[2][{2, 0}]), 9);
+
+  // parts are views, so writes land in the original tensor
+  parts[2] = Tensor::fill({3, 3}, -1);
+  parts[0] = Tensor::fill({3, 1}, -2);
+  EXPECT_EQ((matrix[{1, 0}]), -2);
+  EXPECT_EQ((matrix[{1, 3}]), -1);
+}
+
+TEST(SplitTest, Const) {
+  const Tensor matrix = Tensor::range(6).reshape({3, 2});
+  std::vector<Tensor> parts = split(matrix, {2, 1}, 0);
+  EXPECT_EQ((parts[1][{0, 1}]), 5);
+  parts[1] = Tensor::fill({1, 2}, 0);
+  EXPECT_EQ((matrix[{2, 1}]), 5);
+}
+
+TEST(SplitTest, Invalid) {
+  Tensor matrix = Tensor::range(6).reshape({3, 2});
+  EXPECT_THROW(split(matrix, {1, 1}, 0), std::invalid_argument);
+  EXPECT_THROW(split(matrix, {2}, 2), std::invalid_argument);
+}
+
+TEST(UnstackTest, Slices) {
+  Tensor tensor = Tensor::range(24).reshape({2, 3, 4});
+  std::vector<Tensor> slices = unstack(tensor, 1);
+  ASSERT_EQ(slices.size(), 3);
+  EXPECT_EQ(slices[1].shape(), array_t({2, 4}));
+  EXPECT_EQ((slices[1][{1, 2}]), (tensor[{1, 1, 2}]));
+  slices[2] = Tensor::fill({2, 4}, -1);
+  EXPECT_EQ((tensor[{0, 2, 3}]), -1);
+  EXPECT_EQ((tensor[{0, 1, 3}]), 7);
+  EXPECT_THROW(unstack(tensor, 3), std::invalid_argument);
+}
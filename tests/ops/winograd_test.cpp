@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include "gradstudent/internal/conv.h"
+#include "gradstudent/iter.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+
+namespace {
+
+void checkWinograd(size_t height, size_t width, size_t channels,
+                   size_t filters) {
+  Tensor input = pseudoRandom({height, width, channels}, 0.1);
+  Tensor kernel = pseudoRandom({filters, 3, 3, channels}, 0.2);
+  ASSERT_TRUE(winogradApplicable(input, kernel, 2));
+
+  Tensor result = winogradConv(input, kernel);
+  ASSERT_EQ(result.shape(), (array_t{filters, height - 2, width - 2}));
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    EXPECT_NEAR(val,
+                directConv(input, slice(kernel, {idx[0]}), idx[1], idx[2]),
+                1e-12)
+        << "idx: " << idx;
+  }
+}
+
+} // namespace
+
+TEST(WinogradTest, SmallTiles) { checkWinograd(7, 6, 3, 2); }
+
+TEST(WinogradTest, LargeTiles) { checkWinograd(19, 13, 2, 3); }
+
+TEST(WinogradTest, SingleKernel) {
+  Tensor input = pseudoRandom({12, 11}, 0.3);
+  Tensor kernel = pseudoRandom({3, 3}, 0.4);
+  Tensor result = conv(input, kernel);
+  ASSERT_EQ(result.shape(), (array_t{10, 9}));
+  for (const auto &[idx, val] : ITensorIter(result)) {
+    double expected = 0;
+    for (size_t i = 0; i < 3; ++i) {
+      for (size_t j = 0; j < 3; ++j) {
+        expected += input[{idx[0] + i, idx[1] + j}] * kernel[{i, j}];
+      }
+    }
+    EXPECT_NEAR(val, expected, 1e-12);
+  }
+}
+
+TEST(WinogradTest, CachedFilters) {
+  Tensor input = pseudoRandom({10, 10, 2}, 0.5);
+  Tensor kernel = pseudoRandom({2, 3, 3, 2}, 0.6);
+  Tensor first = winogradConv(input, kernel);
+  Tensor second = winogradConv(input, kernel);
+  EXPECT_EQ(first, second);
+
+  // a modified kernel must not hit the cache
+  kernel[0] += 1;
+  Tensor third = winogradConv(input, kernel);
+  EXPECT_NEAR((third[{0, 0, 0}] - first[{0, 0, 0}]), input[0], 1e-12);
+}
+
+TEST(WinogradTest, NotApplicable) {
+  Tensor input({8, 8, 2});
+  EXPECT_FALSE(winogradApplicable(input, Tensor({5, 5, 2}), 2));
+  EXPECT_FALSE(winogradApplicable(input, Tensor({3, 3, 1}), 2));
+  EXPECT_FALSE(winogradApplicable(input, Tensor({3, 3, 2}), 3));
+}
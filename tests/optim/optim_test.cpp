@@ -0,0 +1,175 @@
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/internal/parallel.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/optim.h"
+#include "gradstudent/tensor.h"
+#include "test_utils.h"
+
+using namespace gs;
+using namespace gs::optim;
+
+namespace {
+
+// parameters of odd sizes, including one spanning several chunks
+std::vector<array_t> shapes{{3, 5}, {7}, {1}, {150, 151}};
+
+struct Model {
+  std::vector<Tensor> params;
+  std::vector<Tensor> grads;
+
+  Model() {
+    for (size_t i = 0; i < shapes.size(); ++i) {
+      params.push_back(pseudoRandom(shapes[i], 0.1 * static_cast<double>(i)));
+      grads.push_back(Tensor::fill(shapes[i], 0));
+    }
+  }
+
+  std::vector<Tensor *> paramPtrs() {
+    std::vector<Tensor *> result;
+    for (Tensor &param : params) {
+      result.push_back(&param);
+    }
+    return result;
+  }
+
+  std::vector<Tensor *> gradPtrs() {
+    std::vector<Tensor *> result;
+    for (Tensor &grad : grads) {
+      result.push_back(&grad);
+    }
+    return result;
+  }
+
+  // sets the gradients for the given step
+  void setGrads(size_t step) {
+    for (size_t i = 0; i < grads.size(); ++i) {
+      grads[i] =
+          pseudoRandom(grads[i].shape(), 1.3 * static_cast<double>(step));
+    }
+  }
+};
+
+// reference SGD, composed of tensor operations
+void referenceSGD(Model &model, std::vector<Tensor> &velocity,
+                  const SGDOptions &o) {
+  for (size_t i = 0; i < model.params.size(); ++i) {
+    Tensor &p = model.params[i];
+    Tensor g = model.grads[i] + o.weightDecay * p;
+    Tensor d = g;
+    if (o.momentum != 0) {
+      velocity[i] = o.momentum * velocity[i] + g;
+      d = o.nesterov ? g + o.momentum * velocity[i] : velocity[i];
+    }
+    p = p - o.lr * d;
+  }
+}
+
+// reference Adam, evaluated element by element
+void referenceAdam(Model &model, std::vector<Tensor> &m, std::vector<Tensor> &v,
+                   const AdamOptions &o, size_t step) {
+  auto t = static_cast<double>(step);
+  double stepSize = o.lr / (1 - std::pow(o.beta1, t));
+  double scale = 1 / std::sqrt(1 - std::pow(o.beta2, t));
+  for (size_t i = 0; i < model.params.size(); ++i) {
+    for (size_t j = 0; j < model.params[i].size(); ++j) {
+      double g = model.grads[i][j];
+      m[i][j] = o.beta1 * m[i][j] + (1 - o.beta1) * g;
+      v[i][j] = o.beta2 * v[i][j] + (1 - o.beta2) * (g * g);
+      double denom = std::sqrt(v[i][j]) * scale + o.eps;
+      model.params[i][j] = (1 - o.lr * o.weightDecay) * model.params[i][j] -
+                           stepSize * (m[i][j] / denom);
+    }
+  }
+}
+
+void expectParamsEqual(const Model &result, const Model &expected) {
+  for (size_t i = 0; i < result.params.size(); ++i) {
+    for (size_t j = 0; j < result.params[i].size(); ++j) {
+      EXPECT_DOUBLE_EQ(result.params[i][j], expected.params[i][j])
+          << "i: " << i << ", j: " << j;
+    }
+  }
+}
+
+void checkSGD(const SGDOptions &options) {
+  Model model;
+  Model expected;
+  std::vector<Tensor> velocity;
+  for (const array_t &shape : shapes) {
+    velocity.push_back(Tensor::fill(shape, 0));
+  }
+  SGD sgd(model.paramPtrs(), model.gradPtrs(), options);
+  for (size_t step = 0; step < 3; ++step) {
+    model.setGrads(step);
+    expected.setGrads(step);
+    sgd.step();
+    referenceSGD(expected, velocity, options);
+  }
+  EXPECT_EQ(sgd.steps(), 3);
+  expectParamsEqual(model, expected);
+}
+
+void checkAdam(const AdamOptions &options) {
+  Model model;
+  Model expected;
+  std::vector<Tensor> m;
+  std::vector<Tensor> v;
+  for (const array_t &shape : shapes) {
+    m.push_back(Tensor::fill(shape, 0));
+    v.push_back(Tensor::fill(shape, 0));
+  }
+  Adam adam(model.paramPtrs(), model.gradPtrs(), options);
+  for (size_t step = 1; step <= 3; ++step) {
+    model.setGrads(step);
+    expected.setGrads(step);
+    adam.step();
+    referenceAdam(expected, m, v, options, step);
+  }
+  expectParamsEqual(model, expected);
+}
+
+} // namespace
+
+TEST(OptimTest, SGD) {
+  checkSGD({0.1, 0, 0, false});
+  checkSGD({0.1, 0.9, 0.01, false});
+  checkSGD({0.05, 0.8, 0, true});
+}
+
+TEST(OptimTest, Adam) {
+  checkAdam(AdamOptions{});
+  checkAdam({0.01, 0.8, 0.99, 1e-6, 0.1});
+}
+
+TEST(OptimTest, Parallel) {
+  setNumThreads(4);
+  checkSGD({0.1, 0.9, 0.01, true});
+  checkAdam(AdamOptions{});
+  setNumThreads(0);
+}
+
+TEST(OptimTest, ZeroGrad) {
+  Model model;
+  model.setGrads(1);
+  SGD sgd(model.paramPtrs(), model.gradPtrs());
+  sgd.zeroGrad();
+  for (const Tensor &grad : model.grads) {
+    EXPECT_EQ(grad, Tensor::fill(grad.shape(), 0));
+  }
+}
+
+TEST(OptimTest, Invalid) {
+  Tensor param = Tensor::fill({2, 3}, 1);
+  Tensor grad = Tensor::fill({3, 2}, 0);
+  Tensor transposed = permute(grad, {1, 0});
+  const Tensor constant = Tensor::fill({2, 3}, 1);
+  Tensor view = constant.reshape({2, 3});
+  EXPECT_THROW(SGD({&param}, {}), std::invalid_argument);
+  EXPECT_THROW(SGD({&param}, {&grad}), std::invalid_argument);
+  EXPECT_THROW(Adam({&param}, {&transposed}), std::invalid_argument);
+  EXPECT_THROW(Adam({&view}, {&param}), std::invalid_argument);
+}
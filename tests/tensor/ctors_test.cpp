@@ -1,3 +1,6 @@
+#include <memory>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "gradstudent/tensor.h"
@@ -56,3 +59,24 @@ TEST(CtorsTest, View) {
   t2[0] = 0;
   EXPECT_EQ(t1[0], 0);
 }
+
+TEST(CtorsTest, External) {
+  bool deleted = false;
+  std::vector<double> buffer{1, 2, 3, 4, 5, 6};
+  {
+    Tensor t({2, 3}, std::shared_ptr<double[]>(
+                         buffer.data(), [&](double *) { deleted = true; }));
+    EXPECT_EQ(t.strides(), array_t({3, 1}));
+    EXPECT_EQ((t[{1, 2}]), 6);
+
+    // writes go to the buffer, and views keep it alive
+    Tensor view = t.reshape({6});
+    t[0] = 0;
+    EXPECT_EQ(buffer[0], 0);
+    Tensor copy = t;
+    copy[1] = 0;
+    EXPECT_EQ(buffer[1], 2);
+    EXPECT_FALSE(deleted);
+  }
+  EXPECT_TRUE(deleted);
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#include "gradstudent/ops.h"
+#include "gradstudent/span.h"
+#include "gradstudent/tensor.h"
+
+using namespace gs;
+
+TEST(SpanTest, Read) {
+  const Tensor matrix = Tensor::range(6).reshape({2, 3});
+  auto span = makeSpan<2>(matrix);
+  EXPECT_EQ(span.extent(0), 2);
+  EXPECT_EQ(span.extent(1), 3);
+  EXPECT_EQ(span.size(), 6);
+  EXPECT_TRUE(span.contiguous());
+  for (size_t i = 0; i < 2; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      EXPECT_EQ(span(i, j), (matrix[{i, j}]));
+      EXPECT_EQ((span[{i, j}]), (matrix[{i, j}]));
+    }
+  }
+}
+
+TEST(SpanTest, Permuted) {
+  Tensor matrix = Tensor::range(6).reshape({2, 3});
+  Tensor perm = permute(matrix, {1, 0});
+  auto span = makeSpan<2>(perm);
+  EXPECT_FALSE(span.contiguous());
+  EXPECT_EQ(span.stride(0), 1);
+  EXPECT_EQ(span.stride(1), 3);
+  EXPECT_EQ(span(2, 1), 5);
+
+  // writes go through to the viewed tensor
+  span(2, 1) = 10;
+  EXPECT_EQ((matrix[{1, 2}]), 10);
+}
+
+TEST(SpanTest, CopyOnWrite) {
+  const Tensor matrix = Tensor::range(6).reshape({2, 3});
+  Tensor sliced = slice(matrix, {1});
+  auto span = makeSpan<1>(sliced);
+  span(0) = 10;
+  EXPECT_EQ(sliced[0], 10);
+  EXPECT_EQ((matrix[{1, 0}]), 3);
+}
+
+TEST(SpanTest, WrongRank) {
+  Tensor matrix({2, 3});
+  EXPECT_THROW(makeSpan<3>(matrix), std::invalid_argument);
+}
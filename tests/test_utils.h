@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/iter.h"
+#include "gradstudent/tensor.h"
+
+// Deterministic test data: the sines of an arithmetic progression starting at
+// the seed, in row-major order
+inline gs::Tensor pseudoRandom(const gs::array_t &shape, double seed) {
+  gs::Tensor result(shape);
+  double x = seed;
+  for (const auto &[val] : gs::TensorIter(result)) {
+    val = std::sin(x);
+    x += 0.7;
+  }
+  return result;
+}
+
+// As pseudoRandom, for a raw buffer of n elements
+inline std::vector<double> pseudoRandomVector(size_t n, double seed) {
+  std::vector<double> result(n);
+  double x = seed;
+  for (double &v : result) {
+    v = std::sin(x);
+    x += 0.7;
+  }
+  return result;
+}
+
+// Expects tensors of the same shape whose elements agree to within 1e-12
+inline void expectNear(const gs::Tensor &actual, const gs::Tensor &expected) {
+  ASSERT_EQ(actual.shape(), expected.shape());
+  for (const auto &[idx, val] : gs::ITensorIter(actual)) {
+    EXPECT_NEAR(val, expected[idx], 1e-12) << "idx: " << idx;
+  }
+}
+
+// Direct convolution of a (h, w, c) input with a (kh, kw, c) kernel, at
+// output position (y, x)
+inline double directConv(const gs::Tensor &input, const gs::Tensor &kernel,
+                         size_t y, size_t x) {
+  double result = 0;
+  for (size_t i = 0; i < kernel.shape()[0]; ++i) {
+    for (size_t j = 0; j < kernel.shape()[1]; ++j) {
+      for (size_t c = 0; c < input.shape()[2]; ++c) {
+        result += input[{y + i, x + j, c}] * kernel[{i, j, c}];
+      }
+    }
+  }
+  return result;
+}
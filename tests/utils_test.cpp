@@ -1,6 +1,10 @@
+#include <stdexcept>
+
 #include <gtest/gtest.h>
 
 #include "gradstudent/internal/utils.h"
+#include "gradstudent/ops.h"
+#include "gradstudent/tensor.h"
 
 using namespace gs;
 
@@ -108,3 +112,17 @@ TEST(BroadcastShapesTest, MaskMixed) {
             std::vector<int>({BCAST_RIGHT, BCAST_NONE, BCAST_RIGHT, BCAST_NONE,
                               BCAST_LEFT}));
 }
+
+TEST(MutableDataTest, Writable) {
+  Tensor tensor = Tensor::fill({2, 3}, 0);
+  mutableData(tensor)[4] = 1; // NOLINT(*-pointer-arithmetic)
+  EXPECT_EQ((tensor[{1, 1}]), 1);
+}
+
+TEST(MutableDataTest, Invalid) {
+  const Tensor matrix = Tensor::fill({2, 3}, 0);
+  Tensor row = slice(matrix, {0});
+  EXPECT_THROW(mutableData(row), std::invalid_argument);
+  Tensor transposed = permute(Tensor::fill({2, 3}, 0), {1, 0});
+  EXPECT_THROW(mutableData(transposed), std::invalid_argument);
+}
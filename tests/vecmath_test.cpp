@@ -0,0 +1,111 @@
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gradstudent/internal/vecmath.h"
+
+using namespace gs;
+
+namespace {
+
+using Kernel = void (*)(const double *, double *, size_t);
+using Reference = std::function<long double(long double)>;
+
+constexpr double inf = std::numeric_limits<double>::infinity();
+constexpr double qnan = std::numeric_limits<double>::quiet_NaN();
+
+// error of actual in units in the last place of the rounded reference
+double ulpError(double actual, long double expected) {
+  double rounded = static_cast<double>(expected);
+  if (actual == rounded) {
+    return 0;
+  }
+  double magnitude = std::fabs(rounded);
+  double ulp = std::nextafter(magnitude, inf) - magnitude;
+  return static_cast<double>(std::fabs(actual - expected) / ulp);
+}
+
+// checks the kernel against the reference on n evenly spaced points in
+// [lo, hi], using an odd n so that the scalar tail is exercised
+void checkUlp(Kernel kernel, const Reference &reference, double lo, double hi,
+              double bound) {
+  const size_t n = 20001;
+  std::vector<double> in(n);
+  std::vector<double> out(n);
+  for (size_t i = 0; i < n; ++i) {
+    in[i] = lo + (hi - lo) * static_cast<double>(i) / (n - 1);
+  }
+  kernel(in.data(), out.data(), n);
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_LE(ulpError(out[i], reference(in[i])), bound) << "x: " << in[i];
+  }
+}
+
+std::vector<double> apply(Kernel kernel, std::vector<double> in) {
+  kernel(in.data(), in.data(), in.size());
+  return in;
+}
+
+long double sigmoid(long double x) { return 1 / (1 + std::exp(-x)); }
+
+long double gelu(long double x) {
+  long double z = 1.59576912160573071176L * (x + 0.044715L * x * x * x);
+  return x * sigmoid(z);
+}
+
+} // namespace
+
+TEST(VecMathTest, Exp) {
+  auto reference = [](long double x) { return std::exp(x); };
+  checkUlp(vecExp, reference, -745, 709.7, 1);
+  checkUlp(vecExp, reference, -1, 1, 1);
+
+  auto out = apply(vecExp, {0, -inf, inf, 710, -746, -1e-300});
+  EXPECT_EQ(out, (std::vector<double>{1, 0, inf, inf, 0, 1}));
+  EXPECT_TRUE(std::isnan(apply(vecExp, {qnan})[0]));
+}
+
+TEST(VecMathTest, Log) {
+  auto reference = [](long double x) { return std::log(x); };
+  checkUlp(vecLog, reference, 0.5, 2, 1);
+  checkUlp(vecLog, reference, 1e-3, 1e3, 1);
+  checkUlp(vecLog, reference, 1e-320, 1e-300, 1);
+  checkUlp(vecLog, reference, 1e300, 1e308, 1);
+
+  auto out = apply(vecLog, {1, 0, inf});
+  EXPECT_EQ(out, (std::vector<double>{0, -inf, inf}));
+  EXPECT_TRUE(std::isnan(apply(vecLog, {-1})[0]));
+  EXPECT_TRUE(std::isnan(apply(vecLog, {qnan})[0]));
+}
+
+TEST(VecMathTest, Tanh) {
+  auto reference = [](long double x) { return std::tanh(x); };
+  checkUlp(vecTanh, reference, -25, 25, 3);
+  checkUlp(vecTanh, reference, -1e-6, 1e-6, 3);
+
+  auto out = apply(vecTanh, {0, -inf, inf, 1e-300});
+  EXPECT_EQ(out, (std::vector<double>{0, -1, 1, 1e-300}));
+  EXPECT_TRUE(std::signbit(apply(vecTanh, {-0.0})[0]));
+}
+
+TEST(VecMathTest, Sigmoid) {
+  checkUlp(vecSigmoid, sigmoid, -40, 40, 3);
+  checkUlp(vecSigmoid, sigmoid, -740, -40, 3);
+
+  auto out = apply(vecSigmoid, {0, -inf, inf, 800});
+  EXPECT_EQ(out, (std::vector<double>{0.5, 0, 1, 1}));
+}
+
+TEST(VecMathTest, Gelu) {
+  checkUlp(vecGelu, gelu, -1, 30, 4);
+  for (double x : {-2.0, -5.0, -10.0, -20.0}) {
+    double z = 1.59576912160573071176 * (x + 0.044715 * x * x * x);
+    checkUlp(vecGelu, gelu, x, x + 1, 4 * std::fabs(z));
+  }
+
+  auto out = apply(vecGelu, {0, -inf, inf});
+  EXPECT_EQ(out, (std::vector<double>{0, 0, inf}));
+}